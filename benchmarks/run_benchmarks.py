@@ -0,0 +1,279 @@
+"""Performance benchmarks for the binding hot paths.
+
+This script is run by `meson test --benchmark` (see `make benchmark`), or directly:
+
+    python benchmarks/run_benchmarks.py [--output results.json] [--baseline FILE]
+        [--save-baseline] [--tolerance 0.2] [--strict] [--quick]
+
+It runs the native microbenchmarks compiled into `_pymmcore_nano._benchmarks` and a set of
+Python-level benchmarks against a camera (the built-in synthetic camera, or the demo adapters in
+tests/adapters when the synthetic camera is unavailable).  Results are written as JSON and
+compared against a stored baseline; a result is a regression if it is worse than the baseline by
+more than the tolerance.  The baseline is machine-specific and not committed (it is git-ignored);
+record one locally with --save-baseline.
+"""
+
+from __future__ import annotations
+
+import argparse
+import datetime
+import json
+import platform
+import statistics
+import sys
+import time
+from collections.abc import Callable
+from pathlib import Path
+
+import numpy as np
+
+import pymmcore_nano as pmn
+
+ROOT = Path(__file__).parent.parent
+DEFAULT_BASELINE = Path(__file__).parent / "baseline.json"
+
+
+class Results:
+    def __init__(self) -> None:
+        self.results: dict[str, dict] = {}
+
+    def add(
+        self, name: str, value: float, unit: str, higher_is_better: bool = False
+    ) -> None:
+        self.results[name] = {
+            "value": value,
+            "unit": unit,
+            "higher_is_better": higher_is_better,
+        }
+        print(f"  {name:<40} {value:>14.3f} {unit}")
+
+
+def _median_us(fn: Callable[[], object], repeat: int) -> float:
+    fn()  # warm-up
+    samples = []
+    for _ in range(repeat):
+        t0 = time.perf_counter_ns()
+        fn()
+        samples.append(time.perf_counter_ns() - t0)
+    return statistics.median(samples) / 1000
+
+
+def _make_core() -> pmn.CMMCore | None:
+    core = pmn.CMMCore()
+    try:
+        core.loadSyntheticCamera("Camera")
+        core.setProperty("Camera", "Width", 512)
+        core.setProperty("Camera", "Height", 512)
+        core.setProperty("Camera", "PixelType", "16bit")
+        core.setProperty("Camera", "FrameRateHz", 0)  # as fast as possible
+        core.setProperty("Camera", "Exposure", 0)  # snaps return immediately
+        return core
+    except RuntimeError:
+        pass
+    adapters = ROOT / "tests" / "adapters" / sys.platform
+    if not adapters.is_dir():
+        return None
+    core.setDeviceAdapterSearchPaths([str(adapters)])
+    core.loadSystemConfiguration(ROOT / "tests" / "MMConfig_demo.cfg")
+    return core
+
+
+def bench_native(res: Results, core: pmn.CMMCore, n: int) -> None:
+    bench = pmn._benchmarks
+    res.add("native.get_dtype_shape", bench.get_dtype_shape(n * 10), "ns")
+    res.add("native.create_image_array", bench.create_image_array(core, n), "ns")
+    res.add("native.create_metadata_array", bench.create_metadata_array(core, n), "ns")
+    for tags in (8, 64):
+        res.add(
+            f"native.metadata_copy[{tags}]", bench.metadata_copy(core, tags, n), "ns"
+        )
+
+
+def bench_snap(res: Results, core: pmn.CMMCore, repeat: int) -> None:
+    def snap() -> None:
+        core.snapImage()
+        core.getImage()
+
+    res.add("snap_get_image", _median_us(snap, repeat), "us")
+
+
+def _fill_buffer(core: pmn.CMMCore, count: int) -> None:
+    core.clearCircularBuffer()
+    core.startSequenceAcquisition(count, 0, True)
+    deadline = time.perf_counter() + 30
+    while core.isSequenceRunning() and time.perf_counter() < deadline:
+        time.sleep(0.005)
+    core.stopSequenceAcquisition()
+
+
+def bench_drain(res: Results, core: pmn.CMMCore, frames: int) -> None:
+    """Drain a pre-filled buffer, so only the binding side is measured."""
+    frame_bytes = core.getImageBufferSize()
+    frames = min(frames, core.getBufferTotalCapacity())
+
+    def run(name: str, drain: Callable[[], int]) -> None:
+        _fill_buffer(core, frames)
+        available = core.getRemainingImageCount()
+        t0 = time.perf_counter()
+        popped = drain()
+        dt = time.perf_counter() - t0
+        assert popped == available, f"{name}: popped {popped} of {available} frames"
+        res.add(f"{name}.frames_per_s", popped / dt, "frames/s", higher_is_better=True)
+        res.add(f"{name}.gb_per_s", popped * frame_bytes / dt / 1e9, "GB/s", True)
+
+    def pop_md() -> int:
+        n = 0
+        while core.getRemainingImageCount():
+            core.popNextImageMD()
+            n += 1
+        return n
+
+    def pop_batch() -> int:
+        n = 0
+        while core.getRemainingImageCount():
+            n += len(core.popNextImages(64)[0])
+        return n
+
+    out = np.empty((64, core.getImageHeight(), core.getImageWidth()), np.uint16)
+
+    def pop_into() -> int:
+        n = 0
+        while core.getRemainingImageCount():
+            n += core.popNextImages(out)[0]
+        return n
+
+    run("drain.popNextImageMD", pop_md)
+    run("drain.popNextImages", pop_batch)
+    if core.getBytesPerPixel() == 2 and core.getNumberOfComponents() == 1:
+        run("drain.popNextImages_into", pop_into)
+
+
+def bench_properties(res: Results, core: pmn.CMMCore, repeat: int) -> None:
+    res.add(
+        "property.get",
+        _median_us(lambda: core.getProperty("Camera", "Exposure"), repeat),
+        "us",
+    )
+    values = iter([10.0, 11.0] * (repeat + 1))
+    res.add(
+        "property.set",
+        _median_us(
+            lambda: core.setProperty("Camera", "Exposure", next(values)), repeat
+        ),
+        "us",
+    )
+
+
+def bench_callbacks(
+    res: Results, core: pmn.CMMCore, repeat: int
+) -> pmn.MMEventCallback:
+    """Time from calling setExposure until the Python callback runs.
+
+    Returns the registered callback, which must outlive the core.
+    """
+    received: list[int] = []
+
+    class Callback(pmn.MMEventCallback):
+        def onExposureChanged(self, name: str, exposure: float) -> None:
+            received.append(time.perf_counter_ns())
+
+    cb = Callback()
+    core.registerCallback(cb)
+    latencies = []
+    for i in range(repeat):
+        received.clear()
+        t0 = time.perf_counter_ns()
+        core.setExposure(10.0 + i % 2)
+        if received:
+            latencies.append(received[0] - t0)
+    if latencies:
+        res.add("callback.onExposureChanged", statistics.median(latencies) / 1000, "us")
+    else:
+        print("  callback.onExposureChanged: no callbacks received, skipped")
+    return cb
+
+
+def compare(results: dict, baseline: dict, tolerance: float) -> list[str]:
+    """Return the names of results that regressed relative to `baseline`."""
+    regressions = []
+    print(f"\nComparison with baseline (tolerance {tolerance:.0%}):")
+    for name, new in results.items():
+        old = baseline.get(name)
+        if old is None or not old["value"]:
+            print(f"  {name:<40} (not in baseline)")
+            continue
+        ratio = new["value"] / old["value"]
+        # > 1 means worse, regardless of direction
+        worse = 1 / ratio if new["higher_is_better"] else ratio
+        flag = "REGRESSION" if worse > 1 + tolerance else ""
+        if flag:
+            regressions.append(name)
+        print(
+            f"  {name:<40} {old['value']:>12.3f} -> {new['value']:>12.3f} ({ratio:6.2f}x) {flag}"
+        )
+    return regressions
+
+
+def main(argv: list[str] | None = None) -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--output", type=Path, help="write results to this JSON file")
+    parser.add_argument("--baseline", type=Path, default=DEFAULT_BASELINE)
+    parser.add_argument(
+        "--save-baseline", action="store_true", help="store results as baseline"
+    )
+    parser.add_argument("--tolerance", type=float, default=0.2)
+    parser.add_argument("--strict", action="store_true", help="exit 1 on regressions")
+    parser.add_argument(
+        "--quick", action="store_true", help="fewer iterations (smoke test)"
+    )
+    args = parser.parse_args(argv)
+
+    n, repeat, frames = (1_000, 20, 100) if args.quick else (100_000, 500, 2_000)
+    res = Results()
+    core = _make_core()
+    if core is None:
+        print(f"No camera available on {sys.platform}; skipping all benchmarks.")
+        return 0
+
+    print("Benchmarks:")
+    bench_native(res, core, n)
+    bench_snap(res, core, repeat)
+    bench_drain(res, core, frames)
+    bench_properties(res, core, repeat)
+    callback = bench_callbacks(res, core, repeat)  # noqa: F841 (keeps it alive)
+
+    report = {
+        "meta": {
+            "date": datetime.datetime.now(datetime.timezone.utc).isoformat(),
+            "platform": platform.platform(),
+            "machine": platform.machine(),
+            "python": platform.python_version(),
+            "numpy": np.__version__,
+            "mmcore": core.getAPIVersionInfo(),
+            "camera": core.getDeviceLibrary(core.getCameraDevice()),
+            "quick": args.quick,
+        },
+        "results": res.results,
+    }
+    if args.output:
+        args.output.write_text(json.dumps(report, indent=2))
+    if args.save_baseline:
+        args.baseline.write_text(json.dumps(report, indent=2))
+        print(f"\nBaseline saved to {args.baseline}")
+        return 0
+
+    if not args.baseline.is_file():
+        print(
+            f"\nNo baseline at {args.baseline}; run with --save-baseline to create one."
+        )
+        return 0
+    baseline = json.loads(args.baseline.read_text())
+    regressions = compare(res.results, baseline["results"], args.tolerance)
+    if regressions:
+        print(f"\n{len(regressions)} regression(s): {', '.join(regressions)}")
+        return 1 if args.strict else 0
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,12 +1,62 @@
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/pair.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/tuple.h>
 #include <nanobind/stl/vector.h>
 #include <nanobind/trampoline.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+#include "DeviceBase.h"
 #include "MMCore.h"
 #include "MMEventCallback.h"
+// The synthetic camera needs CMMCore::loadMockDeviceAdapter; compile with
+// -DPMN_REQUIRE_MOCK_ADAPTER=0 (meson option `synthetic_camera=false`) to build without it
+#ifndef PMN_REQUIRE_MOCK_ADAPTER
+#define PMN_REQUIRE_MOCK_ADAPTER 1
+#endif
+#if __has_include("MockDeviceAdapter.h")
+#include "MockDeviceAdapter.h"
+#define PMN_HAVE_MOCK_ADAPTER 1
+#elif PMN_REQUIRE_MOCK_ADAPTER
+#error "MockDeviceAdapter.h not found: update src/mmCoreAndDevices or set synthetic_camera=false"
+#else
+#define PMN_HAVE_MOCK_ADAPTER 0
+#endif
 
 namespace nb = nanobind;
 
@@ -16,6 +66,19 @@ using namespace nb::literals;
 
 // Alias for read-only NumPy array
 using ro_np_array = nb::ndarray<nb::numpy, nb::ro>;
+// Alias for a (writable) NumPy array that owns its own memory
+using np_array = nb::ndarray<nb::numpy>;
+// Alias for a writable, caller-provided array in host memory (e.g. a NumPy array or memmap)
+using out_array = nb::ndarray<nb::device::cpu>;
+// Alias for a read-only float32 array in host memory (other dtypes are converted on the way in)
+using float_array = nb::ndarray<const float, nb::c_contig, nb::device::cpu>;
+// Alias for a read-only 1D float64 array in host memory (converted likewise)
+using double_array = nb::ndarray<const double, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+
+// Call guard that releases the GIL for the duration of a (potentially) blocking CMMCore call.
+// Use this on every binding that talks to a device, waits, or sleeps.  Anything that builds
+// Python objects (e.g. NumPy arrays) must instead release the GIL manually around the core call.
+using release_gil = nb::call_guard<nb::gil_scoped_release>;
 
 // Helper to determine dtype and shape
 std::pair<nb::dlpack::dtype, std::vector<size_t>> get_dtype_shape(unsigned height, unsigned width,
@@ -45,159 +108,5328 @@ std::pair<nb::dlpack::dtype, std::vector<size_t>> get_dtype_shape(unsigned heigh
     default:  // pragma: no cover
       throw std::runtime_error("Unsupported bytesPerPixel.");
   }
-}
-// Overload to determine dtype and shape from pixelType, which appears in image metadata
-std::pair<nb::dlpack::dtype, std::vector<size_t>> get_dtype_shape(unsigned height, unsigned width,
-                                                                  const std::string& pixelType) {
-  // These values are hard-coded in CircularBuffer.cpp
-  if (pixelType == "GRAY8") {
-    return {nb::dtype<uint8_t>(), {height, width}};
-  } else if (pixelType == "GRAY16") {
-    return {nb::dtype<uint16_t>(), {height, width}};
-  } else if (pixelType == "GRAY32") {
-    return {nb::dtype<uint32_t>(), {height, width}};
-  } else if (pixelType == "RGB32") {
-    return {nb::dtype<uint8_t>(), {height, width, 4}};
-  } else if (pixelType == "RGB64") {
-    return {nb::dtype<uint64_t>(), {height, width, 4}};
-  } else {
-    throw std::runtime_error("Unsupported pixelType.");
+}
+// Overload to determine dtype and shape from pixelType, which appears in image metadata
+std::pair<nb::dlpack::dtype, std::vector<size_t>> get_dtype_shape(unsigned height, unsigned width,
+                                                                  const std::string& pixelType) {
+  // These values are hard-coded in CircularBuffer.cpp
+  if (pixelType == "GRAY8") {
+    return {nb::dtype<uint8_t>(), {height, width}};
+  } else if (pixelType == "GRAY16") {
+    return {nb::dtype<uint16_t>(), {height, width}};
+  } else if (pixelType == "GRAY32") {
+    return {nb::dtype<uint32_t>(), {height, width}};
+  } else if (pixelType == "RGB32") {
+    return {nb::dtype<uint8_t>(), {height, width, 4}};
+  } else if (pixelType == "RGB64") {
+    return {nb::dtype<uint16_t>(), {height, width, 4}};
+  } else {
+    throw std::runtime_error("Unsupported pixelType.");
+  }
+}
+
+// Number of bytes in a C-contiguous array of the given dtype and shape
+size_t get_nbytes(nb::dlpack::dtype dt, const std::vector<size_t>& shape) {
+  size_t nbytes = dt.bits / 8;
+  for (size_t dim : shape) nbytes *= dim;
+  return nbytes;
+}
+
+/**
+ * @brief Typed format (dtype, shape and size) of the frames in the circular buffer.
+ *
+ * The format is resolved from the Width, Height and PixelType tags that the circular buffer adds
+ * to every image.  The raw tag values are kept alongside the typed fields, so that checking a
+ * frame of an unchanged format costs three string comparisons; integer parsing and the pixel type
+ * lookup only happen when the format changes (e.g. at the start of a sequence).
+ *
+ * The shape is stored inline so that copying a `FrameFormat` does not allocate.
+ */
+struct FrameFormat {
+  std::string width, height, pixelType;  // tag values this format was resolved from
+  nb::dlpack::dtype dtype{};
+  size_t ndim = 0;
+  size_t shape[3] = {0, 0, 0};
+  size_t nbytes = 0;
+
+  /**
+   * @brief Re-resolves the format from the tags of `md` if they differ from the cached ones.
+   *
+   * @return true if the format changed (or was resolved for the first time).
+   */
+  bool update(const Metadata& md) {
+    // These keys are unfortunately hard-coded in the source code
+    // see https://github.com/micro-manager/mmCoreAndDevices/pull/531
+    // `GetSingleTag` can only return a copy of the tag, but its name, device and value are short
+    // enough for the small-string buffer, so this does not allocate.  The values are compared in
+    // place and only copied into the cache when the format changes.
+    const MetadataSingleTag w = md.GetSingleTag("Width");
+    const MetadataSingleTag h = md.GetSingleTag("Height");
+    const MetadataSingleTag pt = md.GetSingleTag("PixelType");
+    if (nbytes != 0 && w.GetValue() == width && h.GetValue() == height &&
+        pt.GetValue() == pixelType) {
+      return false;
+    }
+
+    auto [dt, shp] = get_dtype_shape(std::stoi(h.GetValue()), std::stoi(w.GetValue()),
+                                     pt.GetValue());
+    dtype = dt;
+    ndim = shp.size();
+    std::copy(shp.begin(), shp.end(), shape);
+    nbytes = get_nbytes(dt, shp);
+    width = w.GetValue();
+    height = h.GetValue();
+    pixelType = pt.GetValue();
+    return true;
+  }
+
+  // Whether this format has the given dtype and shape
+  bool equals(nb::dlpack::dtype dt, const std::vector<size_t>& shp) const {
+    return dtype == dt && shp.size() == ndim && std::equal(shp.begin(), shp.end(), shape);
+  }
+
+  // Whether both formats have the same dtype and shape
+  bool equals(const FrameFormat& other) const {
+    return dtype == other.dtype && ndim == other.ndim &&
+           std::equal(shape, shape + ndim, other.shape);
+  }
+};
+
+/**
+ * @brief dtype and shape of the images of the current camera.
+ *
+ * This queries the camera, which takes its device lock: call it without holding the GIL (see
+ * `camera_dtype_shape` otherwise).
+ *
+ * @throws std::runtime_error If the combination of image properties (e.g., bytes per pixel, number
+ *                            of components) is not supported.
+ */
+std::pair<nb::dlpack::dtype, std::vector<size_t>> query_camera_dtype_shape(CMMCore& core) {
+  return get_dtype_shape(core.getImageHeight(), core.getImageWidth(), core.getBytesPerPixel(),
+                         core.getNumberOfComponents());
+}
+
+// Like `query_camera_dtype_shape`, for callers that hold the GIL: releases it around the query
+std::pair<nb::dlpack::dtype, std::vector<size_t>> camera_dtype_shape(CMMCore& core) {
+  nb::gil_scoped_release gil;
+  return query_camera_dtype_shape(core);
+}
+
+/**
+ * @brief Creates a read-only NumPy array representing an image from the provided buffer and
+ * `CMMCore` instance.
+ *
+ * This function wraps a raw memory buffer from a `CMMCore` instance into a `nanobind::ndarray` of
+ * type `numpy.ndarray`. The array is read-only and shares ownership with the provided `CMMCore`
+ * instance to ensure memory safety.  It only touches Python objects, so the image format must
+ * have been read (without the GIL) beforehand.
+ *
+ * @param core A reference to the `CMMCore` object, which ensures ownership of the buffer.
+ * @param pBuf Pointer to the data buffer containing the image data.
+ * @param format dtype and shape of the image, see `query_camera_dtype_shape`.
+ * @param owner Optional owner of `pBuf` (e.g. a pooled copy).  Defaults to `core`.
+ *
+ * @return A `nanobind::ndarray` representing the image buffer as a `numpy.ndarray`.
+ *
+ * @note The resulting array is C-contiguous by default, as no strides are specified.
+ *       Unless an owner is given, ownership of the buffer is tied to the lifetime of the
+ *       `CMMCore` object.
+ */
+ro_np_array create_image_array(CMMCore& core, void* pBuf,
+                               const std::pair<nb::dlpack::dtype, std::vector<size_t>>& format,
+                               nb::object owner = nb::object()) {
+  const auto& [dt, shape] = format;
+
+  // Cast the CMMCore object to an nb::object for ownership
+  if (!owner.is_valid()) owner = nb::cast(core, nb::rv_policy::reference);
+
+  return ro_np_array(pBuf,          // std::conditional_t<ReadOnly, const void*, void*>
+                     shape.size(),  // size_t ndim
+                     shape.data(),  // const size_t* shape
+                     owner,         // handle owner
+                     nullptr,       // const int64_t *stride (nullptr for default C-contiguous)
+                     dt             // Data type
+  );
+}
+/**
+ * @brief Creates a read-only NumPy array for a circular buffer image of a known format.
+ *
+ * This function wraps a raw memory buffer from a `CMMCore` instance into a `nanobind::ndarray` of
+ * type `numpy.ndarray`. The array is read-only and shares ownership with the provided `CMMCore`
+ * instance to ensure memory safety.
+ *
+ * @param core A reference to the `CMMCore` object, which provides image metadata and ensures
+ *            ownership of the buffer.
+ * @param pBuf Pointer to the data buffer containing the image.
+ * @param format The format of the image, resolved from its metadata (see `FrameFormat`).
+ * @param owner Optional owner of `pBuf` (e.g. a pooled copy).  Defaults to `core`.
+ *
+ * @return A `nanobind::ndarray` representing the image buffer as a `numpy.ndarray`.
+ *
+ * @note The resulting array is C-contiguous by default, as no strides are specified.
+ */
+ro_np_array create_metadata_array(CMMCore& core, void* pBuf, const FrameFormat& format,
+                                  nb::object owner = nb::object()) {
+  // Cast the CMMCore object to an nb::object for ownership
+  if (!owner.is_valid()) owner = nb::cast(core, nb::rv_policy::reference);
+
+  return ro_np_array(pBuf,          // std::conditional_t<ReadOnly, const void*, void*>
+                     format.ndim,   // size_t ndim
+                     format.shape,  // const size_t* shape
+                     owner,         // handle owner
+                     nullptr,       // const int64_t *stride (nullptr for default C-contiguous)
+                     format.dtype   // Data type
+  );
+}
+
+/**
+ * @brief Creates a writable NumPy array that takes ownership of a heap-allocated buffer.
+ *
+ * @param data Buffer allocated with `new uint8_t[]`.  The array's capsule frees it.
+ * @param shape Shape of the array.
+ * @param dt Data type of the array.
+ */
+np_array create_owned_array(std::unique_ptr<uint8_t[]> data, const std::vector<size_t>& shape,
+                            nb::dlpack::dtype dt) {
+  uint8_t* pData = data.release();
+  nb::capsule owner(pData, [](void* p) noexcept { delete[] static_cast<uint8_t*>(p); });
+  return np_array(pData, shape.size(), shape.data(), owner, nullptr, dt);
+}
+
+/**
+ * @brief Moves a vector of numbers into a NumPy array of the given shape without copying.
+ */
+template <typename T>
+np_array create_vector_array(std::vector<T>&& values, const std::vector<size_t>& shape) {
+  auto* pVec = new std::vector<T>(std::move(values));
+  nb::capsule owner(pVec, [](void* p) noexcept { delete static_cast<std::vector<T>*>(p); });
+  return np_array(pVec->data(), shape.size(), shape.data(), owner, nullptr, nb::dtype<T>());
+}
+
+/**
+ * @brief Moves a vector of numbers into a 1D NumPy array without copying.
+ */
+template <typename T>
+np_array create_column_array(std::vector<T>&& values) {
+  size_t size = values.size();
+  return create_vector_array(std::move(values), {size});
+}
+
+///////////////// Host buffer allocation ///////////////////
+
+// How the bindings allocate their own large buffers (see `setBufferAllocationOptions`)
+struct AllocationOptions {
+  bool prefault = true;    // touch every page up front, so acquisition does not page-fault
+  bool hugepages = false;  // try explicit (MAP_HUGETLB), then transparent hugepages (Linux)
+};
+
+// Allocation timings reported by `getBufferAllocationStats` (accessed with the GIL held)
+struct AllocationStats {
+  double circularBufferAllocMs = 0;  // duration of the last circular buffer (re)allocation
+  uint64_t circularBufferReused = 0;  // footprint changes that kept the existing buffer
+  uint64_t buffers = 0;
+  uint64_t bytes = 0;
+  uint64_t hugepageBuffers = 0;
+  double allocMs = 0;
+  double faultMs = 0;
+};
+
+double elapsed_ms(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since)
+      .count();
+}
+
+/**
+ * @brief A large, page-aligned host buffer owned by the bindings (e.g. a streaming chunk or a
+ * shared-memory ring), optionally hugepage-backed and prefaulted.
+ *
+ * On POSIX systems the buffer is an anonymous mapping.  With `hugepages`, an explicit hugepage
+ * mapping is tried first and, if no hugepages are reserved, a regular mapping advised with
+ * MADV_HUGEPAGE is used instead.  With `prefault`, every page is written once right after
+ * allocation, so the first frames of an acquisition do not pay for page faults.
+ */
+class HostBuffer {
+ public:
+  static constexpr size_t kPageBytes = 4096;
+  static constexpr size_t kHugePageBytes = 2 << 20;
+
+  HostBuffer(size_t size, AllocationOptions options, AllocationStats* stats = nullptr)
+      : size_(std::max<size_t>(size, 1)) {
+    auto t0 = std::chrono::steady_clock::now();
+#if !defined(_WIN32)
+    void* p = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    if (options.hugepages) {
+      mapped_ = (size_ + kHugePageBytes - 1) / kHugePageBytes * kHugePageBytes;
+      p = mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+               -1, 0);
+      hugepages_ = p != MAP_FAILED;
+    }
+#endif
+    if (p == MAP_FAILED) {
+      mapped_ = (size_ + kPageBytes - 1) / kPageBytes * kPageBytes;
+      p = mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED) throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+      if (options.hugepages) hugepages_ = madvise(p, mapped_, MADV_HUGEPAGE) == 0;
+#endif
+    }
+    data_ = static_cast<uint8_t*>(p);
+#else
+    data_ = new uint8_t[size_];
+#endif
+    double allocMs = elapsed_ms(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    if (options.prefault) {
+      volatile uint8_t* v = data_;
+      for (size_t i = 0; i < size_; i += kPageBytes) v[i] = 0;
+    }
+    double faultMs = elapsed_ms(t0);
+
+    if (stats) {
+      ++stats->buffers;
+      stats->bytes += size_;
+      stats->hugepageBuffers += hugepages_;
+      stats->allocMs += allocMs;
+      stats->faultMs += faultMs;
+    }
+  }
+
+  ~HostBuffer() {
+#if !defined(_WIN32)
+    munmap(data_, mapped_);
+#else
+    delete[] data_;
+#endif
+  }
+
+  HostBuffer(const HostBuffer&) = delete;
+  HostBuffer& operator=(const HostBuffer&) = delete;
+
+  uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool hugepages() const { return hugepages_; }
+
+ private:
+  size_t size_;
+  size_t mapped_ = 0;
+  uint8_t* data_ = nullptr;
+  bool hugepages_ = false;
+};
+
+///////////////// Binding instrumentation ///////////////////
+
+// Compile with -DPMN_BINDING_STATS=0 (meson option `binding_stats=false`) to remove all timing
+#ifndef PMN_BINDING_STATS
+#define PMN_BINDING_STATS 1
+#endif
+
+std::atomic<bool> g_bindingStatsEnabled{false};
+
+// Whether binding calls are currently being recorded (see `enableBindingStats`)
+inline bool binding_stats_enabled() {
+#if PMN_BINDING_STATS
+  return g_bindingStatsEnabled.load(std::memory_order_relaxed);
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Call count, bytes and latency histogram of one instrumented binding.
+ *
+ * Bucket i of the histogram counts calls that took [2^i, 2^(i+1)) ns; the last bucket also holds
+ * everything longer.  All counters are relaxed atomics, so concurrent calls never block.
+ */
+struct BindingStat {
+  static constexpr size_t kBuckets = 40;  // up to ~9 minutes
+
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> totalNs{0};
+  std::atomic<uint64_t> maxNs{0};
+  std::atomic<uint64_t> histogram[kBuckets] = {};
+
+  void record(uint64_t ns, uint64_t nbytes) {
+    calls.fetch_add(1, std::memory_order_relaxed);
+    if (nbytes) bytes.fetch_add(nbytes, std::memory_order_relaxed);
+    totalNs.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t prev = maxNs.load(std::memory_order_relaxed);
+    while (ns > prev && !maxNs.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {
+    }
+    size_t bucket = 0;
+    while (bucket + 1 < kBuckets && (ns >> (bucket + 1))) ++bucket;
+    histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void reset() {
+    calls = 0;
+    bytes = 0;
+    totalNs = 0;
+    maxNs = 0;
+    for (auto& b : histogram) b = 0;
+  }
+};
+
+std::mutex g_bindingStatsMutex;
+
+// All stats by name; entries are never removed, so references stay valid
+std::map<std::string, BindingStat, std::less<>>& binding_stats() {
+  static auto* stats = new std::map<std::string, BindingStat, std::less<>>();
+  return *stats;
+}
+
+// Looks up (or creates) the stat for `name` under the lock; call sites resolve it once into a
+// function-local static, so timing a call never takes the lock
+BindingStat& binding_stat(const char* name) {
+  std::lock_guard<std::mutex> lock(g_bindingStatsMutex);
+  auto& stats = binding_stats();
+  auto it = stats.find(name);
+  if (it == stats.end()) it = stats.try_emplace(name).first;
+  return it->second;
+}
+
+/**
+ * @brief Records the duration of the enclosing scope into `stat`, if stats are enabled.
+ *
+ * While a timer is active, `binding_add_bytes` attributes wrapped or copied bytes to it.  When
+ * stats are disabled, construction is a single relaxed load and nothing else happens.  Resolve
+ * `stat` once per call site:
+ *
+ *     static BindingStat& stat = binding_stat("getImage");
+ *     BindingTimer timer(stat);
+ */
+class BindingTimer {
+ public:
+  explicit BindingTimer(BindingStat& stat) {
+    if (!binding_stats_enabled()) return;
+    stat_ = &stat;
+    outer_ = current_;
+    current_ = this;
+    start_ = std::chrono::steady_clock::now();
+  }
+
+  ~BindingTimer() {
+    if (!stat_) return;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start_)
+                  .count();
+    stat_->record(static_cast<uint64_t>(ns), bytes_);
+    current_ = outer_;
+  }
+
+  BindingTimer(const BindingTimer&) = delete;
+  BindingTimer& operator=(const BindingTimer&) = delete;
+
+  static void addBytes(size_t n) {
+    if (current_) current_->bytes_ += n;
+  }
+
+ private:
+  static thread_local BindingTimer* current_;
+
+  BindingStat* stat_ = nullptr;
+  BindingTimer* outer_ = nullptr;
+  uint64_t bytes_ = 0;
+  std::chrono::steady_clock::time_point start_;
+};
+
+thread_local BindingTimer* BindingTimer::current_ = nullptr;
+
+// Attributes `n` bytes wrapped or copied to the innermost active `BindingTimer` on this thread
+inline void binding_add_bytes(size_t n) { BindingTimer::addBytes(n); }
+
+/**
+ * @brief Times a Python callback dispatched from `PyMMEventCallback`.
+ *
+ * When stats are enabled, the GIL is acquired here first so that the wait for it is recorded
+ * separately (as "MMEventCallback.gil_wait"); NB_OVERRIDE then re-enters it at no cost.
+ */
+class CallbackTimer {
+ public:
+  explicit CallbackTimer(BindingStat& stat) : timer_(stat) {
+    if (!binding_stats_enabled()) return;
+    static BindingStat& gilWait = binding_stat("MMEventCallback.gil_wait");
+    BindingTimer wait(gilWait);
+    gil_.emplace();
+  }
+
+ private:
+  BindingTimer timer_;
+  std::optional<nb::gil_scoped_acquire> gil_;  // released before timer_ records
+};
+
+///////////////// Pooled image copies ///////////////////
+
+class FrameCopyPool;
+
+/**
+ * @brief A reserved slot of a `FrameCopyPool`, which receives a private copy of one frame.
+ *
+ * The slot is reserved before the frame is retrieved and filled right after.  It is handed back
+ * to the pool when the `PooledFrame` is destroyed, which happens when the NumPy array wrapping it
+ * is garbage collected (see `pooled_frame_capsule`), or right away if the retrieval failed.
+ */
+class PooledFrame {
+ public:
+  explicit PooledFrame(std::shared_ptr<FrameCopyPool> pool) : pool_(std::move(pool)) {}
+  ~PooledFrame();
+
+  // Copy `nBytes` from `pSrc` into the slot (taking a free one from the pool, if any).  Call once.
+  void fill(const void* pSrc, size_t nBytes);
+
+  void* data() const { return slot_.get(); }
+
+ private:
+  std::shared_ptr<FrameCopyPool> pool_;
+  std::unique_ptr<uint8_t[]> slot_;
+  size_t nBytes_ = 0;
+};
+
+/**
+ * @brief Bounded pool of frame-sized slots that retrieved images are copied into.
+ *
+ * This is a pooled copy, not a pin: the circular buffer lives in MMCore and cannot be pinned from
+ * here, so there is no guarantee that a frame is not overwritten before it is copied.  The copy
+ * is made (once, without the GIL) right after the core call returns, which narrows that window to
+ * the few microseconds between the two; once made, the copy is private to the returned array.
+ * Slots are recycled when that array is garbage collected.  At most `maxPooled` slots can be out
+ * at once; beyond that, `reserve` fails with a `CMMError` rather than silently allocating more
+ * memory, just like the circular buffer overflows when it is not drained.  A slot is reserved
+ * before the frame is retrieved, so a full pool never consumes a frame.
+ *
+ * All methods are thread-safe and may be called without holding the GIL.
+ */
+class FrameCopyPool : public std::enable_shared_from_this<FrameCopyPool> {
+ public:
+  explicit FrameCopyPool(size_t maxPooled) : maxPooled_(maxPooled) {}
+
+  // Reserve a slot for one frame, to be filled with `PooledFrame::fill`
+  std::unique_ptr<PooledFrame> reserve() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (inUse_ >= maxPooled_) {
+        throw CMMError("Image copy pool exhausted: all " + std::to_string(maxPooled_) +
+                       " pooled images are still referenced from Python.");
+      }
+      ++inUse_;
+    }
+    return std::make_unique<PooledFrame>(shared_from_this());
+  }
+
+  size_t inUseCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return inUse_;
+  }
+
+  size_t maxPooled() const { return maxPooled_; }
+
+ private:
+  friend class PooledFrame;
+
+  // A free slot of `nBytes`, or null if there is none
+  std::unique_ptr<uint8_t[]> takeFree(size_t nBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (nBytes != slotBytes_) {  // frame size changed, drop the old slots
+      free_.clear();
+      slotBytes_ = nBytes;
+    }
+    if (free_.empty()) return nullptr;
+    std::unique_ptr<uint8_t[]> slot = std::move(free_.back());
+    free_.pop_back();
+    return slot;
+  }
+
+  void giveBack(std::unique_ptr<uint8_t[]> slot, size_t nBytes) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --inUse_;
+    if (slot && nBytes == slotBytes_) free_.push_back(std::move(slot));
+  }
+
+  mutable std::mutex mutex_;
+  const size_t maxPooled_;
+  size_t inUse_ = 0;
+  size_t slotBytes_ = 0;
+  std::vector<std::unique_ptr<uint8_t[]>> free_;
+};
+
+void PooledFrame::fill(const void* pSrc, size_t nBytes) {
+  slot_ = pool_->takeFree(nBytes);
+  if (!slot_) slot_.reset(new uint8_t[nBytes]);
+  nBytes_ = nBytes;
+  std::memcpy(slot_.get(), pSrc, nBytes);
+}
+
+PooledFrame::~PooledFrame() { pool_->giveBack(std::move(slot_), nBytes_); }
+
+// Wrap a pooled frame in a capsule that can be used as the owner of a NumPy array
+nb::capsule pooled_frame_capsule(std::unique_ptr<PooledFrame> frame) {
+  return nb::capsule(frame.release(),
+                     [](void* p) noexcept { delete static_cast<PooledFrame*>(p); });
+}
+
+///////////////// Per-core binding state ///////////////////
+
+class BufferWatcher;
+class AcquisitionMonitor;
+class ImageCorrection;
+class StateVersions;
+
+/**
+ * @brief State that the bindings attach to a `CMMCore` instance.
+ *
+ * `CMMCore` itself is bound directly, so extra state lives in a registry keyed by the address of
+ * the core.  The entry is created on first use and dropped when the Python object is garbage
+ * collected (via a weak reference).
+ */
+struct CoreExtras {
+  nb::object weakref;                          // keeps the cleanup callback alive
+  std::shared_ptr<FrameCopyPool> copyPool;  // null unless pooled image copies are enabled
+  FrameFormat frameFormat;                     // format of the last image fetched with metadata
+  std::shared_ptr<BufferWatcher> watcher;      // null until someone waits for frames
+  AllocationOptions allocation;                // options for binding-owned host buffers
+  AllocationStats allocationStats;
+  bool syntheticAdapter = false;        // whether the built-in device adapter is registered
+  // frames popped through the bindings, for telemetry
+  std::atomic<uint64_t> poppedFrames{0};
+  // sequence acquisitions started through the bindings, so that per-sequence state can be reset
+  std::atomic<uint64_t> sequenceStarts{0};
+  std::shared_ptr<AcquisitionMonitor> monitor;  // null unless health telemetry is enabled
+  std::shared_ptr<ImageCorrection> correction;  // null unless image correction is enabled
+  std::shared_ptr<StateVersions> versions;      // null until the state cache is first versioned
+  // per device label with property handles: true until the device is unloaded
+  std::unordered_map<std::string, std::shared_ptr<std::atomic<bool>>> deviceTokens;
+};
+
+// Get (or create) the extras for `core`.  Must be called with the GIL held.
+CoreExtras& core_extras(CMMCore& core) {
+  // intentionally leaked: entries hold Python objects that must not outlive the interpreter
+  static auto* registry = new std::unordered_map<const CMMCore*, std::unique_ptr<CoreExtras>>();
+
+  auto it = registry->find(&core);
+  if (it != registry->end()) return *it->second;
+
+  auto extras = std::make_unique<CoreExtras>();
+  const CMMCore* key = &core;
+  nb::object cleanup = nb::cpp_function([key](nb::handle) { registry->erase(key); });
+  extras->weakref = nb::weakref(nb::cast(core, nb::rv_policy::reference), cleanup);
+  return *registry->emplace(key, std::move(extras)).first->second;
+}
+
+// Whether the circular buffer already has `sizeMB` for the current camera format.  Queries the
+// live core state (footprint, capacity and camera), so ROI, binning or camera changes made since
+// the last allocation are taken into account.  Call without the GIL.
+bool circular_buffer_fits(CMMCore& core, unsigned sizeMB) {
+  if (core.isSequenceRunning() || core.getCircularBufferMemoryFootprint() != sizeMB) return false;
+  long frameBytes = core.getImageBufferSize();
+  if (frameBytes <= 0) return false;
+  // same frame count as MMCore's CircularBuffer::Initialize computes for this footprint
+  long capacity = static_cast<long>((static_cast<uint64_t>(sizeMB) << 20) / frameBytes);
+  return capacity > 0 && core.getBufferTotalCapacity() == capacity;
+}
+
+/**
+ * @brief Calls `allocate` (which (re)allocates the circular buffer) without the GIL and records
+ * its duration in the core's `AllocationStats`.  Must be called with the GIL held.
+ *
+ * Unlike `HostBuffer`, the circular buffer cannot be prefaulted from the bindings: MMCore
+ * allocates its memory internally and exposes no pointer to it, so its pages are faulted in as
+ * the first frames are inserted.
+ */
+template <typename Fn>
+void allocate_circular_buffer(CMMCore& core, Fn&& allocate) {
+  double allocMs;
+  {
+    nb::gil_scoped_release gil;
+    auto t0 = std::chrono::steady_clock::now();
+    allocate();
+    allocMs = elapsed_ms(t0);
+  }
+  core_extras(core).allocationStats.circularBufferAllocMs = allocMs;
+}
+
+// Wraps a getter that pops a frame, so that the frame is counted in the core's `poppedFrames`
+template <typename Getter>
+auto counting_pops(CMMCore& core, Getter&& getImage) {
+  std::atomic<uint64_t>* popped = &core_extras(core).poppedFrames;
+  return [popped, getImage = std::forward<Getter>(getImage)] {
+    void* pBuf = getImage();
+    popped->fetch_add(1, std::memory_order_relaxed);
+    return pBuf;
+  };
+}
+
+/**
+ * @brief Fetches an image from `core` with the GIL released and wraps it in a NumPy array.
+ *
+ * `getImage` is called without the GIL and must return a pointer into CMMCore-owned memory.  When
+ * pooled copies are enabled, a slot is reserved before `getImage` is called (so an exhausted pool
+ * raises without consuming a frame), the frame is copied into it right after `getImage` returns,
+ * and the returned array holds that slot until it is garbage collected.  Otherwise the array is a
+ * zero-copy view that the circular buffer may overwrite.
+ *
+ * @param md If given, the image dtype and shape are read from this metadata (which `getImage` is
+ *           expected to fill), otherwise from the current camera settings.  The resolved format is
+ *           cached per core, so only a format change requires parsing the tags.
+ */
+template <typename Getter>
+ro_np_array fetch_image_array(CMMCore& core, Getter&& getImage, const Metadata* md = nullptr) {
+  CoreExtras& extras = core_extras(core);
+  std::shared_ptr<FrameCopyPool> pool = extras.copyPool;
+  // work on a copy, so the cache is only touched while holding the GIL
+  FrameFormat format = extras.frameFormat;
+  bool formatChanged = false;
+  std::pair<nb::dlpack::dtype, std::vector<size_t>> cameraFormat;  // used without metadata
+  void* pBuf;
+  // reserved up front: a full pool raises before `getImage` can consume a frame
+  std::unique_ptr<PooledFrame> copy = pool ? pool->reserve() : nullptr;
+  {
+    nb::gil_scoped_release gil;
+    pBuf = getImage();
+    size_t nbytes;
+    if (md) {
+      formatChanged = format.update(*md);
+      nbytes = format.nbytes;
+    } else {
+      cameraFormat = query_camera_dtype_shape(core);
+      nbytes = get_nbytes(cameraFormat.first, cameraFormat.second);
+    }
+    if (copy) copy->fill(pBuf, nbytes);
+    if (binding_stats_enabled()) binding_add_bytes(nbytes);
+  }
+  if (formatChanged) extras.frameFormat = format;
+  nb::object owner;
+  if (copy) {
+    pBuf = copy->data();
+    owner = pooled_frame_capsule(std::move(copy));
+  }
+  return md ? create_metadata_array(core, pBuf, format, owner)
+            : create_image_array(core, pBuf, cameraFormat, owner);
+}
+
+///////////////// Image correction ///////////////////
+
+/**
+ * @brief Fixed set of worker threads that splits per-pixel loops across cores.
+ *
+ * `parallelFor` is not reentrant: callers must serialize their jobs (see `ImageCorrection`).
+ */
+class WorkerPool {
+ public:
+  static constexpr size_t kMinChunk = 1 << 14;  // values per chunk, so small frames stay serial
+
+  explicit WorkerPool(size_t threads) {
+    for (size_t i = 1; i < threads; ++i) workers_.emplace_back([this] { run(); });
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  size_t size() const { return workers_.size() + 1; }
+
+  /**
+   * @brief Calls `fn(begin, end)` for contiguous chunks of [0, n) on the workers and the calling
+   * thread, and returns once all chunks are done.
+   *
+   * @throws The first exception thrown by `fn`.
+   */
+  void parallelFor(size_t n, const std::function<void(size_t, size_t)>& fn) {
+    size_t chunks = std::min(size(), std::max<size_t>(n / kMinChunk, 1));
+    if (chunks == 1) {
+      fn(0, n);
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    fn_ = &fn;
+    n_ = n;
+    chunks_ = chunks;
+    next_ = 1;
+    pending_ = chunks;
+    error_ = nullptr;
+    wake_.notify_all();
+    lock.unlock();
+    runChunk(0);
+    lock.lock();
+    done_.wait(lock, [&] { return pending_ == 0; });
+    fn_ = nullptr;
+    if (error_) std::rethrow_exception(error_);
+  }
+
+ private:
+  // Runs chunk `c` of the current job and counts it as done
+  void runChunk(size_t c) {
+    std::exception_ptr error;
+    try {
+      (*fn_)(c * n_ / chunks_, (c + 1) * n_ / chunks_);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error && !error_) error_ = error;
+    if (--pending_ == 0) done_.notify_all();
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      wake_.wait(lock, [&] { return stop_ || next_ < chunks_; });
+      if (stop_) return;
+      size_t c = next_++;
+      lock.unlock();
+      runChunk(c);
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wake_;  // wakes the workers
+  std::condition_variable done_;  // wakes the caller of parallelFor
+  // the current job; constant while any of its chunks are pending
+  const std::function<void(size_t, size_t)>* fn_ = nullptr;
+  size_t n_ = 0;
+  size_t chunks_ = 0;
+  size_t next_ = 0;  // next chunk to hand out
+  size_t pending_ = 0;
+  std::exception_ptr error_;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;  // declared last: started after all other members
+};
+
+/**
+ * @brief Dark/flat-field correction and frame averaging for frames popped through the bindings
+ * (see `setImageCorrection`).
+ *
+ * Each raw frame passes through up to three stages, each split across the worker pool:
+ *  - "dark": conversion to float32, minus the dark frame if one is set;
+ *  - "flat": multiplication by the flat-field gain, mean(flat - dark) / (flat - dark);
+ *  - "average": accumulation in float32 over `average` frames, either in blocks (each output
+ *    frame consumes `average` raw frames) or rolling (each output frame is the mean of the last
+ *    `average` raw frames).
+ *
+ * Output frames are float32 with the shape of the raw frames.  Processing is serialized, since
+ * rolling averaging carries state from one frame to the next; the rolling window starts over with
+ * every sequence started through the bindings (`CoreExtras::sequenceStarts`).
+ */
+class ImageCorrection {
+ public:
+  // A frame as popped from the circular buffer
+  struct RawFrame {
+    const void* data = nullptr;  // null if no frame is coming (ends a partial block)
+    nb::dlpack::dtype dtype{};
+    size_t values = 0;  // number of pixel values (pixels times components)
+
+    static RawFrame of(const void* data, const FrameFormat& format) {
+      return {data, format.dtype, format.nbytes / (format.dtype.bits / 8)};
+    }
+  };
+
+  struct StageStat {
+    uint64_t calls = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+  };
+
+  struct Stats {
+    uint64_t framesIn = 0;
+    uint64_t framesOut = 0;
+    StageStat dark, flat, average;
+  };
+
+  ImageCorrection(std::vector<float> dark, std::vector<float> flat, size_t average, bool rolling,
+                  size_t threads, const std::atomic<uint64_t>& sequenceStarts)
+      : dark_(std::move(dark)),
+        average_(average),
+        rolling_(rolling),
+        sequenceStarts_(sequenceStarts),
+        pool_(threads),
+        lastSequenceStarts_(sequenceStarts.load(std::memory_order_relaxed)) {
+    if (average_ == 0) throw nb::value_error("average must be at least 1");
+    if (!flat.empty()) {
+      if (!dark_.empty() && dark_.size() != flat.size()) {
+        throw nb::value_error("dark and flat must have the same shape");
+      }
+      // gain = mean(flat - dark) / (flat - dark), leaving pixels without signal uncorrected
+      gain_.resize(flat.size());
+      double sum = 0;
+      size_t valid = 0;
+      for (size_t i = 0; i < flat.size(); ++i) {
+        gain_[i] = flat[i] - (dark_.empty() ? 0.0f : dark_[i]);
+        if (gain_[i] > 0) {
+          sum += gain_[i];
+          ++valid;
+        }
+      }
+      if (valid == 0) throw nb::value_error("flat has no pixels above dark");
+      const float mean = static_cast<float>(sum / valid);
+      for (float& g : gain_) g = g > 0 ? mean / g : 1.0f;
+    }
+  }
+
+  // Number of raw frames consumed per output frame
+  size_t framesPerOutput() const { return rolling_ ? 1 : average_; }
+
+  Stats stats() {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    return stats_;
+  }
+
+  /**
+   * @brief Produces one output frame of `values` floats in `dst` from the frames returned by
+   * `popRaw(k)`, k = 0 .. framesPerOutput() - 1.  Does not need the GIL.
+   *
+   * `popRaw` returns a null frame instead of popping one that does not fit (see
+   * `next_frame_fits`).  For k = 0, nothing is produced; in block mode, a null frame for k > 0
+   * ends the block early (e.g. when the sequence stopped), and the output is the mean of the
+   * frames popped so far.
+   *
+   * @return false if `popRaw(0)` returned a null frame, so that no output was produced.
+   * @throws std::runtime_error If the references do not match `values`; no frame is popped then.
+   */
+  template <typename PopRaw>
+  bool process(PopRaw&& popRaw, float* dst, size_t values) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t refs = !dark_.empty() ? dark_.size() : gain_.size();
+    if (refs != 0 && refs != values) {
+      throw std::runtime_error("The image correction references have " + std::to_string(refs) +
+                               " values, but frames have " + std::to_string(values) + ".");
+    }
+    Stats delta;
+    if (rolling_ && average_ > 1) {
+      uint64_t starts = sequenceStarts_.load(std::memory_order_relaxed);
+      if (sum_.size() != values || starts != lastSequenceStarts_) resetRolling(values);
+      lastSequenceStarts_ = starts;
+      RawFrame raw = popRaw(0);
+      if (!raw.data) return false;
+      work_.resize(values);
+      correct(raw, work_.data(), values, delta);
+      auto t0 = std::chrono::steady_clock::now();
+      accumulateRolling(dst, values);
+      record(delta.average, t0);
+    } else {
+      RawFrame first = popRaw(0);
+      if (!first.data) return false;
+      correct(first, dst, values, delta);
+      if (average_ > 1) {
+        work_.resize(values);
+        size_t n = 1;
+        for (; n < average_; ++n) {
+          RawFrame raw = popRaw(n);
+          if (!raw.data) break;
+          correct(raw, work_.data(), values, delta);
+          auto t0 = std::chrono::steady_clock::now();
+          const float* w = work_.data();
+          pool_.parallelFor(values, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) dst[i] += w[i];
+          });
+          record(delta.average, t0);
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        const float scale = 1.0f / static_cast<float>(n);
+        pool_.parallelFor(values, [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) dst[i] *= scale;
+        });
+        record(delta.average, t0);
+      }
+    }
+    delta.framesOut = 1;
+    std::lock_guard<std::mutex> statsLock(statsMutex_);
+    merge(stats_, delta);
+    return true;
+  }
+
+ private:
+  template <typename T>
+  static void convert(const T* src, const float* dark, float* dst, size_t begin, size_t end) {
+    if (dark) {
+      for (size_t i = begin; i < end; ++i) dst[i] = static_cast<float>(src[i]) - dark[i];
+    } else {
+      for (size_t i = begin; i < end; ++i) dst[i] = static_cast<float>(src[i]);
+    }
+  }
+
+  static void record(StageStat& stat, std::chrono::steady_clock::time_point t0) {
+    double ms = elapsed_ms(t0);
+    ++stat.calls;
+    stat.totalMs += ms;
+    stat.maxMs = std::max(stat.maxMs, ms);
+  }
+
+  static void merge(Stats& into, const Stats& delta) {
+    into.framesIn += delta.framesIn;
+    into.framesOut += delta.framesOut;
+    for (auto [to, from] : {std::pair{&into.dark, &delta.dark}, std::pair{&into.flat, &delta.flat},
+                            std::pair{&into.average, &delta.average}}) {
+      to->calls += from->calls;
+      to->totalMs += from->totalMs;
+      to->maxMs = std::max(to->maxMs, from->maxMs);
+    }
+  }
+
+  // Runs the dark and flat stages on `raw` into `dst`
+  void correct(const RawFrame& raw, float* dst, size_t values, Stats& delta) {
+    if (raw.values != values) {
+      throw std::runtime_error("Image format does not match the current camera format.");
+    }
+    ++delta.framesIn;
+    auto t0 = std::chrono::steady_clock::now();
+    const float* dark = dark_.empty() ? nullptr : dark_.data();
+    pool_.parallelFor(values, [&](size_t begin, size_t end) {
+      if (raw.dtype == nb::dtype<uint8_t>()) {
+        convert(static_cast<const uint8_t*>(raw.data), dark, dst, begin, end);
+      } else if (raw.dtype == nb::dtype<uint16_t>()) {
+        convert(static_cast<const uint16_t*>(raw.data), dark, dst, begin, end);
+      } else {
+        convert(static_cast<const uint32_t*>(raw.data), dark, dst, begin, end);
+      }
+    });
+    record(delta.dark, t0);
+
+    if (gain_.empty()) return;
+    t0 = std::chrono::steady_clock::now();
+    const float* gain = gain_.data();
+    pool_.parallelFor(values, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) dst[i] *= gain[i];
+    });
+    record(delta.flat, t0);
+  }
+
+  void resetRolling(size_t values) {
+    ring_.clear();
+    nextSlot_ = 0;
+    sum_.assign(values, 0.0f);
+  }
+
+  // Adds `work_` to the rolling window, replacing the oldest frame once full, and writes the mean
+  // of the window to `dst`
+  void accumulateRolling(float* dst, size_t values) {
+    float* sum = sum_.data();
+    const float* w = work_.data();
+    if (ring_.size() < average_) {
+      pool_.parallelFor(values, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) sum[i] += w[i];
+      });
+      ring_.push_back(work_);
+    } else {
+      const float* oldest = ring_[nextSlot_].data();
+      pool_.parallelFor(values, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) sum[i] += w[i] - oldest[i];
+      });
+      std::swap(ring_[nextSlot_], work_);
+      nextSlot_ = (nextSlot_ + 1) % average_;
+      if (nextSlot_ == 0) {
+        // re-add the window from scratch once per cycle, so float32 rounding cannot drift
+        pool_.parallelFor(values, [&](size_t begin, size_t end) {
+          std::fill(sum + begin, sum + end, 0.0f);
+          for (const std::vector<float>& frame : ring_) {
+            for (size_t i = begin; i < end; ++i) sum[i] += frame[i];
+          }
+        });
+      }
+    }
+    const float scale = 1.0f / static_cast<float>(ring_.size());
+    pool_.parallelFor(values, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) dst[i] = sum[i] * scale;
+    });
+  }
+
+  const std::vector<float> dark_;
+  std::vector<float> gain_;  // empty without a flat
+  const size_t average_;
+  const bool rolling_;
+  const std::atomic<uint64_t>& sequenceStarts_;  // CoreExtras::sequenceStarts of the core
+
+  std::mutex mutex_;  // serializes processing; guards everything below
+  WorkerPool pool_;
+  uint64_t lastSequenceStarts_;  // sequence the rolling window belongs to
+  std::vector<float> work_;               // corrected frame before accumulation
+  std::vector<std::vector<float>> ring_;  // rolling window, oldest at nextSlot_ once full
+  size_t nextSlot_ = 0;
+  std::vector<float> sum_;  // sum of the rolling window
+
+  std::mutex statsMutex_;
+  Stats stats_;
+};
+
+///////////////// Metadata conversion ///////////////////
+
+/**
+ * @brief Calls `onSingle(key, value)` or `onArray(key, values)` for every tag in `md`.
+ *
+ * `Metadata` does not expose its tag map, so each key is looked up as a single tag first and
+ * falls back to an array tag when the lookup reports a type mismatch.
+ */
+template <typename SingleFn, typename ArrayFn>
+void for_each_tag(const Metadata& md, SingleFn&& onSingle, ArrayFn&& onArray) {
+  for (const std::string& key : md.GetKeys()) {
+    try {
+      onSingle(key, md.GetSingleTag(key.c_str()).GetValue());
+    } catch (const MetadataError&) {
+      MetadataArrayTag tag = md.GetArrayTag(key.c_str());
+      std::vector<std::string> values;
+      values.reserve(tag.GetSize());
+      for (size_t i = 0; i < tag.GetSize(); ++i) values.push_back(tag.GetValue(i));
+      onArray(key, std::move(values));
+    }
+  }
+}
+
+// Parses the whole of `s` as a base-10 integer; returns false if any characters are left over.
+// Leading whitespace, which `strtoll` would skip, is rejected as well.
+bool parse_int64(const std::string& s, int64_t& out) {
+  if (s.empty() || !(std::isdigit(static_cast<unsigned char>(s[0])) || s[0] == '-' ||
+                     s[0] == '+')) {
+    return false;
+  }
+  char* end = nullptr;
+  errno = 0;
+  long long v = std::strtoll(s.c_str(), &end, 10);
+  if (errno != 0 || *end != '\0') return false;
+  out = v;
+  return true;
+}
+
+// Whether `s` is a plain decimal number: [+-]digits[.digits][(e|E)[+-]digits], where either the
+// integer or the fractional digits may be omitted.  Unlike `strtod`, this rejects leading
+// whitespace, hexadecimal floats, and nan/inf.
+bool is_decimal_number(const std::string& s) {
+  size_t i = 0;
+  const size_t n = s.size();
+  auto digits = [&] {
+    size_t start = i;
+    while (i < n && s[i] >= '0' && s[i] <= '9') ++i;
+    return i - start;
+  };
+  if (i < n && (s[i] == '+' || s[i] == '-')) ++i;
+  size_t mantissa = digits();
+  if (i < n && s[i] == '.') {
+    ++i;
+    mantissa += digits();
+  }
+  if (mantissa == 0) return false;
+  if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+    ++i;
+    if (i < n && (s[i] == '+' || s[i] == '-')) ++i;
+    if (digits() == 0) return false;
+  }
+  return i == n;
+}
+
+// Parses the whole of `s` as a plain decimal number (see `is_decimal_number`); returns false if
+// it is not one or if it is out of range.
+bool parse_double(const std::string& s, double& out) {
+  if (!is_decimal_number(s)) return false;
+  char* end = nullptr;
+  errno = 0;
+  double v = std::strtod(s.c_str(), &end);
+  if (errno == ERANGE || *end != '\0') return false;
+  out = v;
+  return true;
+}
+
+/**
+ * @brief Converts all tags in `md` to a dict in one call.
+ *
+ * Single tags map to their string value and array tags to a list of strings, keyed by the same
+ * (qualified) names returned by `Metadata::GetKeys`.
+ */
+nb::dict metadata_to_dict(const Metadata& md) {
+  static BindingStat& stat = binding_stat("Metadata.to_dict");
+  BindingTimer timer(stat);
+  nb::dict d;
+  for_each_tag(
+      md, [&](const std::string& key, const std::string& value) { d[key.c_str()] = value; },
+      [&](const std::string& key, std::vector<std::string>&& values) {
+        d[key.c_str()] = values;
+      });
+  return d;
+}
+
+/**
+ * @brief One column of `metadata_to_columns`: the values of a single tag across all frames.
+ */
+struct TagColumn {
+  enum class Kind { Int, Float, String, Array };
+
+  Kind kind = Kind::Int;
+  std::vector<char> present;                     // whether the tag exists in each frame
+  std::vector<std::string> values;               // single tag values
+  std::vector<std::vector<std::string>> arrays;  // array tag values (Kind::Array only)
+  std::vector<int64_t> ints;
+  std::vector<double> floats;
+
+  explicit TagColumn(size_t n) : present(n, 0), values(n) {}
+
+  // Picks the narrowest type that represents every value (int64 only if no frame is missing
+  // the tag, float64 with NaN for missing frames, otherwise strings) and parses the values.
+  void finalize() {
+    if (!arrays.empty()) {
+      kind = Kind::Array;
+      for (size_t i = 0; i < values.size(); ++i) {
+        if (present[i] && arrays[i].empty() && !values[i].empty()) arrays[i] = {values[i]};
+      }
+      return;
+    }
+    size_t n = values.size();
+    bool allPresent = std::all_of(present.begin(), present.end(), [](char p) { return p; });
+    if (allPresent) {
+      ints.resize(n);
+      size_t i = 0;
+      while (i < n && parse_int64(values[i], ints[i])) ++i;
+      if (i == n) {
+        kind = Kind::Int;
+        return;
+      }
+      ints.clear();
+    }
+    floats.assign(n, std::numeric_limits<double>::quiet_NaN());
+    for (size_t i = 0; i < n; ++i) {
+      if (present[i] && !parse_double(values[i], floats[i])) {
+        floats.clear();
+        kind = Kind::String;
+        return;
+      }
+    }
+    kind = Kind::Float;
+  }
+
+  // Converts to a NumPy array (numeric tags) or a list (requires the GIL)
+  nb::object to_python() && {
+    switch (kind) {
+      case Kind::Int:
+        return nb::cast(create_column_array(std::move(ints)));
+      case Kind::Float:
+        return nb::cast(create_column_array(std::move(floats)));
+      case Kind::String:
+      case Kind::Array: {
+        nb::list out;
+        for (size_t i = 0; i < present.size(); ++i) {
+          if (!present[i])
+            out.append(nb::none());
+          else if (kind == Kind::Array)
+            out.append(nb::cast(arrays[i]));
+          else
+            out.append(nb::cast(values[i]));
+        }
+        return out;
+      }
+    }
+    return nb::none();
+  }
+};
+
+/**
+ * @brief Converts a sequence of `Metadata` objects to a dict of columns, one entry per tag.
+ *
+ * Collection and numeric parsing run in C++ with the GIL released.  Tags whose values are all
+ * integers become int64 arrays, other numeric tags become float64 arrays (NaN where a frame lacks
+ * the tag), and everything else becomes a list of strings (or of lists, for array tags) with
+ * `None` for missing frames.
+ */
+nb::dict metadata_to_columns(const std::vector<const Metadata*>& mds) {
+  static BindingStat& stat = binding_stat("Metadata.to_columns");
+  BindingTimer timer(stat);
+  size_t n = mds.size();
+  if (std::find(mds.begin(), mds.end(), nullptr) != mds.end())
+    throw nb::type_error("Expected a sequence of Metadata objects, got None");
+
+  std::map<std::string, TagColumn> columns;
+  {
+    nb::gil_scoped_release gil;
+    auto column = [&](const std::string& key) -> TagColumn& {
+      return columns.try_emplace(key, n).first->second;
+    };
+    for (size_t i = 0; i < n; ++i) {
+      for_each_tag(
+          *mds[i],
+          [&](const std::string& key, const std::string& value) {
+            TagColumn& col = column(key);
+            col.present[i] = 1;
+            col.values[i] = value;
+          },
+          [&](const std::string& key, std::vector<std::string>&& values) {
+            TagColumn& col = column(key);
+            col.present[i] = 1;
+            col.arrays.resize(n);
+            col.arrays[i] = std::move(values);
+          });
+    }
+    for (auto& [key, col] : columns) col.finalize();
+  }
+
+  nb::dict d;
+  for (auto& [key, col] : columns) d[key.c_str()] = std::move(col).to_python();
+  return d;
+}
+
+///////////////// Batched image retrieval ///////////////////
+
+/**
+ * @brief Per-frame metadata columns collected by the batched image methods.
+ *
+ * Only the tags needed to index a batch are extracted; they are parsed in C++ so that Python
+ * gets one NumPy array per tag instead of one `Metadata` object per frame.  Missing (or
+ * malformed) tags are stored as -1 (image number), NaN (elapsed time) or an empty string
+ * (camera).
+ */
+struct FrameColumns {
+  std::vector<int64_t> imageNumber;
+  std::vector<double> elapsedTimeMs;
+  std::vector<std::string> camera;
+
+  void reserve(size_t n) {
+    imageNumber.reserve(n);
+    elapsedTimeMs.reserve(n);
+    camera.reserve(n);
+  }
+
+  void clear() {
+    imageNumber.clear();
+    elapsedTimeMs.clear();
+    camera.clear();
+  }
+
+  // Never throws on malformed tags (they are stored like missing ones), so that a frame that
+  // has already been popped is never lost to a parsing error
+  void append(Metadata& md) {
+    int64_t number = -1;
+    if (md.HasTag(MM::g_Keyword_Metadata_ImageNumber) &&
+        !parse_int64(md.GetSingleTag(MM::g_Keyword_Metadata_ImageNumber).GetValue(), number)) {
+      number = -1;
+    }
+    imageNumber.push_back(number);
+    double elapsed = std::numeric_limits<double>::quiet_NaN();
+    if (md.HasTag(MM::g_Keyword_Elapsed_Time_ms) &&
+        !parse_double(md.GetSingleTag(MM::g_Keyword_Elapsed_Time_ms).GetValue(), elapsed)) {
+      elapsed = std::numeric_limits<double>::quiet_NaN();
+    }
+    elapsedTimeMs.push_back(elapsed);
+    camera.push_back(md.HasTag(MM::g_Keyword_Metadata_CameraLabel)
+                         ? md.GetSingleTag(MM::g_Keyword_Metadata_CameraLabel).GetValue()
+                         : std::string());
+  }
+
+  // Convert to a dict of columns, keyed by the metadata tag name (requires the GIL)
+  nb::dict to_dict() && {
+    nb::dict d;
+    d[MM::g_Keyword_Metadata_ImageNumber] = create_column_array(std::move(imageNumber));
+    d[MM::g_Keyword_Elapsed_Time_ms] = create_column_array(std::move(elapsedTimeMs));
+    d[MM::g_Keyword_Metadata_CameraLabel] = nb::cast(camera);
+    return d;
+  }
+};
+
+/**
+ * @brief Reads the format of the next frame in the circular buffer without popping it.
+ *
+ * The oldest frame is addressed from the newest with `getNBeforeLastImageMD`.  If the camera
+ * inserts a frame in between, a newer frame is read instead; it lives in the same buffer, which
+ * MMCore only fills with frames of one format, so the result is the same.  Call without the GIL.
+ *
+ * @return false if the buffer is empty.
+ */
+bool peek_next_format(CMMCore& core, FrameFormat& format) {
+  long remaining = core.getRemainingImageCount();
+  if (remaining <= 0) return false;
+  Metadata md;
+  core.getNBeforeLastImageMD(remaining - 1, md);
+  format.update(md);
+  return true;
+}
+
+// Whether the next frame in the circular buffer has the dtype and size of `expected` (or the
+// buffer is empty, in which case popping raises its own error).  Call without the GIL.
+bool next_frame_fits(CMMCore& core, const ImageCorrection::RawFrame& expected) {
+  FrameFormat next;
+  return !peek_next_format(core, next) ||
+         (next.dtype == expected.dtype &&
+          next.nbytes == expected.values * (expected.dtype.bits / 8));
+}
+
+const char* const kCorrectionFormatMismatch =
+    "The next image in the circular buffer does not match the current camera format.";
+
+/**
+ * @brief Pops up to `n` frames through the core's image correction into one stacked float32 array
+ * (see `pop_next_images`).  Never waits: in block-averaging mode, only as many output frames are
+ * made as there are complete blocks in the buffer.  Like `pop_next_images`, the batch ends early
+ * at a frame whose format differs, which stays in the buffer.
+ */
+std::tuple<np_array, nb::dict> pop_corrected_images(CMMCore& core, ImageCorrection& correction,
+                                                    size_t n) {
+  std::atomic<uint64_t>& popped = core_extras(core).poppedFrames;
+  auto [dt, shape] = camera_dtype_shape(core);
+  const size_t values = get_nbytes(dt, shape) / (dt.bits / 8);
+  std::vector<float> data;
+  FrameColumns columns;
+  size_t count;
+  {
+    nb::gil_scoped_release gil;
+    long remaining = std::max(core.getRemainingImageCount(), 0L);
+    count = std::min(n, static_cast<size_t>(remaining) / correction.framesPerOutput());
+    data.resize(count * values);
+    columns.reserve(count);
+
+    const ImageCorrection::RawFrame camera{nullptr, dt, values};
+    FrameFormat format;
+    for (size_t i = 0; i < count; ++i) {
+      Metadata md;
+      auto popRaw = [&](size_t) -> ImageCorrection::RawFrame {
+        if (!next_frame_fits(core, camera)) return {};
+        void* pBuf = core.popNextImageMD(md);
+        popped.fetch_add(1, std::memory_order_relaxed);
+        format.update(md);
+        return ImageCorrection::RawFrame::of(pBuf, format);
+      };
+      if (!correction.process(popRaw, data.data() + i * values, values)) {
+        if (i == 0) throw std::runtime_error(kCorrectionFormatMismatch);
+        count = i;
+        data.resize(count * values);
+        break;
+      }
+      columns.append(md);  // of the last frame of a block
+    }
+    binding_add_bytes(data.size() * sizeof(float));
+  }
+  shape.insert(shape.begin(), count);
+  return {create_vector_array(std::move(data), shape), std::move(columns).to_dict()};
+}
+
+/**
+ * @brief Pops up to `n` images from the circular buffer into one stacked NumPy array.
+ *
+ * All frames are popped and copied in a single pass with the GIL released.  The number of frames
+ * is limited to the number of images currently in the buffer, so this never blocks waiting for
+ * new frames.  The format is read once, from the oldest frame, before anything is popped; MMCore
+ * keeps only frames of one format in the buffer, so it applies to the whole batch.  If popping a
+ * frame fails, the frames popped so far are returned and the error is raised by the next call.
+ *
+ * @return A tuple of a `(n, height, width[, components])` array and a dict of metadata columns
+ *         (see `FrameColumns`).
+ */
+std::tuple<np_array, nb::dict> pop_next_images(CMMCore& core, size_t n) {
+  static BindingStat& stat = binding_stat("popNextImages");
+  BindingTimer timer(stat);
+  if (std::shared_ptr<ImageCorrection> correction = core_extras(core).correction) {
+    return pop_corrected_images(core, *correction, n);
+  }
+  std::atomic<uint64_t>& popped = core_extras(core).poppedFrames;
+  std::unique_ptr<uint8_t[]> data;
+  std::vector<size_t> shape;
+  nb::dlpack::dtype dt;
+  FrameColumns columns;
+  {
+    nb::gil_scoped_release gil;
+    long remaining = core.getRemainingImageCount();
+    size_t count = std::min(n, static_cast<size_t>(std::max(remaining, 0L)));
+    columns.reserve(count);
+
+    // the circular buffer only holds frames of one format (InsertImage rejects others), so the
+    // format is read once per batch rather than per frame
+    FrameFormat format;
+    if (count > 0 && !peek_next_format(core, format)) count = 0;
+    if (count > 0) data.reset(new uint8_t[count * format.nbytes]);
+    size_t i = 0;
+    try {
+      for (; i < count; ++i) {
+        Metadata md;
+        void* pBuf = core.popNextImageMD(md);
+        popped.fetch_add(1, std::memory_order_relaxed);
+        std::memcpy(data.get() + i * format.nbytes, pBuf, format.nbytes);
+        columns.append(md);
+      }
+    } catch (const std::exception&) {
+      if (i == 0) throw;
+      // return the frames popped so far; the error resurfaces on the next call
+    }
+    count = i;
+
+    if (count == 0) {
+      std::tie(dt, shape) = query_camera_dtype_shape(core);
+    } else {
+      dt = format.dtype;
+      shape.assign(format.shape, format.shape + format.ndim);
+    }
+    binding_add_bytes(count * format.nbytes);
+    shape.insert(shape.begin(), count);
+  }
+  if (!data) data.reset(new uint8_t[0]);
+  return {create_owned_array(std::move(data), shape, dt), std::move(columns).to_dict()};
+}
+
+///////////////// Copying into caller-provided arrays ///////////////////
+
+std::string dtype_name(nb::dlpack::dtype dt) {
+  std::string kind;
+  switch (static_cast<nb::dlpack::dtype_code>(dt.code)) {
+    case nb::dlpack::dtype_code::Int:
+      kind = "int";
+      break;
+    case nb::dlpack::dtype_code::UInt:
+      kind = "uint";
+      break;
+    case nb::dlpack::dtype_code::Float:
+      kind = "float";
+      break;
+    default:
+      kind = "dtype";
+  }
+  return kind + std::to_string(dt.bits);
+}
+
+template <typename T>
+std::string shape_str(const T* shape, size_t ndim) {
+  std::string s = "(";
+  for (size_t i = 0; i < ndim; ++i) s += (i ? ", " : "") + std::to_string(shape[i]);
+  return s + (ndim == 1 ? ",)" : ")");
+}
+
+/**
+ * @brief Checks that `out` can receive images of the given dtype and shape.
+ *
+ * @param batched If true, `out` must have one extra leading dimension (the frame index).
+ *
+ * @throws nb::type_error If the dtype does not match.
+ * @throws nb::value_error If the shape does not match.
+ */
+void check_output_array(const out_array& out, nb::dlpack::dtype dt,
+                        const std::vector<size_t>& shape, bool batched = false) {
+  if (out.dtype() != dt) {
+    throw nb::type_error(("Output array has dtype " + dtype_name(out.dtype()) + ", expected " +
+                          dtype_name(dt) + ".")
+                             .c_str());
+  }
+  size_t offset = batched ? 1 : 0;
+  bool ok = out.ndim() == shape.size() + offset;
+  for (size_t i = 0; ok && i < shape.size(); ++i) {
+    ok = static_cast<size_t>(out.shape(i + offset)) == shape[i];
+  }
+  if (!ok) {
+    std::string expected = shape_str(shape.data(), shape.size());
+    if (batched) expected = "(n, " + expected.substr(1);
+    throw nb::value_error(("Output array has shape " + shape_str(out.shape_ptr(), out.ndim()) +
+                           ", expected " + expected + ".")
+                              .c_str());
+  }
+}
+
+/**
+ * @brief Copies a C-contiguous frame into a (possibly strided) destination.
+ *
+ * A single `memcpy` is used when the destination is C-contiguous, otherwise the frame is copied
+ * one row (or, if the last axis is strided too, one element) at a time.  Does not need the GIL.
+ *
+ * @param shape, strides Shape and strides (in elements) of the destination, as in `nb::ndarray`.
+ */
+void copy_frame(const void* pSrc, void* pDst, size_t ndim, const int64_t* shape,
+                const int64_t* strides, size_t itemsize) {
+  auto* src = static_cast<const uint8_t*>(pSrc);
+  auto* dst = static_cast<uint8_t*>(pDst);
+
+  bool contiguous = true;
+  int64_t expected = 1;
+  for (size_t d = ndim; d-- > 0;) {
+    if (shape[d] != 1 && strides[d] != expected) contiguous = false;
+    expected *= shape[d];
+  }
+  if (contiguous) {
+    std::memcpy(dst, src, static_cast<size_t>(expected) * itemsize);
+    return;
+  }
+
+  const size_t inner = static_cast<size_t>(shape[ndim - 1]);
+  const int64_t innerStride = strides[ndim - 1] * static_cast<int64_t>(itemsize);
+  const size_t nRows = static_cast<size_t>(expected) / std::max<size_t>(inner, 1);
+  std::vector<int64_t> idx(ndim - 1, 0);
+  for (size_t row = 0; row < nRows; ++row) {
+    int64_t offset = 0;
+    for (size_t d = 0; d + 1 < ndim; ++d) offset += idx[d] * strides[d];
+    uint8_t* pRow = dst + offset * static_cast<int64_t>(itemsize);
+    if (innerStride == static_cast<int64_t>(itemsize)) {
+      std::memcpy(pRow, src, inner * itemsize);
+    } else {
+      for (size_t j = 0; j < inner; ++j) {
+        std::memcpy(pRow + static_cast<int64_t>(j) * innerStride, src + j * itemsize, itemsize);
+      }
+    }
+    src += inner * itemsize;
+    for (size_t d = ndim - 1; d-- > 0;) {  // advance the row index, last axis fastest
+      if (++idx[d] < shape[d]) break;
+      idx[d] = 0;
+    }
+  }
+}
+
+// Copies a C-contiguous frame into `out` (which has been validated by `check_output_array`)
+void copy_frame(const void* pSrc, out_array& out) {
+  copy_frame(pSrc, out.data(), out.ndim(), out.shape_ptr(), out.stride_ptr(), out.itemsize());
+}
+
+// Throws if the next frame in the circular buffer (if any) does not have the given dtype and
+// shape, e.g. an image acquired before a format change.  Call without the GIL.
+void check_next_format(CMMCore& core, nb::dlpack::dtype dt, const std::vector<size_t>& shape) {
+  FrameFormat next;
+  if (peek_next_format(core, next) && !next.equals(dt, shape)) {
+    throw std::runtime_error(
+        "The next image in the circular buffer does not match the current camera format.");
+  }
+}
+
+/**
+ * @brief Fetches an image from `core` with the GIL released and copies it into `out`.
+ *
+ * `out` is validated against the current camera format before `getImage` is called.  If `pops`
+ * is set (i.e. `getImage` pops the circular buffer), the format of the next frame is checked as
+ * well, so a mismatched array or frame never consumes a frame.
+ */
+template <typename Getter>
+void fetch_image_into(CMMCore& core, out_array& out, Getter&& getImage, bool pops = false) {
+  auto [dt, shape] = camera_dtype_shape(core);
+  check_output_array(out, dt, shape);
+  nb::gil_scoped_release gil;
+  if (pops) check_next_format(core, dt, shape);
+  void* pBuf = getImage();
+  copy_frame(pBuf, out);
+  binding_add_bytes(out.nbytes());
+}
+
+/**
+ * @brief Pops frames through the core's image correction into consecutive float32 slices of
+ * `out` (see `pop_next_images_into` and `pop_corrected_images`).
+ */
+std::tuple<size_t, nb::dict> pop_corrected_images_into(CMMCore& core, ImageCorrection& correction,
+                                                       out_array& out) {
+  std::atomic<uint64_t>& popped = core_extras(core).poppedFrames;
+  auto [dt, shape] = camera_dtype_shape(core);
+  const size_t values = get_nbytes(dt, shape) / (dt.bits / 8);
+  check_output_array(out, nb::dtype<float>(), shape, /*batched=*/true);
+
+  FrameColumns columns;
+  size_t count;
+  {
+    nb::gil_scoped_release gil;
+    long remaining = std::max(core.getRemainingImageCount(), 0L);
+    count = std::min(static_cast<size_t>(out.shape(0)),
+                     static_cast<size_t>(remaining) / correction.framesPerOutput());
+    columns.reserve(count);
+
+    auto* pDst = static_cast<uint8_t*>(out.data());
+    const int64_t sliceBytes = out.stride(0) * static_cast<int64_t>(out.itemsize());
+    std::vector<float> frame(values);
+    const ImageCorrection::RawFrame camera{nullptr, dt, values};
+    FrameFormat format;
+    for (size_t i = 0; i < count; ++i) {
+      Metadata md;
+      auto popRaw = [&](size_t) -> ImageCorrection::RawFrame {
+        if (!next_frame_fits(core, camera)) return {};
+        void* pBuf = core.popNextImageMD(md);
+        popped.fetch_add(1, std::memory_order_relaxed);
+        format.update(md);
+        return ImageCorrection::RawFrame::of(pBuf, format);
+      };
+      if (!correction.process(popRaw, frame.data(), values)) {
+        if (i == 0) throw std::runtime_error(kCorrectionFormatMismatch);
+        count = i;
+        break;
+      }
+      uint8_t* pSlice = pDst + static_cast<int64_t>(i) * sliceBytes;
+      copy_frame(frame.data(), pSlice, out.ndim() - 1, out.shape_ptr() + 1, out.stride_ptr() + 1,
+                 out.itemsize());
+      columns.append(md);
+    }
+  }
+  return {count, std::move(columns).to_dict()};
+}
+
+/**
+ * @brief Pops up to `out.shape[0]` images from the circular buffer into consecutive slices of
+ * `out`, with the GIL released.
+ *
+ * The format of the oldest frame is checked against `out` once, before anything is popped (MMCore
+ * keeps only frames of one format in the buffer, see `pop_next_images`); if it does not match,
+ * nothing is popped and an error is raised.  A failure to pop ends the batch early, leaving the
+ * remaining frames in the buffer.
+ *
+ * @return A tuple of the number of images copied and a dict of metadata columns (see
+ *         `FrameColumns`).
+ */
+std::tuple<size_t, nb::dict> pop_next_images_into(CMMCore& core, out_array out) {
+  static BindingStat& stat = binding_stat("popNextImages");
+  BindingTimer timer(stat);
+  if (std::shared_ptr<ImageCorrection> correction = core_extras(core).correction) {
+    return pop_corrected_images_into(core, *correction, out);
+  }
+  std::atomic<uint64_t>& popped = core_extras(core).poppedFrames;
+  auto [dt, shape] = camera_dtype_shape(core);
+  check_output_array(out, dt, shape, /*batched=*/true);
+
+  FrameColumns columns;
+  size_t count;
+  {
+    nb::gil_scoped_release gil;
+    long remaining = core.getRemainingImageCount();
+    count = std::min(static_cast<size_t>(out.shape(0)),
+                     static_cast<size_t>(std::max(remaining, 0L)));
+    columns.reserve(count);
+
+    auto* pDst = static_cast<uint8_t*>(out.data());
+    const int64_t sliceBytes = out.stride(0) * static_cast<int64_t>(out.itemsize());
+    FrameFormat next;
+    if (count > 0 && !peek_next_format(core, next)) count = 0;
+    if (count > 0 && !next.equals(dt, shape)) {
+      throw std::runtime_error(
+          "The next image in the circular buffer does not match the format of out.");
+    }
+    size_t i = 0;
+    try {
+      for (; i < count; ++i) {
+        Metadata md;
+        void* pBuf = core.popNextImageMD(md);
+        popped.fetch_add(1, std::memory_order_relaxed);
+        uint8_t* pSlice = pDst + static_cast<int64_t>(i) * sliceBytes;
+        copy_frame(pBuf, pSlice, out.ndim() - 1, out.shape_ptr() + 1, out.stride_ptr() + 1,
+                   out.itemsize());
+        columns.append(md);
+      }
+    } catch (const std::exception&) {
+      if (i == 0) throw;
+      // return the frames popped so far; the error resurfaces on the next call
+    }
+    count = i;
+  }
+  return {count, std::move(columns).to_dict()};
+}
+
+///////////////// Waiting for frames ///////////////////
+
+/**
+ * @brief Wakes up threads that are waiting for frames in a core's circular buffer.
+ *
+ * The circular buffer has no insertion hook, so a background thread samples it (remaining image
+ * count, whether the sequence has ended) while anyone is waiting or a notification fd is open,
+ * and sleeps otherwise.  Samples are taken every `kInterval` while a sequence is running and
+ * every `kIdleInterval` while none is, so an open fd does not keep a core busy between
+ * sequences; a new waiter triggers a sample right away.  Sampling happens in C++ without the GIL.
+ * Waiters block on a condition variable and are only notified when a sample can satisfy at least
+ * one of them.
+ *
+ * The notification fd (an eventfd on Linux, a pipe on other POSIX systems) is meant for event
+ * loops such as asyncio.  It becomes readable when images are waiting in the buffer or a sequence
+ * has ended.  Signals are coalesced: nothing is written while a previous signal is still unread,
+ * and at most one signal is written per `minInterval`.
+ */
+class BufferWatcher {
+ public:
+  static constexpr std::chrono::microseconds kInterval{500};
+  static constexpr std::chrono::milliseconds kIdleInterval{20};  // while no sequence is running
+
+  explicit BufferWatcher(CMMCore& core) : core_(core), thread_([this] { run(); }) {}
+
+  ~BufferWatcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+    closeFd();
+  }
+
+  BufferWatcher(const BufferWatcher&) = delete;
+  BufferWatcher& operator=(const BufferWatcher&) = delete;
+
+  // Number of samples taken so far.  Read this *before* checking the buffer, and pass it to
+  // `wait` so that samples older than the check cannot satisfy the wait.
+  uint64_t sampleCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sampleCount_;
+  }
+
+  /**
+   * @brief Blocks until a sample taken after `since` shows more than `seenRemaining` images or an
+   * ended sequence, or until `deadline`.
+   *
+   * @return false if the deadline passed first.
+   */
+  bool wait(uint64_t since, long seenRemaining, std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto waiter = waiters_.insert(seenRemaining);
+    kicked_ = true;
+    wake_.notify_all();
+    bool ready = ready_.wait_until(lock, deadline, [&] {
+      return stop_ || (sampleCount_ > since && (ended_ || remaining_ > seenRemaining));
+    });
+    waiters_.erase(waiter);
+    return ready;
+  }
+
+  /**
+   * @brief Opens the notification fd (or updates `minInterval` if it is already open).
+   *
+   * @return The file descriptor to wait on.  It is non-blocking; read up to 8 bytes to reset it.
+   * @throws std::runtime_error If the fd cannot be created, or on Windows.
+   */
+  int openFd(std::chrono::steady_clock::duration minInterval) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    minInterval_ = minInterval;
+    if (readFd_ < 0) {
+#if defined(__linux__)
+      readFd_ = writeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if (readFd_ < 0) throw std::runtime_error("Could not create eventfd.");
+#elif !defined(_WIN32)
+      int fds[2];
+      if (pipe(fds) != 0) throw std::runtime_error("Could not create pipe.");
+      for (int fd : fds) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+      }
+      readFd_ = fds[0];
+      writeFd_ = fds[1];
+#else
+      throw std::runtime_error("Frame-ready notification fds are not supported on Windows.");
+#endif
+      wasEnded_ = true;
+      endPending_ = false;
+      lastSignal_ = {};
+    }
+    kicked_ = true;
+    wake_.notify_all();
+    return readFd_;
+  }
+
+  // Closes the notification fd, if open.
+  void closeFd() {
+#if !defined(_WIN32)
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (readFd_ < 0) return;
+    if (writeFd_ != readFd_) close(writeFd_);
+    close(readFd_);
+    readFd_ = writeFd_ = -1;
+#endif
+  }
+
+ private:
+  // Writes to the notification fd if `remaining`/`ended` call for it (requires `mutex_`)
+  void signalFd(long remaining, bool ended) {
+#if !defined(_WIN32)
+    if (ended && !wasEnded_) endPending_ = true;
+    wasEnded_ = ended;
+    if (remaining <= 0 && !endPending_) return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastSignal_ < minInterval_) return;
+    pollfd pfd{readFd_, POLLIN, 0};
+    if (poll(&pfd, 1, 0) == 0) {  // previous signal has been read
+#if defined(__linux__)
+      uint64_t one = 1;
+#else
+      uint8_t one = 1;
+#endif
+      (void)!write(writeFd_, &one, sizeof(one));
+      lastSignal_ = now;
+    }
+    endPending_ = false;
+#endif
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      if (waiters_.empty() && readFd_ < 0) {
+        wake_.wait(lock);
+        continue;
+      }
+      lock.unlock();
+      bool ended;
+      long remaining;
+      try {
+        // check for the end of the sequence first, so frames inserted before it are counted
+        ended = !core_.isSequenceRunning() || core_.isBufferOverflowed();
+        remaining = core_.getRemainingImageCount();
+      } catch (...) {
+        ended = true;
+        remaining = 0;
+      }
+      lock.lock();
+      ++sampleCount_;
+      ended_ = ended;
+      remaining_ = remaining;
+      if (!waiters_.empty() && (ended || remaining > *waiters_.begin())) ready_.notify_all();
+      if (readFd_ >= 0) signalFd(remaining, ended);
+      kicked_ = false;
+      if (ended) {
+        wake_.wait_for(lock, kIdleInterval, [&] { return stop_ || kicked_; });
+      } else {
+        wake_.wait_for(lock, kInterval, [&] { return stop_; });
+      }
+    }
+  }
+
+  CMMCore& core_;
+  std::mutex mutex_;
+  std::condition_variable wake_;   // wakes the sampling thread
+  std::condition_variable ready_;  // wakes waiters
+  std::multiset<long> waiters_;    // image count each waiter has already seen
+  uint64_t sampleCount_ = 0;
+  long remaining_ = 0;
+  bool ended_ = false;
+  bool stop_ = false;
+  bool kicked_ = false;  // a waiter or fd was added: sample without waiting out the idle interval
+  // notification fd state
+  int readFd_ = -1;
+  int writeFd_ = -1;  // same as readFd_ for an eventfd
+  std::chrono::steady_clock::duration minInterval_{};
+  std::chrono::steady_clock::time_point lastSignal_{};
+  bool wasEnded_ = true;     // whether the previous sample showed an ended sequence
+  bool endPending_ = false;  // a sequence ended but that has not been signaled yet
+  std::thread thread_;  // declared last: started after all other members are initialized
+};
+
+// Get (or start) the buffer watcher for `core`.  Must be called with the GIL held.
+std::shared_ptr<BufferWatcher> buffer_watcher(CMMCore& core) {
+  CoreExtras& extras = core_extras(core);
+  if (!extras.watcher) extras.watcher = std::make_shared<BufferWatcher>(core);
+  return extras.watcher;
+}
+
+// Blocks until the circular buffer holds a frame; returns false if the sequence ended first
+bool wait_for_frame(CMMCore& core, BufferWatcher& watcher) {
+  for (;;) {
+    uint64_t since = watcher.sampleCount();
+    if (core.getRemainingImageCount() > 0) return true;
+    if (!core.isSequenceRunning() || core.isBufferOverflowed()) return false;
+    watcher.wait(since, 0, std::chrono::steady_clock::now() + std::chrono::milliseconds(100));
+  }
+}
+
+/**
+ * @brief Makes one output frame of `correction` in `dst`, popping raw frames with `pop` (which
+ * fills `md`, if given).  Call without the GIL.
+ *
+ * In block-averaging mode, frames after the first are waited for with `watcher` while the
+ * sequence runs; a block cut short by the end of the sequence (or by a frame of another format)
+ * is averaged over the frames it got.  Each frame's format is checked before it is popped.
+ *
+ * @param camera The dtype and size of the current camera format, used for frames without `md`.
+ * @throws std::runtime_error If the next frame does not match `camera`; nothing is popped then.
+ */
+template <typename Getter>
+void pop_corrected_frame(CMMCore& core, ImageCorrection& correction, BufferWatcher* watcher,
+                         Getter& pop, const Metadata* md, ImageCorrection::RawFrame camera,
+                         float* dst) {
+  FrameFormat format;
+  auto popRaw = [&](size_t k) -> ImageCorrection::RawFrame {
+    if (k > 0 && !(watcher && wait_for_frame(core, *watcher))) return {};
+    if (!next_frame_fits(core, camera)) return {};
+    void* pBuf = pop();
+    if (!md) return {pBuf, camera.dtype, camera.values};
+    format.update(*md);
+    return ImageCorrection::RawFrame::of(pBuf, format);
+  };
+  if (!correction.process(popRaw, dst, camera.values)) {
+    throw std::runtime_error(kCorrectionFormatMismatch);
+  }
+}
+
+/**
+ * @brief Pops a frame with `pop` and wraps it in a NumPy array like `fetch_image_array`, applying
+ * the core's image correction if it is enabled.
+ *
+ * With image correction, the result is a float32 array that owns its data, and `md` (if given)
+ * holds the metadata of the last frame that went into it.
+ */
+template <typename Getter>
+ro_np_array fetch_popped_array(CMMCore& core, Getter&& pop, const Metadata* md = nullptr) {
+  auto countedPop = counting_pops(core, std::forward<Getter>(pop));
+  std::shared_ptr<ImageCorrection> correction = core_extras(core).correction;
+  if (!correction) return fetch_image_array(core, countedPop, md);
+
+  std::shared_ptr<BufferWatcher> watcher;
+  if (correction->framesPerOutput() > 1) watcher = buffer_watcher(core);
+  auto [dt, shape] = camera_dtype_shape(core);
+  const size_t values = get_nbytes(dt, shape) / (dt.bits / 8);
+  auto* pData = new std::vector<float>(values);
+  nb::capsule owner(pData, [](void* p) noexcept { delete static_cast<std::vector<float>*>(p); });
+  {
+    nb::gil_scoped_release gil;
+    pop_corrected_frame(core, *correction, watcher.get(), countedPop, md, {nullptr, dt, values},
+                        pData->data());
+    binding_add_bytes(values * sizeof(float));
+  }
+  return ro_np_array(pData->data(), shape.size(), shape.data(), owner, nullptr,
+                     nb::dtype<float>());
+}
+
+// Like `fetch_image_into` for popped frames, applying the core's image correction if it is
+// enabled (in which case `out` must be float32)
+template <typename Getter>
+void fetch_popped_into(CMMCore& core, out_array& out, Getter&& pop, const Metadata* md = nullptr) {
+  auto countedPop = counting_pops(core, std::forward<Getter>(pop));
+  std::shared_ptr<ImageCorrection> correction = core_extras(core).correction;
+  if (!correction) return fetch_image_into(core, out, countedPop, /*pops=*/true);
+
+  std::shared_ptr<BufferWatcher> watcher;
+  if (correction->framesPerOutput() > 1) watcher = buffer_watcher(core);
+  auto [dt, shape] = camera_dtype_shape(core);
+  check_output_array(out, nb::dtype<float>(), shape);
+  const size_t values = get_nbytes(dt, shape) / (dt.bits / 8);
+  nb::gil_scoped_release gil;
+  std::vector<float> frame(values);
+  pop_corrected_frame(core, *correction, watcher.get(), countedPop, md, {nullptr, dt, values},
+                      frame.data());
+  copy_frame(frame.data(), out);
+  binding_add_bytes(out.nbytes());
+}
+
+/**
+ * @brief Iterator over the frames of a running sequence acquisition (see `iterSequence`).
+ *
+ * Each `__next__` blocks with the GIL released until a frame (or a full batch) is available, and
+ * ends the iteration once the sequence has stopped (or the buffer overflowed) and the buffer has
+ * been drained.  With block-averaging image correction, a frame means a complete block of raw
+ * frames; a partial block left at the end of the sequence ends the iteration and stays in the
+ * buffer.  The GIL is re-acquired briefly every `kSignalCheck` to handle Ctrl-C.
+ */
+class SequenceIterator {
+ public:
+  static constexpr std::chrono::milliseconds kSignalCheck{100};
+
+  SequenceIterator(CMMCore& core, double timeoutMs, size_t batch)
+      : core_(core),
+        owner_(nb::cast(core, nb::rv_policy::reference)),
+        watcher_(buffer_watcher(core)),
+        timeoutMs_(timeoutMs),
+        batch_(batch) {}
+
+  nb::object next() {
+    using clock = std::chrono::steady_clock;
+    std::shared_ptr<ImageCorrection> correction = core_extras(core_).correction;
+    // raw frames per returned frame
+    const size_t perOutput = correction ? correction->framesPerOutput() : 1;
+    const size_t want = std::max<size_t>(batch_, 1) * perOutput;
+    const bool forever = timeoutMs_ < 0;
+    const clock::time_point deadline =
+        clock::now() + std::chrono::duration_cast<clock::duration>(
+                           std::chrono::duration<double, std::milli>(forever ? 0 : timeoutMs_));
+    long remaining = 0;
+    bool ended = false;
+    bool overflowed = false;
+    bool timedOut = false;
+    for (bool ready = false; !ready;) {
+      {
+        nb::gil_scoped_release gil;
+        for (;;) {
+          uint64_t since = watcher_->sampleCount();
+          overflowed = core_.isBufferOverflowed();
+          ended = overflowed || !core_.isSequenceRunning();
+          remaining = std::max(core_.getRemainingImageCount(), 0L);
+          if (static_cast<size_t>(remaining) >= want || ended) {
+            ready = true;
+            break;
+          }
+          clock::time_point sliceEnd = clock::now() + kSignalCheck;
+          if (forever || sliceEnd < deadline) {
+            if (!watcher_->wait(since, remaining, sliceEnd)) break;  // check for signals
+          } else if (!watcher_->wait(since, remaining, deadline)) {
+            remaining = std::max(core_.getRemainingImageCount(), 0L);
+            ready = timedOut = true;
+            break;
+          }
+        }
+      }
+      if (!ready && PyErr_CheckSignals() != 0) throw nb::python_error();
+    }
+
+    overflowed_ = overflowed;
+    if (static_cast<size_t>(remaining) < perOutput) {
+      if (ended) throw nb::stop_iteration();
+      PyErr_SetString(PyExc_TimeoutError, "Timed out waiting for the next image.");
+      throw nb::python_error();
+    }
+    // partial batches are only returned once the sequence has ended or the timeout expired
+    if (batch_ == 0) {
+      return nb::cast(fetch_popped_array(core_, [&] { return core_.popNextImage(); }));
+    }
+    size_t n = std::min(static_cast<size_t>(remaining) / perOutput, batch_);
+    return nb::cast(pop_next_images(core_, n));
+  }
+
+  bool overflowed() const { return overflowed_; }
+
+ private:
+  CMMCore& core_;
+  nb::object owner_;  // keeps the core alive
+  std::shared_ptr<BufferWatcher> watcher_;
+  double timeoutMs_;
+  size_t batch_;
+  bool overflowed_ = false;
+};
+
+///////////////// Multi-camera frame sets ///////////////////
+
+/**
+ * @brief Reassembles the interleaved frames of several cameras (or camera channels) into one set
+ * per image number.
+ *
+ * Frames are popped from the circular buffer and filed by image number and camera slot: the
+ * position of their `Camera` tag in `cameras`, else their `CameraChannelIndex` tag, else (without
+ * `cameras`) the order in which camera labels first appear.  Sets are returned in image number
+ * order.  The oldest set is held back until it is complete, unless it can no longer complete:
+ * its missing cameras have moved on to later images, the sequence has ended, or `timeoutMs` has
+ * passed since its first frame (negative = no timeout).  Such a set is then dropped or, with
+ * `partial`, returned with zeros for the missing frames.  A frame whose format differs from the
+ * frames already in its set is counted as unmatched and discarded.  At most `maxPending` sets are
+ * held: a frame that starts another set evicts (drops) the oldest one, complete or not, so a
+ * consumer that falls behind or a camera that never delivers cannot grow memory without bound.
+ *
+ * All state is guarded by `mutex_`, which is taken without the GIL (and never held while waiting
+ * for frames), so `pop` can run concurrently with `stats`, `reset` or another `pop`.
+ */
+class FrameGrouper {
+ public:
+  static constexpr std::chrono::milliseconds kSignalCheck{100};
+
+  FrameGrouper(CMMCore& core, std::optional<std::vector<std::string>> cameras, double timeoutMs,
+               const std::string& policy, size_t maxPending)
+      : core_(core),
+        owner_(nb::cast(core, nb::rv_policy::reference)),
+        watcher_(buffer_watcher(core)),
+        popped_(&core_extras(core).poppedFrames),
+        cameras_(cameras.value_or(std::vector<std::string>())),
+        timeoutMs_(timeoutMs),
+        maxPending_(maxPending) {
+    if (policy != "drop" && policy != "partial") {
+      throw nb::value_error("policy must be 'drop' or 'partial'");
+    }
+    if (maxPending < 1) throw nb::value_error("max_pending must be at least 1");
+    partial_ = policy == "partial";
+    size_t n = cameras_.size();
+    if (!cameras) {
+      nb::gil_scoped_release gil;
+      n = core.getNumberOfCameraChannels();
+    }
+    if (n < 1) throw nb::value_error("At least one camera is required");
+    lastSeen_.assign(n, -1);
+  }
+
+  /**
+   * @brief Returns the next set as a `(ncams, height, width[, components])` array and a dict of
+   * metadata columns with one entry per camera (see `FrameColumns`; missing frames have image
+   * number -1), or None if no set is ready within `waitMs` (negative = wait until the sequence
+   * ends).
+   */
+  nb::object pop(double waitMs) {
+    using clock = std::chrono::steady_clock;
+    const bool forever = waitMs < 0;
+    const clock::time_point deadline =
+        clock::now() + std::chrono::duration_cast<clock::duration>(
+                           std::chrono::duration<double, std::milli>(forever ? 0 : waitMs));
+    Output out;
+    for (bool done = false; !done;) {
+      {
+        nb::gil_scoped_release gil;
+        for (;;) {
+          uint64_t since = watcher_->sampleCount();
+          clock::time_point wake;
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bool ended = drain();
+            clock::time_point now = clock::now();
+            if (takeReady(now, ended, out) || ended || (!forever && now >= deadline)) {
+              done = true;
+              break;
+            }
+            wake = now + kSignalCheck;
+            if (!forever) wake = std::min(wake, deadline);
+            if (timeoutMs_ >= 0 && !pending_.empty()) {
+              wake = std::min(wake, pending_.begin()->second.firstSeen + timeout());
+            }
+          }
+          if (!watcher_->wait(since, 0, wake)) break;  // check for signals
+        }
+      }
+      if (!done && PyErr_CheckSignals() != 0) throw nb::python_error();
+    }
+    if (!out.data) return nb::none();
+    std::vector<size_t> shape(out.format.shape, out.format.shape + out.format.ndim);
+    shape.insert(shape.begin(), lastSeen_.size());
+    return nb::make_tuple(create_owned_array(std::move(out.data), shape, out.format.dtype),
+                          std::move(out.columns).to_dict());
+  }
+
+  // Drops all pending frames (counting them as unmatched) and forgets the camera labels seen
+  void reset() {
+    nb::gil_scoped_release gil;
+    std::lock_guard<std::mutex> lock(mutex_);
+    dropPending();
+    labels_.clear();
+  }
+
+  nb::dict stats() {
+    uint64_t frames, sets, partialSets, droppedSets, evictedSets, unmatched, unassigned;
+    size_t pending;
+    {
+      nb::gil_scoped_release gil;
+      std::lock_guard<std::mutex> lock(mutex_);
+      frames = frames_;
+      sets = sets_;
+      partialSets = partialSets_;
+      droppedSets = droppedSets_;
+      evictedSets = evictedSets_;
+      unmatched = unmatched_;
+      unassigned = unassigned_;
+      pending = pending_.size();
+    }
+    nb::dict d;
+    d["frames"] = frames;
+    d["sets"] = sets;
+    d["partial_sets"] = partialSets;
+    d["dropped_sets"] = droppedSets;
+    d["evicted_sets"] = evictedSets;
+    d["unmatched_frames"] = unmatched;
+    d["unassigned_frames"] = unassigned;
+    d["pending_sets"] = pending;
+    return d;
+  }
+
+  size_t cameras() const { return lastSeen_.size(); }
+
+ private:
+  struct Slot {
+    std::vector<uint8_t> data;  // empty until the frame arrives
+    double elapsedMs = std::numeric_limits<double>::quiet_NaN();
+    std::string camera;
+  };
+
+  struct PendingSet {
+    FrameFormat format;
+    std::vector<Slot> slots;
+    size_t filled = 0;
+    std::chrono::steady_clock::time_point firstSeen;
+  };
+
+  struct Output {
+    std::unique_ptr<uint8_t[]> data;  // null if no set is ready
+    FrameFormat format;
+    FrameColumns columns;
+  };
+
+  // Drops all pending sets, counting their frames as unmatched
+  void dropPending() {
+    for (const auto& [number, set] : pending_) unmatched_ += set.filled;
+    droppedSets_ += pending_.size();
+    pending_.clear();
+    lastSeen_.assign(lastSeen_.size(), -1);
+  }
+
+  // Drops the oldest pending set to make room for a new one
+  void evictOldest() {
+    auto oldest = pending_.begin();
+    unmatched_ += oldest->second.filled;
+    ++droppedSets_;
+    ++evictedSets_;
+    pending_.erase(oldest);
+  }
+
+  std::chrono::steady_clock::duration timeout() const {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::milli>(timeoutMs_));
+  }
+
+  // The camera slot of a frame, or -1 if it belongs to none
+  int slotOf(Metadata& md) {
+    const int n = static_cast<int>(lastSeen_.size());
+    std::string camera;
+    if (md.HasTag(MM::g_Keyword_Metadata_CameraLabel)) {
+      camera = md.GetSingleTag(MM::g_Keyword_Metadata_CameraLabel).GetValue();
+    }
+    auto it = std::find(cameras_.begin(), cameras_.end(), camera);
+    if (it != cameras_.end()) return static_cast<int>(it - cameras_.begin());
+    int64_t index;
+    if (md.HasTag(MM::g_Keyword_CameraChannelIndex) &&
+        parse_int64(md.GetSingleTag(MM::g_Keyword_CameraChannelIndex).GetValue(), index)) {
+      return index >= 0 && index < n ? static_cast<int>(index) : -1;
+    }
+    if (!cameras_.empty() || camera.empty()) return -1;
+    it = std::find(labels_.begin(), labels_.end(), camera);
+    if (it != labels_.end()) return static_cast<int>(it - labels_.begin());
+    if (static_cast<int>(labels_.size()) == n) return -1;
+    labels_.push_back(camera);
+    return static_cast<int>(labels_.size()) - 1;
+  }
+
+  // Files all frames in the buffer; returns whether the sequence has ended with none left.  Call
+  // with `mutex_` held.
+  bool drain() {
+    bool ended = !core_.isSequenceRunning() || core_.isBufferOverflowed();
+    long remaining = std::max(core_.getRemainingImageCount(), 0L);
+    auto now = std::chrono::steady_clock::now();
+    for (long i = 0; i < remaining; ++i) {
+      Metadata md;
+      void* pBuf = core_.popNextImageMD(md);
+      popped_->fetch_add(1, std::memory_order_relaxed);
+      ++frames_;
+      int64_t number = -1;
+      if (md.HasTag(MM::g_Keyword_Metadata_ImageNumber)) {
+        parse_int64(md.GetSingleTag(MM::g_Keyword_Metadata_ImageNumber).GetValue(), number);
+      }
+      int slot = slotOf(md);
+      if (slot < 0 || number < 0) {
+        ++unassigned_;  // unknown camera or no image number
+        continue;
+      }
+      if (number <= lastSeen_[slot]) dropPending();  // a new sequence restarted the numbering
+      lastSeen_[slot] = number;
+
+      format_.update(md);
+      auto found = pending_.find(number);
+      if (found == pending_.end()) {
+        if (pending_.size() >= maxPending_) evictOldest();
+        found = pending_.emplace(number, PendingSet()).first;
+        found->second.slots.resize(lastSeen_.size());
+        found->second.firstSeen = now;
+      }
+      PendingSet& set = found->second;
+      if (set.filled == 0) {
+        set.format = format_;
+      } else if (!set.format.equals(format_)) {
+        ++unmatched_;  // cameras of one set must share a format
+        continue;
+      }
+      Slot& s = set.slots[slot];
+      auto* bytes = static_cast<uint8_t*>(pBuf);
+      s.data.assign(bytes, bytes + format_.nbytes);
+      if (md.HasTag(MM::g_Keyword_Elapsed_Time_ms)) {
+        parse_double(md.GetSingleTag(MM::g_Keyword_Elapsed_Time_ms).GetValue(), s.elapsedMs);
+      }
+      if (md.HasTag(MM::g_Keyword_Metadata_CameraLabel)) {
+        s.camera = md.GetSingleTag(MM::g_Keyword_Metadata_CameraLabel).GetValue();
+      }
+      ++set.filled;
+    }
+    return ended && core_.getRemainingImageCount() <= 0;
+  }
+
+  // Whether the oldest set can no longer complete
+  bool hopeless(int64_t number, const PendingSet& set, std::chrono::steady_clock::time_point now,
+                bool ended) const {
+    if (ended || (timeoutMs_ >= 0 && now - set.firstSeen >= timeout())) return true;
+    for (size_t i = 0; i < set.slots.size(); ++i) {
+      if (set.slots[i].data.empty() && lastSeen_[i] < number) return false;
+    }
+    return true;  // every missing camera is already past this image
+  }
+
+  // Moves the next set to return into `out`, dropping hopeless sets on the way
+  bool takeReady(std::chrono::steady_clock::time_point now, bool ended, Output& out) {
+    while (!pending_.empty()) {
+      auto it = pending_.begin();
+      PendingSet& set = it->second;
+      const bool complete = set.filled == set.slots.size();
+      if (!complete) {
+        if (!hopeless(it->first, set, now, ended)) return false;
+        unmatched_ += set.filled;
+        if (!partial_) {
+          ++droppedSets_;
+          pending_.erase(it);
+          continue;
+        }
+        ++partialSets_;
+      } else {
+        ++sets_;
+      }
+
+      const size_t nbytes = set.format.nbytes;
+      out.format = set.format;
+      out.data.reset(new uint8_t[set.slots.size() * nbytes]());
+      out.columns.reserve(set.slots.size());
+      for (size_t i = 0; i < set.slots.size(); ++i) {
+        const Slot& s = set.slots[i];
+        if (!s.data.empty()) std::memcpy(out.data.get() + i * nbytes, s.data.data(), nbytes);
+        out.columns.imageNumber.push_back(s.data.empty() ? -1 : it->first);
+        out.columns.elapsedTimeMs.push_back(s.elapsedMs);
+        out.columns.camera.push_back(s.camera);
+      }
+      binding_add_bytes(set.slots.size() * nbytes);
+      pending_.erase(it);
+      return true;
+    }
+    return false;
+  }
+
+  CMMCore& core_;
+  nb::object owner_;  // keeps the core alive
+  std::shared_ptr<BufferWatcher> watcher_;
+  std::atomic<uint64_t>* popped_;
+  const std::vector<std::string> cameras_;  // empty: slots by channel index or first appearance
+  const double timeoutMs_;
+  const size_t maxPending_;
+  bool partial_ = false;
+
+  std::mutex mutex_;  // guards everything below
+  std::vector<std::string> labels_;  // camera labels in order of first appearance
+  FrameFormat format_;               // format of the last frame popped
+  std::vector<int64_t> lastSeen_;    // per slot: the latest image number filed
+  std::map<int64_t, PendingSet> pending_;
+  uint64_t frames_ = 0;
+  uint64_t sets_ = 0;
+  uint64_t partialSets_ = 0;
+  uint64_t droppedSets_ = 0;
+  uint64_t evictedSets_ = 0;  // dropped to stay within maxPending_ (included in droppedSets_)
+  uint64_t unmatched_ = 0;
+  uint64_t unassigned_ = 0;
+};
+
+///////////////// Streaming to disk ///////////////////
+
+/**
+ * @brief Header at the start of a stream file written by `StreamWriter`.
+ *
+ * A stream written to `<path>` consists of:
+ *  - `<path>`: this header, zero-padded to `kBytes`, followed by the frames as one C-contiguous
+ *    `(frameCount, *shape)` array, which can be opened with
+ *    `np.memmap(path, dtype, "r", offset=kBytes, shape=(frameCount, *shape))`.
+ *  - `<path>.idx`: one `StreamIndexEntry` per frame (`[("image_number", "<i8"),
+ *    ("elapsed_ms", "<f8")]`).
+ *  - `<path>.jsonl` (optional): all metadata tags of each frame, one JSON object per line.
+ *
+ * All fields use the native (little-endian on all supported platforms) byte order.
+ */
+struct StreamHeader {
+  static constexpr size_t kBytes = 4096;  // keeps the frame data page-aligned
+
+  char magic[8] = {'P', 'M', 'N', 'S', 'T', 'R', 'M', '\0'};
+  uint32_t version = 1;
+  uint32_t headerBytes = kBytes;
+  char dtype[8] = {};  // NumPy dtype string, e.g. "<u2"
+  uint32_t ndim = 0;
+  uint32_t reserved = 0;
+  uint64_t shape[3] = {};
+  uint64_t frameBytes = 0;
+  uint64_t frameCount = 0;  // updated on every flush
+};
+
+struct StreamIndexEntry {
+  int64_t imageNumber;   // -1 if the frame had no image number
+  double elapsedTimeMs;  // NaN if the frame had no elapsed time
+};
+
+// NumPy dtype string (e.g. "<u2") for an unsigned integer dtype
+std::string numpy_dtype_str(nb::dlpack::dtype dt) {
+  size_t itemsize = dt.bits / 8;
+  return std::string(itemsize == 1 ? "|" : "<") + "u" + std::to_string(itemsize);
+}
+
+// Appends `s` to `out` as a JSON string literal
+void append_json_string(std::string& out, const std::string& s) {
+  out += '"';
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+          out += buf;
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+/**
+ * @brief Drains a core's circular buffer to disk on a background thread (see `StreamHeader` for
+ * the file format).
+ *
+ * Frames are popped and copied into a chunk buffer of about `chunkBytes`, which is written with a
+ * single unbuffered `fwrite` once full, together with the index entries (and metadata lines) of
+ * its frames.  The writer thread never takes the GIL; it waits for frames on the core's
+ * `BufferWatcher`.  It finishes on `stop()`, or on its own once it has written at least one frame
+ * and the sequence has ended and the buffer has been drained.
+ */
+class StreamWriter {
+ public:
+  static constexpr std::chrono::milliseconds kPollInterval{20};
+
+  StreamWriter(CMMCore& core, std::string path, size_t chunkBytes, bool metadata)
+      : core_(core),
+        owner_(nb::cast(core, nb::rv_policy::reference)),
+        watcher_(buffer_watcher(core)),
+        path_(std::move(path)),
+        chunkBytes_(std::max<size_t>(chunkBytes, 1)),
+        metadata_(metadata),
+        allocation_(core_extras(core).allocation),
+        allocationStats_(&core_extras(core).allocationStats),
+        popped_(&core_extras(core).poppedFrames) {}
+
+  ~StreamWriter() {
+    if (thread_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRequested_ = true;
+      }
+      nb::gil_scoped_release gil;
+      thread_.join();
+    }
+    closeFiles();
+  }
+
+  StreamWriter(const StreamWriter&) = delete;
+  StreamWriter& operator=(const StreamWriter&) = delete;
+
+  // Opens the output files and starts the writer thread
+  void start() {
+    if (started_) throw std::runtime_error("StreamWriter can only be started once.");
+    data_ = openFile(path_);
+    index_ = openFile(path_ + ".idx");
+    if (metadata_) meta_ = openFile(path_ + ".jsonl");
+    // reserve the header; it is written once the frame format is known
+    std::vector<char> zeros(StreamHeader::kBytes, 0);
+    if (std::fwrite(zeros.data(), 1, zeros.size(), data_) != zeros.size()) {
+      throw std::runtime_error("Could not write to " + path_);
+    }
+    // allocate (and prefault) the chunk for the current camera format up front, so the writer
+    // thread does not page-fault through a fresh chunk while the first frames arrive
+    auto [dt, shape] = camera_dtype_shape(core_);
+    if (size_t frameBytes = get_nbytes(dt, shape)) {
+      size_t capacity = std::max<size_t>(chunkBytes_ / frameBytes, 1);
+      chunk_ = std::make_unique<HostBuffer>(capacity * frameBytes, allocation_, allocationStats_);
+    }
+    started_ = true;
+    running_ = true;
+    startTime_ = std::chrono::steady_clock::now();
+    thread_ = std::thread([this] { run(); });
+  }
+
+  // Writes all remaining frames in the buffer, finalizes the files and stops the writer thread.
+  void stop() {
+    if (thread_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRequested_ = true;
+      }
+      nb::gil_scoped_release gil;
+      thread_.join();
+    }
+    closeFiles();
+    throwIfFailed();
+  }
+
+  // Blocks until all frames popped so far are written and the header is up to date.
+  void flush() {
+    if (!running_) return throwIfFailed();
+    nb::gil_scoped_release gil;
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t target = ++flushRequests_;
+    flushed_.wait(lock, [&] { return flushesDone_ >= target || !running_; });
+    lock.unlock();
+    throwIfFailed();
+  }
+
+  bool running() const { return running_; }
+  uint64_t framesWritten() const { return framesWritten_; }
+  uint64_t bytesWritten() const { return bytesWritten_; }
+
+  // Average throughput since `start()` (or until the writer finished), in MB/s
+  double throughputMBps() const {
+    if (!started_) return 0.0;
+    auto end = running_ ? std::chrono::steady_clock::now() : endTime_.load();
+    double seconds = std::chrono::duration<double>(end - startTime_).count();
+    return seconds > 0 ? bytesWritten_ / seconds / 1e6 : 0.0;
+  }
+
+  std::string error() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+  }
+
+ private:
+  std::FILE* openFile(const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) throw std::runtime_error("Could not open " + path + " for writing.");
+    std::setvbuf(f, nullptr, _IONBF, 0);  // chunks are already large
+    return f;
+  }
+
+  void closeFiles() {
+    for (std::FILE** f : {&data_, &index_, &meta_}) {
+      if (*f) std::fclose(*f);
+      *f = nullptr;
+    }
+  }
+
+  void throwIfFailed() {
+    std::string err = error();
+    if (!err.empty()) throw std::runtime_error("StreamWriter failed: " + err);
+  }
+
+  void write(std::FILE* f, const void* data, size_t nbytes) {
+    if (nbytes && std::fwrite(data, 1, nbytes, f) != nbytes) {
+      throw std::runtime_error("Could not write to " + path_ + ": " + std::strerror(errno));
+    }
+  }
+
+  // Appends the popped frame to the current chunk (writer thread only)
+  void append(void* pBuf, Metadata& md) {
+    if (format_.update(md)) {
+      if (framesWritten_ + chunkFrames_ > 0) {
+        throw std::runtime_error("Image format changed during the sequence.");
+      }
+      chunkCapacity_ = std::max<size_t>(chunkBytes_ / format_.nbytes, 1);
+      if (!chunk_ || chunk_->size() < chunkCapacity_ * format_.nbytes) {
+        // the format differs from the one seen at start(); stats are only touched with the GIL
+        chunk_ = std::make_unique<HostBuffer>(chunkCapacity_ * format_.nbytes, allocation_);
+      }
+      columns_.reserve(chunkCapacity_);
+    }
+    std::memcpy(chunk_->data() + chunkFrames_ * format_.nbytes, pBuf, format_.nbytes);
+    ++chunkFrames_;
+    columns_.append(md);
+    if (metadata_) {
+      std::string& line = metaLines_;
+      line += '{';
+      bool first = true;
+      auto key = [&](const std::string& k) {
+        if (!first) line += ", ";
+        first = false;
+        append_json_string(line, k);
+        line += ": ";
+      };
+      for_each_tag(
+          md,
+          [&](const std::string& k, const std::string& value) {
+            key(k);
+            append_json_string(line, value);
+          },
+          [&](const std::string& k, std::vector<std::string>&& values) {
+            key(k);
+            line += '[';
+            for (size_t i = 0; i < values.size(); ++i) {
+              if (i) line += ", ";
+              append_json_string(line, values[i]);
+            }
+            line += ']';
+          });
+      line += "}\n";
+    }
+    if (chunkFrames_ == chunkCapacity_) writeChunk();
+  }
+
+  // Writes the current chunk, its index entries and metadata lines (writer thread only)
+  void writeChunk() {
+    if (chunkFrames_ == 0) return;
+    write(data_, chunk_->data(), chunkFrames_ * format_.nbytes);
+    std::vector<StreamIndexEntry> entries(chunkFrames_);
+    for (size_t i = 0; i < chunkFrames_; ++i) {
+      entries[i] = {columns_.imageNumber[i], columns_.elapsedTimeMs[i]};
+    }
+    write(index_, entries.data(), entries.size() * sizeof(StreamIndexEntry));
+    if (meta_) write(meta_, metaLines_.data(), metaLines_.size());
+
+    bytesWritten_ += chunkFrames_ * format_.nbytes;
+    framesWritten_ += chunkFrames_;
+    chunkFrames_ = 0;
+    columns_.clear();  // keeps the capacity reserved for a chunk
+    metaLines_.clear();
+  }
+
+  // Rewrites the header with the current format and frame count (writer thread only)
+  void writeHeader() {
+    StreamHeader header;
+    if (format_.nbytes != 0) {
+      std::string dt = numpy_dtype_str(format_.dtype);
+      std::memcpy(header.dtype, dt.c_str(), std::min(dt.size(), sizeof(header.dtype) - 1));
+    }
+    header.ndim = static_cast<uint32_t>(format_.ndim);
+    std::copy(format_.shape, format_.shape + format_.ndim, header.shape);
+    header.frameBytes = format_.nbytes;
+    header.frameCount = framesWritten_;
+    std::fseek(data_, 0, SEEK_SET);
+    write(data_, &header, sizeof(header));
+    std::fseek(data_, 0, SEEK_END);
+  }
+
+  void run() {
+    try {
+      for (;;) {
+        uint64_t since = watcher_->sampleCount();
+        bool stop;
+        uint64_t flushTarget;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          stop = stopRequested_;
+          flushTarget = flushRequests_;
+        }
+        // check for the end of the sequence first, so frames inserted before it are drained
+        bool ended = !core_.isSequenceRunning() || core_.isBufferOverflowed();
+        long remaining = core_.getRemainingImageCount();
+        for (long i = 0; i < remaining; ++i) {
+          Metadata md;
+          void* pBuf = core_.popNextImageMD(md);
+          popped_->fetch_add(1, std::memory_order_relaxed);
+          append(pBuf, md);
+        }
+        // frames that arrive after stop() was called are left in the buffer
+        stop = stop || (ended && remaining <= 0 && framesWritten_ + chunkFrames_ > 0);
+
+        if (stop || flushTarget > flushesDone_) {
+          writeChunk();
+          writeHeader();
+          std::lock_guard<std::mutex> lock(mutex_);
+          flushesDone_ = flushTarget;
+          flushed_.notify_all();
+        }
+        if (stop) break;
+        watcher_->wait(since, 0, std::chrono::steady_clock::now() + kPollInterval);
+      }
+    } catch (const std::exception& e) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = e.what();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    endTime_ = std::chrono::steady_clock::now();
+    running_ = false;
+    flushed_.notify_all();
+  }
+
+  CMMCore& core_;
+  nb::object owner_;  // keeps the core alive
+  std::shared_ptr<BufferWatcher> watcher_;
+  const std::string path_;
+  const size_t chunkBytes_;
+  const bool metadata_;
+  const AllocationOptions allocation_;
+  AllocationStats* allocationStats_;  // owned by the core's extras, kept alive by owner_
+  std::atomic<uint64_t>* popped_;     // likewise
+
+  std::FILE* data_ = nullptr;
+  std::FILE* index_ = nullptr;
+  std::FILE* meta_ = nullptr;
+
+  // writer thread state
+  FrameFormat format_;
+  std::unique_ptr<HostBuffer> chunk_;
+  size_t chunkCapacity_ = 0;
+  size_t chunkFrames_ = 0;
+  FrameColumns columns_;
+  std::string metaLines_;
+
+  // shared state
+  std::mutex mutex_;
+  std::condition_variable flushed_;
+  bool started_ = false;
+  bool stopRequested_ = false;
+  uint64_t flushRequests_ = 0;
+  uint64_t flushesDone_ = 0;
+  std::string error_;
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> framesWritten_{0};
+  std::atomic<uint64_t> bytesWritten_{0};
+  std::chrono::steady_clock::time_point startTime_;
+  std::atomic<std::chrono::steady_clock::time_point> endTime_{};
+  std::thread thread_;
+};
+
+///////////////// Shared-memory frame ring ///////////////////
+
+/**
+ * @brief Header at the start of a shared-memory frame ring (see `SharedFrameRing`).
+ *
+ * Layout of the segment (`/dev/shm/<name>` on Linux):
+ *  - this header, zero-padded to `kBytes`;
+ *  - `slotCount` `SharedSlotHeader`s;
+ *  - `slotCount` frame slots of `slotBytes` each, starting at `dataOffset` (page-aligned).
+ *
+ * Frame `n` (counting from 0 since the ring was started) lives in slot `n % slotCount`.  Its slot
+ * sequence number is odd (`2n + 1`) while the frame is being written and `2n + 2` once complete.
+ * Readers use it as a seqlock: read the sequence number, read the frame, and accept the frame
+ * only if the sequence number is still `2n + 2`.
+ */
+struct SharedRingHeader {
+  static constexpr size_t kBytes = 4096;
+
+  char magic[8] = {'P', 'M', 'N', 'R', 'I', 'N', 'G', '\0'};
+  uint32_t version = 1;
+  uint32_t headerBytes = kBytes;
+  char dtype[8] = {};  // NumPy dtype string, e.g. "<u2"
+  uint32_t ndim = 0;
+  uint32_t slotCount = 0;
+  uint64_t shape[3] = {};
+  uint64_t frameBytes = 0;
+  uint64_t slotBytes = 0;   // frameBytes rounded up to a multiple of 64
+  uint64_t dataOffset = 0;  // offset of slot 0 from the start of the segment
+  std::atomic<uint64_t> writeCount{0};  // number of complete frames published
+};
+
+struct SharedSlotHeader {
+  std::atomic<uint64_t> seq{0};  // seqlock, see `SharedRingHeader`
+  int64_t imageNumber = -1;
+  double elapsedTimeMs = 0;
+  uint8_t padding[40] = {};  // one cache line per slot
+};
+
+static_assert(sizeof(SharedRingHeader) <= SharedRingHeader::kBytes);
+static_assert(sizeof(SharedSlotHeader) == 64);
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the ring is shared between processes and must not rely on a lock");
+
+/**
+ * @brief A POSIX shared-memory mapping, unmapped (and optionally unlinked) on destruction.
+ */
+class SharedMemory {
+ public:
+  // Creates a new segment of `size` bytes (fails if `name` exists)
+  static std::unique_ptr<SharedMemory> create(const std::string& name, size_t size) {
+#if !defined(_WIN32)
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) throw std::runtime_error("Could not create shared memory '" + name + "': " +
+                                         std::strerror(errno));
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      close(fd);
+      shm_unlink(name.c_str());
+      throw std::runtime_error("Could not size shared memory '" + name + "'.");
+    }
+    return map(name, fd, size, PROT_READ | PROT_WRITE, /*owner=*/true);
+#else
+    throw std::runtime_error("Shared-memory frame rings are not supported on Windows.");
+#endif
+  }
+
+  // Maps an existing segment read-only
+  static std::unique_ptr<SharedMemory> open(const std::string& name) {
+#if !defined(_WIN32)
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) throw std::runtime_error("Could not open shared memory '" + name + "': " +
+                                         std::strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < SharedRingHeader::kBytes) {
+      close(fd);
+      throw std::runtime_error("'" + name + "' is not a frame ring.");
+    }
+    return map(name, fd, static_cast<size_t>(st.st_size), PROT_READ, /*owner=*/false);
+#else
+    throw std::runtime_error("Shared-memory frame rings are not supported on Windows.");
+#endif
+  }
+
+  ~SharedMemory() {
+#if !defined(_WIN32)
+    munmap(data_, size_);
+    if (owner_) shm_unlink(name_.c_str());
+#endif
+  }
+
+  uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+  const std::string& name() const { return name_; }
+
+ private:
+  SharedMemory(std::string name, uint8_t* data, size_t size, bool owner)
+      : name_(std::move(name)), data_(data), size_(size), owner_(owner) {}
+
+#if !defined(_WIN32)
+  static std::unique_ptr<SharedMemory> map(const std::string& name, int fd, size_t size,
+                                           int prot, bool owner) {
+    void* p = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+      if (owner) shm_unlink(name.c_str());
+      throw std::runtime_error("Could not map shared memory '" + name + "'.");
+    }
+    return std::unique_ptr<SharedMemory>(
+        new SharedMemory(name, static_cast<uint8_t*>(p), size, owner));
+  }
+#endif
+
+  std::string name_;
+  uint8_t* data_;
+  size_t size_;
+  bool owner_;  // unlink the name on destruction
+};
+
+/**
+ * @brief Publishes the frames of a core's circular buffer into a named shared-memory ring that
+ * other processes can map read-only (see `SharedRingHeader` and `SharedFrameReader`).
+ *
+ * Like `StreamWriter`, frames are popped on a background thread that waits on the core's
+ * `BufferWatcher` and never takes the GIL.  Popping makes the ring the core's consumer: frames it
+ * publishes are gone from the circular buffer, so in-process consumers (`popNextImage`,
+ * `iterSequence`, a `StreamWriter`, ...) running at the same time only see the frames the ring
+ * did not get to first.  The ring format is fixed to the camera format at `start()`; a frame of
+ * another format stops the publisher with an error.  The segment name is unlinked on `stop()`;
+ * readers that have already attached keep their mapping.
+ */
+class SharedFrameRing {
+ public:
+  static constexpr std::chrono::milliseconds kPollInterval{20};
+
+  SharedFrameRing(CMMCore& core, std::string name, uint32_t slotCount)
+      : core_(core),
+        owner_(nb::cast(core, nb::rv_policy::reference)),
+        watcher_(buffer_watcher(core)),
+        name_(std::move(name)),
+        slotCount_(slotCount),
+        allocation_(core_extras(core).allocation),
+        allocationStats_(&core_extras(core).allocationStats),
+        popped_(&core_extras(core).poppedFrames) {
+    if (slotCount_ == 0) throw nb::value_error("slots must be at least 1");
+  }
+
+  ~SharedFrameRing() { join(); }
+
+  SharedFrameRing(const SharedFrameRing&) = delete;
+  SharedFrameRing& operator=(const SharedFrameRing&) = delete;
+
+  // Creates the segment for the current camera format and starts publishing frames
+  void start() {
+    if (shm_) throw std::runtime_error("SharedFrameRing can only be started once.");
+    auto [dt, shape] = camera_dtype_shape(core_);
+    dtype_ = dt;
+    shape_ = shape;
+    size_t frameBytes = get_nbytes(dt, shape);
+    size_t slotBytes = (frameBytes + 63) / 64 * 64;
+    size_t dataOffset = SharedRingHeader::kBytes + slotCount_ * sizeof(SharedSlotHeader);
+    dataOffset = (dataOffset + 4095) / 4096 * 4096;
+
+    size_t size = dataOffset + slotCount_ * slotBytes;
+    auto t0 = std::chrono::steady_clock::now();
+    shm_ = SharedMemory::create(name_, size);
+    double allocMs = elapsed_ms(t0);
+    // shared mappings are backed by the shm filesystem, so hugepages do not apply here; just
+    // make sure every page of the segment exists before frames start arriving
+    t0 = std::chrono::steady_clock::now();
+    if (allocation_.prefault) {
+      volatile uint8_t* v = shm_->data();
+      for (size_t i = 0; i < size; i += HostBuffer::kPageBytes) v[i] = 0;
+    }
+    ++allocationStats_->buffers;
+    allocationStats_->bytes += size;
+    allocationStats_->allocMs += allocMs;
+    allocationStats_->faultMs += elapsed_ms(t0);
+    header_ = new (shm_->data()) SharedRingHeader();
+    std::string dts = numpy_dtype_str(dt);
+    std::memcpy(header_->dtype, dts.c_str(), std::min(dts.size(), sizeof(header_->dtype) - 1));
+    header_->ndim = static_cast<uint32_t>(shape.size());
+    std::copy(shape.begin(), shape.end(), header_->shape);
+    header_->slotCount = slotCount_;
+    header_->frameBytes = frameBytes;
+    header_->slotBytes = slotBytes;
+    header_->dataOffset = dataOffset;
+    slots_ = new (shm_->data() + SharedRingHeader::kBytes) SharedSlotHeader[slotCount_];
+
+    running_ = true;
+    thread_ = std::thread([this] { run(); });
+  }
+
+  // Stops publishing and unlinks the segment name
+  void stop() {
+    join();
+    if (header_) publishedAtStop_ = header_->writeCount.load();
+    header_ = nullptr;
+    slots_ = nullptr;
+    shm_.reset();
+    std::string err = error();
+    if (!err.empty()) throw std::runtime_error("SharedFrameRing failed: " + err);
+  }
+
+  const std::string& name() const { return name_; }
+  bool running() const { return running_; }
+  uint64_t framesPublished() const {
+    return header_ ? header_->writeCount.load() : publishedAtStop_;
+  }
+
+  std::string error() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+  }
+
+ private:
+  void join() {
+    if (!thread_.joinable()) return;
+    stopRequested_ = true;
+    nb::gil_scoped_release gil;
+    thread_.join();
+  }
+
+  // Copies one frame into the next slot, bracketed by the slot's seqlock (publisher thread only)
+  void publish(const void* pBuf, Metadata& md) {
+    if (format_.update(md) && !format_.equals(dtype_, shape_)) {
+      throw std::runtime_error("Image format does not match the format of the ring.");
+    }
+    uint64_t n = header_->writeCount.load(std::memory_order_relaxed);
+    SharedSlotHeader& slot = slots_[n % slotCount_];
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(shm_->data() + header_->dataOffset + (n % slotCount_) * header_->slotBytes, pBuf,
+                header_->frameBytes);
+    columns_.clear();
+    columns_.append(md);
+    slot.imageNumber = columns_.imageNumber[0];
+    slot.elapsedTimeMs = columns_.elapsedTimeMs[0];
+
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    header_->writeCount.store(n + 1, std::memory_order_release);
+  }
+
+  void run() {
+    try {
+      while (!stopRequested_) {
+        uint64_t since = watcher_->sampleCount();
+        long remaining = core_.getRemainingImageCount();
+        for (long i = 0; i < remaining; ++i) {
+          Metadata md;
+          void* pBuf = core_.popNextImageMD(md);
+          popped_->fetch_add(1, std::memory_order_relaxed);
+          publish(pBuf, md);
+        }
+        watcher_->wait(since, 0, std::chrono::steady_clock::now() + kPollInterval);
+      }
+    } catch (const std::exception& e) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = e.what();
+    }
+    running_ = false;
+  }
+
+  CMMCore& core_;
+  nb::object owner_;  // keeps the core alive
+  std::shared_ptr<BufferWatcher> watcher_;
+  const std::string name_;
+  const uint32_t slotCount_;
+  const AllocationOptions allocation_;
+  AllocationStats* allocationStats_;  // owned by the core's extras, kept alive by owner_
+  std::atomic<uint64_t>* popped_;     // likewise
+
+  std::unique_ptr<SharedMemory> shm_;
+  SharedRingHeader* header_ = nullptr;
+  SharedSlotHeader* slots_ = nullptr;
+  uint64_t publishedAtStop_ = 0;  // the write count once the segment is gone
+  nb::dlpack::dtype dtype_{};
+  std::vector<size_t> shape_;
+  FrameFormat format_;
+  FrameColumns columns_;
+
+  std::mutex mutex_;
+  std::string error_;
+  std::atomic<bool> stopRequested_{false};
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
+
+/**
+ * @brief Read-only view of a shared-memory frame ring published by another process (or this one).
+ */
+class SharedFrameReader {
+ public:
+  explicit SharedFrameReader(const std::string& name) : shm_(SharedMemory::open(name)) {
+    header_ = reinterpret_cast<const SharedRingHeader*>(shm_->data());
+    if (std::memcmp(header_->magic, "PMNRING", 8) != 0 || header_->version != 1) {
+      throw std::runtime_error("'" + name + "' is not a frame ring.");
+    }
+    if (shm_->size() < header_->dataOffset + header_->slotCount * header_->slotBytes) {
+      throw std::runtime_error("Frame ring '" + name + "' is truncated.");
+    }
+    slots_ = reinterpret_cast<const SharedSlotHeader*>(shm_->data() + SharedRingHeader::kBytes);
+    switch (header_->dtype[2]) {  // "|u1", "<u2" or "<u4"
+      case '1':
+        dtype_ = nb::dtype<uint8_t>();
+        break;
+      case '2':
+        dtype_ = nb::dtype<uint16_t>();
+        break;
+      default:
+        dtype_ = nb::dtype<uint32_t>();
+    }
+  }
+
+  uint64_t writeCount() const { return header_->writeCount.load(std::memory_order_acquire); }
+  uint32_t slotCount() const { return header_->slotCount; }
+  std::vector<size_t> shape() const {
+    return std::vector<size_t>(header_->shape, header_->shape + header_->ndim);
+  }
+  std::string dtype() const { return header_->dtype; }
+
+  // Sequence number of frame `n` once complete
+  static uint64_t token(uint64_t n) { return 2 * n + 2; }
+
+  // Whether frame `n` is still intact in its slot
+  bool isValid(uint64_t n) const {
+    return slot(n).seq.load(std::memory_order_acquire) == token(n);
+  }
+
+  /**
+   * @brief Zero-copy view of frame `n`.  The view is only guaranteed to show frame `n` while
+   * `isValid(n)`; check it after using the data.
+   *
+   * @throws nb::index_error If frame `n` has not been published yet or was already overwritten.
+   */
+  ro_np_array view(nb::handle owner, uint64_t n) const {
+    if (!isValid(n)) throw notInRing(n);
+    std::vector<size_t> shp = shape();
+    return ro_np_array(framePtr(n), shp.size(), shp.data(), owner, nullptr, dtype_);
+  }
+
+  /**
+   * @brief Copies frame `n` out of the ring, validating it with the slot's seqlock.
+   *
+   * @return A tuple of the image, its image number and its elapsed time (ms).
+   * @throws nb::index_error If frame `n` is not (or no longer) in the ring.
+   */
+  std::tuple<np_array, int64_t, double> read(uint64_t n) const {
+    const SharedSlotHeader& s = slot(n);
+    std::vector<size_t> shp = shape();
+    std::unique_ptr<uint8_t[]> data(new uint8_t[header_->frameBytes]);
+    int64_t imageNumber = -1;
+    double elapsedTimeMs = 0;
+    bool intact = false;
+    {
+      nb::gil_scoped_release gil;
+      if (s.seq.load(std::memory_order_acquire) == token(n)) {
+        std::memcpy(data.get(), framePtr(n), header_->frameBytes);
+        imageNumber = s.imageNumber;
+        elapsedTimeMs = s.elapsedTimeMs;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        intact = s.seq.load(std::memory_order_relaxed) == token(n);
+      }
+    }
+    if (!intact) throw notInRing(n);
+    return {create_owned_array(std::move(data), shp, dtype_), imageNumber, elapsedTimeMs};
+  }
+
+ private:
+  static nb::index_error notInRing(uint64_t n) {
+    return nb::index_error(("Frame " + std::to_string(n) + " is not in the ring.").c_str());
+  }
+
+  const SharedSlotHeader& slot(uint64_t n) const { return slots_[n % header_->slotCount]; }
+  const uint8_t* framePtr(uint64_t n) const {
+    return shm_->data() + header_->dataOffset + (n % header_->slotCount) * header_->slotBytes;
+  }
+
+  std::unique_ptr<SharedMemory> shm_;
+  const SharedRingHeader* header_;
+  const SharedSlotHeader* slots_;
+  nb::dlpack::dtype dtype_;
+};
+
+///////////////// Acquisition health ///////////////////
+
+/**
+ * @brief Rolling statistics of the current (or last) sequence acquisition of a core.
+ *
+ * The circular buffer offers no insertion hook, so a monitor thread samples it every `kInterval`,
+ * reading back only the metadata of the newest frame so as not to compete with the camera for the
+ * buffer.  Insertions are counted from its image number, and insertion times are taken from its
+ * `ElapsedTime-ms` tag (stamped by the circular buffer on insertion unless the camera provides
+ * it).  Only the newest frame's time is known, so per-frame intervals (and thus camera jitter)
+ * cannot be measured: the monitor records the mean interval of the frames inserted during each
+ * sample ("window") instead, and reports the spread of those window means, weighted by the number
+ * of frames each spans.  Jitter between the frames of one window averages out.
+ *
+ * Pops are counted by the bindings (`CoreExtras::poppedFrames`), so frames that leave the buffer
+ * without being popped (e.g. when a camera clears it on overflow) show up as dropped.
+ *
+ * A new sequence is detected from a start through the bindings (`CoreExtras::sequenceStarts`),
+ * which catches sequences shorter than a sample, or else from the `isSequenceRunning` edge or
+ * the image number going backwards.
+ */
+class AcquisitionMonitor {
+ public:
+  static constexpr std::chrono::milliseconds kInterval{20};
+  static constexpr std::chrono::seconds kRecentWindow{1};
+
+  AcquisitionMonitor(CMMCore& core, std::atomic<uint64_t>& popped, std::atomic<uint64_t>& starts,
+                     double nearOverflow)
+      : core_(core),
+        popped_(popped),
+        starts_(starts),
+        nearOverflow_(nearOverflow),
+        lastStarts_(starts.load(std::memory_order_relaxed)),
+        thread_([this] { run(); }) {}
+
+  ~AcquisitionMonitor() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+  }
+
+  AcquisitionMonitor(const AcquisitionMonitor&) = delete;
+  AcquisitionMonitor& operator=(const AcquisitionMonitor&) = delete;
+
+  void setNearOverflow(double fraction) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nearOverflow_ = fraction;
+  }
+
+  struct Health {
+    bool running = false;
+    double elapsedS = 0;
+    uint64_t inserted = 0;
+    uint64_t popped = 0;
+    uint64_t dropped = 0;
+    long remaining = 0;
+    long capacity = 0;
+    long maxOccupancy = 0;
+    double insertRateHz = 0;
+    double popRateHz = 0;
+    double recentInsertRateHz = 0;
+    double recentPopRateHz = 0;
+    double firstNearOverflowS = -1;  // < 0 if it never happened
+    bool overflowed = false;
+    double overflowS = -1;
+    // mean inter-frame interval of each sample window, weighted by its frame count (Welford's
+    // running mean and variance); the mean equals the overall mean interval
+    uint64_t intervals = 0;
+    double intervalMeanMs = 0;
+    double windowMeanM2 = 0;
+    double windowMeanMinMs = 0;
+    double windowMeanMaxMs = 0;
+  };
+
+  Health health() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return health_;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Sample {
+    Clock::time_point time;
+    uint64_t inserted;
+    uint64_t popped;
+  };
+
+  // Image number and elapsed time of the newest frame
+  static bool read_newest(CMMCore& core, int64_t& number, double& elapsedMs) {
+    Metadata md;
+    try {
+      core.getLastImageMD(md);
+      return parse_int64(md.GetSingleTag(MM::g_Keyword_Metadata_ImageNumber).GetValue(),
+                         number) &&
+             parse_double(md.GetSingleTag(MM::g_Keyword_Elapsed_Time_ms).GetValue(), elapsedMs);
+    } catch (...) {
+      return false;
+    }
+  }
+
+  void startSequence(Clock::time_point now) {
+    health_ = Health();
+    health_.running = true;
+    start_ = now;
+    poppedBase_ = popped_.load(std::memory_order_relaxed);
+    lastNumber_ = -1;
+    lastElapsedMs_ = std::numeric_limits<double>::quiet_NaN();
+    recent_.clear();
+  }
+
+  // Adds a sample window of `count` intervals with a mean of `ms`
+  void addWindow(double ms, uint64_t count) {
+    Health& h = health_;
+    bool first = h.intervals == 0;
+    h.intervals += count;
+    double delta = ms - h.intervalMeanMs;
+    h.intervalMeanMs += delta * count / h.intervals;
+    h.windowMeanM2 += delta * (ms - h.intervalMeanMs) * count;
+    h.windowMeanMinMs = first ? ms : std::min(h.windowMeanMinMs, ms);
+    h.windowMeanMaxMs = first ? ms : std::max(h.windowMeanMaxMs, ms);
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool wasRunning = false;
+    while (!stop_) {
+      lock.unlock();
+      Clock::time_point now = Clock::now();
+      // before reading the buffer, so that frames read here never predate a start counted here
+      uint64_t starts = starts_.load(std::memory_order_relaxed);
+      bool running, overflowed;
+      long remaining, capacity;
+      try {
+        running = core_.isSequenceRunning();
+        overflowed = core_.isBufferOverflowed();
+        remaining = core_.getRemainingImageCount();
+        capacity = core_.getBufferTotalCapacity();
+      } catch (...) {
+        running = overflowed = false;
+        remaining = capacity = 0;
+      }
+      int64_t number = -1;
+      double elapsedMs = 0;
+      bool haveFrame = read_newest(core_, number, elapsedMs);
+      lock.lock();
+
+      if (starts != lastStarts_ || (running && !wasRunning) ||
+          (haveFrame && number < lastNumber_)) {
+        startSequence(now);
+      }
+      lastStarts_ = starts;
+      wasRunning = running;
+      Health& h = health_;
+      h.running = running;
+      if (!h.running && h.inserted == 0 && !haveFrame) {
+        wake_.wait_for(lock, kInterval, [&] { return stop_; });
+        continue;
+      }
+
+      if (haveFrame && number > lastNumber_) {
+        if (lastNumber_ >= 0 && !std::isnan(lastElapsedMs_)) {
+          uint64_t count = static_cast<uint64_t>(number - lastNumber_);
+          addWindow((elapsedMs - lastElapsedMs_) / count, count);
+        }
+        lastElapsedMs_ = elapsedMs;
+        lastNumber_ = number;
+        h.inserted = static_cast<uint64_t>(number + 1);
+      }
+
+      if (h.running) h.elapsedS = std::chrono::duration<double>(now - start_).count();
+      h.popped = popped_.load(std::memory_order_relaxed) - poppedBase_;
+      h.remaining = remaining;
+      h.capacity = capacity;
+      h.dropped = h.inserted > h.popped + remaining ? h.inserted - h.popped - remaining : 0;
+      h.maxOccupancy = std::max(h.maxOccupancy, remaining);
+      if (h.firstNearOverflowS < 0 && capacity > 0 && remaining >= nearOverflow_ * capacity) {
+        h.firstNearOverflowS = h.elapsedS;
+      }
+      if (overflowed && !h.overflowed) h.overflowS = h.elapsedS;
+      h.overflowed = overflowed;
+      if (h.elapsedS > 0) {
+        h.insertRateHz = h.inserted / h.elapsedS;
+        h.popRateHz = h.popped / h.elapsedS;
+      }
+      recent_.push_back({now, h.inserted, h.popped});
+      while (recent_.size() > 2 && now - recent_[1].time >= kRecentWindow) recent_.pop_front();
+      double windowS = std::chrono::duration<double>(now - recent_.front().time).count();
+      if (windowS > 0) {
+        h.recentInsertRateHz = (h.inserted - recent_.front().inserted) / windowS;
+        h.recentPopRateHz = (h.popped - recent_.front().popped) / windowS;
+      }
+
+      wake_.wait_for(lock, kInterval, [&] { return stop_; });
+    }
+  }
+
+  CMMCore& core_;
+  std::atomic<uint64_t>& popped_;
+  std::atomic<uint64_t>& starts_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  double nearOverflow_;
+  uint64_t lastStarts_;
+  bool stop_ = false;
+  Health health_;
+  Clock::time_point start_ = Clock::now();
+  uint64_t poppedBase_ = 0;
+  int64_t lastNumber_ = -1;
+  double lastElapsedMs_ = std::numeric_limits<double>::quiet_NaN();
+  std::deque<Sample> recent_;
+  std::thread thread_;  // declared last: started after all other members are initialized
+};
+
+///////////////// Live preview ///////////////////
+
+/**
+ * @brief Renders the newest frame of the circular buffer into an 8-bit display image on a
+ * background thread, at most `maxRateHz` times per second.
+ *
+ * Each render bins (averages) or decimates the frame by the smallest integer factor that fits it
+ * into `maxWidth` x `maxHeight`, takes the min/max and a histogram of the result, and maps the
+ * `lowPercentile` to `highPercentile` range linearly onto 0-255.  RGB frames use one range for
+ * all channels and come out as (h, w, 3) RGB.  Only the newest frame is read and nothing is
+ * popped, so a slow display never backs up acquisition.  The inner loops run branch-free over
+ * contiguous rows, so that the compiler can vectorize them.
+ *
+ * Frames are rendered into a back buffer that is swapped with the front buffer under the mutex,
+ * so `read` always copies a complete image and rendering never waits for the reader.
+ *
+ * @note Like `getLastImage`, the frame is read in place, so a camera that wraps around the
+ * circular buffer while a frame is rendered may tear that preview frame.
+ */
+class LivePreview {
+ public:
+  static constexpr size_t kHistogramBins = 256;
+  static constexpr std::chrono::milliseconds kPollInterval{2};  // while waiting for a new frame
+
+  LivePreview(CMMCore& core, double maxRateHz, size_t maxWidth, size_t maxHeight, bool binning,
+              double lowPercentile, double highPercentile)
+      : core_(core),
+        owner_(nb::cast(core, nb::rv_policy::reference)),
+        binning_(binning),
+        maxWidth_(maxWidth),
+        maxHeight_(maxHeight) {
+    if (!(maxRateHz > 0)) throw nb::value_error("max_rate_hz must be positive");
+    if (maxWidth == 0 || maxHeight == 0) {
+      throw nb::value_error("max_width and max_height must be at least 1");
+    }
+    period_ = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / maxRateHz));
+    setPercentiles(lowPercentile, highPercentile);
+  }
+
+  ~LivePreview() { join(); }
+
+  LivePreview(const LivePreview&) = delete;
+  LivePreview& operator=(const LivePreview&) = delete;
+
+  void start() {
+    if (thread_.joinable()) throw std::runtime_error("LivePreview can only be started once.");
+    running_ = true;
+    thread_ = std::thread([this] { run(); });
+  }
+
+  void stop() {
+    join();
+    std::string err = error();
+    if (!err.empty()) throw std::runtime_error("LivePreview failed: " + err);
+  }
+
+  void setPercentiles(double low, double high) {
+    if (!(0 <= low && low < high && high <= 100)) {
+      throw nb::value_error("Percentiles must satisfy 0 <= low < high <= 100");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    lowPercentile_ = low;
+    highPercentile_ = high;
+  }
+
+  bool running() const { return running_; }
+
+  std::string error() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+  }
+
+  // Copies the latest display image into a new array, or returns None before the first frame
+  // has been rendered.  Must be called with the GIL held.
+  nb::object read() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Display& d = front_;
+    if (d.image.empty()) return nb::none();
+    std::vector<size_t> shape(d.shape, d.shape + d.ndim);
+    auto data = std::make_unique<uint8_t[]>(d.image.size());
+    std::memcpy(data.get(), d.image.data(), d.image.size());
+    return nb::cast(create_owned_array(std::move(data), shape, nb::dtype<uint8_t>()));
+  }
+
+  // Copies the latest display image into `out`; returns false before the first frame
+  bool readInto(out_array& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Display& d = front_;
+    if (d.image.empty()) return false;
+    check_output_array(out, nb::dtype<uint8_t>(), std::vector<size_t>(d.shape, d.shape + d.ndim));
+    copy_frame(d.image.data(), out);
+    return true;
+  }
+
+  nb::dict stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Display& d = front_;
+    nb::dict s;
+    s["frames_rendered"] = rendered_;
+    s["frames_skipped"] = skipped_;
+    s["image_number"] = d.imageNumber;
+    s["shape"] = std::vector<size_t>(d.shape, d.shape + d.ndim);
+    s["bin_factor"] = d.binFactor;
+    s["min"] = d.min;
+    s["max"] = d.max;
+    s["display_min"] = d.low;
+    s["display_max"] = d.high;
+    s["histogram"] = create_column_array(std::vector<uint64_t>(d.histogram));
+    s["render_ms"] = d.renderMs;
+    return s;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Display {
+    std::vector<uint8_t> image;
+    size_t ndim = 0;
+    size_t shape[3] = {0, 0, 0};
+    int64_t imageNumber = -1;
+    size_t binFactor = 1;
+    double min = 0, max = 0;   // of the binned frame, in camera units
+    double low = 0, high = 0;  // range mapped onto 0-255
+    std::vector<uint64_t> histogram = std::vector<uint64_t>(kHistogramBins);  // over [min, max]
+    double renderMs = 0;
+  };
+
+  void join() {
+    if (!thread_.joinable()) return;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopRequested_ = true;
+    }
+    wake_.notify_all();
+    nb::gil_scoped_release gil;
+    thread_.join();
+  }
+
+  // Value of the given percentile, interpolated within the bins of `d.histogram`
+  static double percentile(const Display& d, size_t count, double p) {
+    double target = p / 100 * count;
+    double binWidth = (d.max - d.min) / kHistogramBins;
+    double cumulative = 0;
+    for (size_t b = 0; b < kHistogramBins; ++b) {
+      double n = static_cast<double>(d.histogram[b]);
+      if (n > 0 && cumulative + n >= target) {
+        return d.min + (b + std::max(0.0, target - cumulative) / n) * binWidth;
+      }
+      cumulative += n;
+    }
+    return d.max;
+  }
+
+  // Bins or decimates `src` into `values_`, then fills everything in `d` but the frame number
+  template <typename T>
+  void render(const T* src, size_t width, size_t height, size_t channels, Display& d) {
+    size_t f = std::max({size_t{1}, (width + maxWidth_ - 1) / maxWidth_,
+                         (height + maxHeight_ - 1) / maxHeight_});
+    f = std::min({f, width, height});
+    const size_t ow = width / f, oh = height / f;
+    const size_t outChannels = channels == 1 ? 1 : 3;
+    const size_t rowValues = ow * outChannels;
+    values_.resize(oh * rowValues);
+    auto channel = [&](size_t c) { return channels == 1 ? 0 : 2 - c; };  // BGRA -> RGB
+
+    if (binning_ && f > 1) {
+      const size_t rowLength = ow * f * channels;
+      const float scale = 1.0f / static_cast<float>(f * f);
+      rowSum_.resize(rowLength);
+      for (size_t oy = 0; oy < oh; ++oy) {
+        float* sum = rowSum_.data();
+        std::fill(sum, sum + rowLength, 0.0f);
+        for (size_t r = 0; r < f; ++r) {
+          const T* row = src + (oy * f + r) * width * channels;
+          for (size_t i = 0; i < rowLength; ++i) sum[i] += static_cast<float>(row[i]);
+        }
+        float* out = values_.data() + oy * rowValues;
+        for (size_t ox = 0; ox < ow; ++ox) {
+          for (size_t c = 0; c < outChannels; ++c) {
+            const float* block = sum + ox * f * channels + channel(c);
+            float acc = 0;
+            for (size_t k = 0; k < f; ++k) acc += block[k * channels];
+            out[ox * outChannels + c] = acc * scale;
+          }
+        }
+      }
+    } else {
+      for (size_t oy = 0; oy < oh; ++oy) {
+        const T* row = src + oy * f * width * channels;
+        float* out = values_.data() + oy * rowValues;
+        for (size_t ox = 0; ox < ow; ++ox) {
+          for (size_t c = 0; c < outChannels; ++c) {
+            out[ox * outChannels + c] = static_cast<float>(row[ox * f * channels + channel(c)]);
+          }
+        }
+      }
+    }
+
+    const float* v = values_.data();
+    const size_t n = values_.size();
+    float lo = v[0], hi = v[0];
+    for (size_t i = 0; i < n; ++i) {
+      lo = v[i] < lo ? v[i] : lo;
+      hi = v[i] > hi ? v[i] : hi;
+    }
+
+    std::fill(d.histogram.begin(), d.histogram.end(), 0);
+    const float binScale = hi > lo ? kHistogramBins / (hi - lo) : 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+      size_t b = static_cast<size_t>((v[i] - lo) * binScale);
+      ++d.histogram[std::min(b, kHistogramBins - 1)];
+    }
+    d.min = lo;
+    d.max = hi;
+    double lowPercentile, highPercentile;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      lowPercentile = lowPercentile_;
+      highPercentile = highPercentile_;
+    }
+    d.low = percentile(d, n, lowPercentile);
+    d.high = std::max(percentile(d, n, highPercentile), d.low);
+
+    d.image.resize(n);
+    uint8_t* out = d.image.data();
+    const float offset = static_cast<float>(d.low);
+    const float gain = d.high > d.low ? static_cast<float>(255.0 / (d.high - d.low)) : 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+      float x = (v[i] - offset) * gain;
+      x = x < 0.0f ? 0.0f : (x > 255.0f ? 255.0f : x);
+      out[i] = static_cast<uint8_t>(x + 0.5f);
+    }
+    d.ndim = outChannels == 1 ? 2 : 3;
+    d.shape[0] = oh;
+    d.shape[1] = ow;
+    d.shape[2] = outChannels;
+    d.binFactor = f;
+  }
+
+  // Renders the newest frame if it has not been rendered yet; returns false otherwise
+  bool renderNewest() {
+    Metadata md;
+    const void* pBuf;
+    try {
+      pBuf = core_.getLastImageMD(md);
+    } catch (const CMMError&) {
+      return false;  // the buffer is empty
+    }
+    int64_t number = -1;
+    std::string elapsed;
+    if (md.HasTag(MM::g_Keyword_Metadata_ImageNumber)) {
+      parse_int64(md.GetSingleTag(MM::g_Keyword_Metadata_ImageNumber).GetValue(), number);
+    }
+    if (md.HasTag(MM::g_Keyword_Elapsed_Time_ms)) {
+      elapsed = md.GetSingleTag(MM::g_Keyword_Elapsed_Time_ms).GetValue();
+    }
+    if (number == lastNumber_ && elapsed == lastElapsed_) return false;
+
+    auto t0 = Clock::now();
+    format_.update(md);
+    const size_t height = format_.shape[0], width = format_.shape[1];
+    const size_t channels = format_.ndim == 3 ? format_.shape[2] : 1;
+    if (format_.dtype == nb::dtype<uint8_t>()) {
+      render(static_cast<const uint8_t*>(pBuf), width, height, channels, back_);
+    } else if (format_.dtype == nb::dtype<uint16_t>()) {
+      render(static_cast<const uint16_t*>(pBuf), width, height, channels, back_);
+    } else {
+      render(static_cast<const uint32_t*>(pBuf), width, height, channels, back_);
+    }
+    back_.imageNumber = number;
+    back_.renderMs = elapsed_ms(t0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (lastNumber_ >= 0 && number > lastNumber_ + 1) skipped_ += number - lastNumber_ - 1;
+    ++rendered_;
+    lastNumber_ = number;
+    lastElapsed_ = std::move(elapsed);
+    std::swap(front_, back_);
+    return true;
+  }
+
+  void run() {
+    try {
+      auto next = Clock::now();
+      while (true) {
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          if (wake_.wait_until(lock, next, [&] { return stopRequested_; })) break;
+        }
+        auto t0 = Clock::now();
+        next = renderNewest() ? t0 + period_ : t0 + kPollInterval;
+      }
+    } catch (const std::exception& e) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = e.what();
+    }
+    running_ = false;
+  }
+
+  CMMCore& core_;
+  nb::object owner_;  // keeps the core alive
+  const bool binning_;
+  const size_t maxWidth_, maxHeight_;
+  Clock::duration period_;
+
+  // preview thread only
+  FrameFormat format_;
+  std::vector<float> values_;  // binned frame, row-major, RGB order
+  std::vector<float> rowSum_;  // one row of source pixels summed over a bin
+  Display back_;
+  int64_t lastNumber_ = -1;
+  std::string lastElapsed_;
+
+  std::mutex mutex_;  // guards everything below
+  std::condition_variable wake_;
+  Display front_;
+  double lowPercentile_ = 0, highPercentile_ = 100;
+  uint64_t rendered_ = 0;
+  uint64_t skipped_ = 0;
+  std::string error_;
+  bool stopRequested_ = false;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
+
+///////////////// Batched property access ///////////////////
+
+/**
+ * @brief Calls `fn(i)` for every index of `labels`, with one thread per device label: the items
+ * of a device run in order on one thread, and different devices run concurrently.
+ *
+ * Items of the `Core` pseudo-device run last, in order, on the calling thread once all device
+ * threads have joined: they change the core's own state (e.g. the current camera or shutter),
+ * which CMMCore does not guard against concurrent device calls.
+ *
+ * `fn` must not throw.  Call without the GIL.
+ */
+template <typename Fn>
+void for_each_by_device(const std::vector<std::string>& labels, Fn&& fn) {
+  std::vector<std::vector<size_t>> groups;
+  std::vector<size_t> core;
+  std::unordered_map<std::string, size_t> groupOf;
+  for (size_t i = 0; i < labels.size(); ++i) {
+    if (labels[i] == MM::g_Keyword_CoreDevice) {
+      core.push_back(i);
+      continue;
+    }
+    auto [it, inserted] = groupOf.emplace(labels[i], groups.size());
+    if (inserted) groups.emplace_back();
+    groups[it->second].push_back(i);
+  }
+  std::vector<std::thread> threads;
+  for (size_t g = 1; g < groups.size(); ++g) {
+    threads.emplace_back([&, g] {
+      for (size_t i : groups[g]) fn(i);
+    });
+  }
+  if (!groups.empty()) {
+    for (size_t i : groups[0]) fn(i);  // the first device runs on the calling thread
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (size_t i : core) fn(i);
+}
+
+// A property value as given from Python, set with the matching `CMMCore::setProperty` overload
+struct PropertyValue {
+  enum Kind { String, Bool, Long, Float } kind = String;
+  std::string s;
+  bool b = false;
+  long l = 0;
+  float f = 0;
+
+  // Converts `value` like the setProperty overloads would (requires the GIL)
+  static PropertyValue from(nb::handle value) {
+    PropertyValue v;
+    if (nb::isinstance<bool>(value)) {
+      v.kind = Bool;
+      v.b = nb::cast<bool>(value);
+    } else if (nb::isinstance<nb::int_>(value)) {
+      v.kind = Long;
+      v.l = nb::cast<long>(value);
+    } else if (nb::isinstance<nb::float_>(value)) {
+      v.kind = Float;
+      v.f = nb::cast<float>(value);
+    } else {
+      v.s = nb::str(value).c_str();
+    }
+    return v;
+  }
+
+  void set(CMMCore& core, const char* label, const char* prop) const {
+    switch (kind) {
+      case Bool:
+        return core.setProperty(label, prop, b);
+      case Long:
+        return core.setProperty(label, prop, l);
+      case Float:
+        return core.setProperty(label, prop, f);
+      default:
+        return core.setProperty(label, prop, s.c_str());
+    }
+  }
+};
+
+// Outcome of `apply_configuration_diff`
+struct ConfigDiffResult {
+  size_t skipped = 0;                      // settings that already matched the cache
+  size_t issued = 0;                       // settings written
+  double ms = 0;                           // wall time of all writes
+  std::map<std::string, double> deviceMs;  // time spent writing to each device
+};
+
+/**
+ * @brief Applies `conf` like `CMMCore::setSystemState`, but skips the settings whose value is
+ * already in the system state cache, and writes to different devices concurrently (the writes to
+ * each device in order).  `Core` settings (e.g. the current shutter) are applied one at a time
+ * after all device groups have finished (see `for_each_by_device`).
+ *
+ * Settings that fail are retried once after all others, since one setting may depend on another
+ * (e.g. a property that only exists in some state): first the device settings, then the `Core`
+ * settings.  If any still fail, throws a CMMError listing them.  Call without the GIL.
+ */
+ConfigDiffResult apply_configuration_diff(CMMCore& core, const Configuration& conf) {
+  auto t0 = std::chrono::steady_clock::now();
+  std::map<std::pair<std::string, std::string>, std::string> cached;
+  Configuration cache = core.getSystemStateCache();
+  for (size_t i = 0; i < cache.size(); ++i) {
+    PropertySetting s = cache.getSetting(i);
+    cached[{s.getDeviceLabel(), s.getPropertyName()}] = s.getPropertyValue();
+  }
+
+  ConfigDiffResult result;
+  std::vector<PropertySetting> writes;
+  std::vector<std::string> labels;
+  for (size_t i = 0; i < conf.size(); ++i) {
+    PropertySetting s = conf.getSetting(i);
+    auto it = cached.find({s.getDeviceLabel(), s.getPropertyName()});
+    if (it != cached.end() && it->second == s.getPropertyValue()) {
+      ++result.skipped;
+      continue;
+    }
+    labels.push_back(s.getDeviceLabel());
+    writes.push_back(std::move(s));
+  }
+  result.issued = writes.size();
+
+  std::vector<double> ms(writes.size());
+  std::vector<std::string> errors(writes.size());
+  auto write = [&](size_t i) {
+    const PropertySetting& s = writes[i];
+    auto start = std::chrono::steady_clock::now();
+    try {
+      core.setProperty(s.getDeviceLabel().c_str(), s.getPropertyName().c_str(),
+                       s.getPropertyValue().c_str());
+      errors[i].clear();
+    } catch (const std::exception& e) {
+      errors[i] = e.what();
+    }
+    ms[i] += elapsed_ms(start);
+  };
+  for_each_by_device(labels, write);
+  for (bool corePass : {false, true}) {
+    for (size_t i = 0; i < writes.size(); ++i) {
+      if (!errors[i].empty() && (labels[i] == MM::g_Keyword_CoreDevice) == corePass) write(i);
+    }
+  }
+
+  std::string failed;
+  for (size_t i = 0; i < writes.size(); ++i) {
+    result.deviceMs[labels[i]] += ms[i];
+    if (errors[i].empty()) continue;
+    failed += "\n" + labels[i] + "-" + writes[i].getPropertyName() + ": " + errors[i];
+  }
+  result.ms = elapsed_ms(t0);
+  if (!failed.empty()) throw CMMError("Failed to apply configuration settings:" + failed);
+  return result;
+}
+
+nb::dict config_diff_dict(const ConfigDiffResult& r) {
+  nb::dict d;
+  d["skipped"] = r.skipped;
+  d["issued"] = r.issued;
+  d["total_ms"] = r.ms;
+  nb::dict deviceMs;
+  for (const auto& [label, ms] : r.deviceMs) deviceMs[label.c_str()] = ms;
+  d["device_ms"] = deviceMs;
+  return d;
+}
+
+///////////////// Device initialization ///////////////////
+
+// CMMCore feature that initializes the devices of different adapter modules concurrently
+constexpr const char* kParallelInitFeature = "ParallelDeviceInitialization";
+
+/**
+ * @brief The loaded devices (except the Core) in an order in which they can be initialized:
+ * every hub before its peripherals and every port before the devices that use it, otherwise in
+ * load order.
+ *
+ * `dependsOn[i]` holds the positions of the devices that device `i` needs.  Devices on a
+ * dependency cycle (a misconfiguration) come last, in load order.  Call without the GIL.
+ */
+struct DeviceGraph {
+  std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> dependsOn;
+
+  static DeviceGraph of(CMMCore& core) {
+    std::vector<std::string> loaded;
+    for (std::string& label : core.getLoadedDevices()) {
+      if (label != MM::g_Keyword_CoreDevice) loaded.push_back(std::move(label));
+    }
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < loaded.size(); ++i) index.emplace(loaded[i], i);
+
+    // what each device needs, by load position
+    std::vector<std::vector<size_t>> needs(loaded.size());
+    std::vector<size_t> pending(loaded.size(), 0);
+    std::vector<std::vector<size_t>> neededBy(loaded.size());
+    for (size_t i = 0; i < loaded.size(); ++i) {
+      auto need = [&](const std::string& other) {
+        auto it = index.find(other);
+        if (it == index.end() || it->second == i) return;
+        needs[i].push_back(it->second);
+        neededBy[it->second].push_back(i);
+        ++pending[i];
+      };
+      const char* label = loaded[i].c_str();
+      need(core.getParentLabel(label));
+      try {
+        if (core.hasProperty(label, MM::g_Keyword_Port)) {
+          need(core.getProperty(label, MM::g_Keyword_Port));
+        }
+      } catch (const CMMError&) {
+        // the port is not readable yet; nothing to order by
+      }
+    }
+
+    // Kahn's algorithm, always taking the earliest-loaded device that is ready
+    std::set<size_t> ready;
+    for (size_t i = 0; i < loaded.size(); ++i) {
+      if (pending[i] == 0) ready.insert(i);
+    }
+    std::vector<size_t> order;
+    while (!ready.empty()) {
+      size_t i = *ready.begin();
+      ready.erase(ready.begin());
+      order.push_back(i);
+      for (size_t j : neededBy[i]) {
+        if (--pending[j] == 0) ready.insert(j);
+      }
+    }
+    for (size_t i = 0; i < loaded.size(); ++i) {
+      if (pending[i] != 0) order.push_back(i);
+    }
+
+    DeviceGraph graph;
+    std::vector<size_t> position(loaded.size());
+    for (size_t p = 0; p < order.size(); ++p) position[order[p]] = p;
+    for (size_t i : order) {
+      graph.labels.push_back(std::move(loaded[i]));
+      graph.dependsOn.emplace_back();
+      for (size_t j : needs[i]) graph.dependsOn.back().push_back(position[j]);
+    }
+    return graph;
+  }
+};
+
+// Outcome of initializing one device (see `initializeAllDevicesOrdered`)
+struct DeviceInitResult {
+  DeviceInitializationState state = DeviceInitializationState::Uninitialized;
+  double ms = std::numeric_limits<double>::quiet_NaN();  // NaN if not timed individually
+  std::string error;
+};
+
+/**
+ * @brief Initializes all loaded devices that are not initialized yet, serially and in
+ * `DeviceGraph` order, continuing past failures.
+ *
+ * Devices are not initialized concurrently from here: `CMMCore::initializeDevice` also refreshes
+ * the core's own properties, which CMMCore does not guard against concurrent calls.
+ *
+ * If no device has been initialized yet and `kParallelInitFeature` is enabled (a process-wide
+ * setting that is left to the caller, since toggling it here would race with other cores), the
+ * core initializes the devices itself, concurrently across adapter modules and in its own order;
+ * those devices are not timed individually.  The core stops at the first failure, so any devices
+ * it did not get to are then initialized one at a time, like all devices otherwise are: in
+ * `DeviceGraph` order, skipping devices whose hub or port did not initialize.  Sets `parallel`
+ * to whether the core's parallel mode was used and returns one result per device, in `graph`
+ * order.  Call without the GIL.
+ */
+std::vector<DeviceInitResult> initialize_devices(CMMCore& core, const DeviceGraph& graph,
+                                                 bool& parallel) {
+  const std::vector<std::string>& labels = graph.labels;
+  std::vector<DeviceInitResult> results(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i) {
+    results[i].state = core.getDeviceInitializationState(labels[i].c_str());
+  }
+  bool anyInitialized = std::any_of(results.begin(), results.end(), [](const auto& r) {
+    return r.state != DeviceInitializationState::Uninitialized;
+  });
+
+  parallel = false;
+  if (!anyInitialized && !labels.empty()) {
+    try {
+      parallel = CMMCore::isFeatureEnabled(kParallelInitFeature);
+    } catch (const CMMError&) {
+      // this core has no parallel initialization
+    }
+  }
+  std::vector<bool> attempted(labels.size(), false);
+  if (parallel) {
+    std::string error;
+    try {
+      core.initializeAllDevices();
+    } catch (const std::exception& e) {
+      error = e.what();
+    }
+    bool attributed = false;
+    for (size_t i = 0; i < labels.size(); ++i) {
+      results[i].state = core.getDeviceInitializationState(labels[i].c_str());
+      attempted[i] = results[i].state != DeviceInitializationState::Uninitialized;
+      if (results[i].state == DeviceInitializationState::InitializationFailed) {
+        results[i].error = error;
+        attributed = true;
+      }
+    }
+    if (!error.empty() && !attributed) throw std::runtime_error(error);
+  }
+
+  for (size_t i = 0; i < labels.size(); ++i) {
+    DeviceInitResult& r = results[i];
+    if (attempted[i]) continue;
+    if (r.state == DeviceInitializationState::InitializedSuccessfully) {
+      r.ms = 0;
+      continue;
+    }
+    const std::vector<size_t>& deps = graph.dependsOn[i];
+    auto missing = std::find_if(deps.begin(), deps.end(), [&](size_t j) {
+      return results[j].state != DeviceInitializationState::InitializedSuccessfully;
+    });
+    if (missing != deps.end()) {
+      r.error = "Skipped because \"" + labels[*missing] + "\" is not initialized";
+      continue;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    try {
+      core.initializeDevice(labels[i].c_str());
+    } catch (const std::exception& e) {
+      r.error = e.what();
+    }
+    r.ms = elapsed_ms(t0);
+    r.state = core.getDeviceInitializationState(labels[i].c_str());
+  }
+  return results;
+}
+
+///////////////// Versioned system state ///////////////////
+
+/**
+ * @brief Versions of a core's system state cache.
+ *
+ * Each `refresh` that finds a setting changed, added or removed since the previous refresh bumps
+ * the version by one, and every setting remembers the version in which it last changed, so
+ * pollers can ask for just the settings that changed since the version they last saw.
+ *
+ * CMMCore keeps no version of its own and notifies only one registered callback, so changes are
+ * found by comparing the cache with the previous refresh.  Every refresh therefore costs
+ * O(cache size): CMMCore hands out the cache only as a copy, which is then compared in place with
+ * the entries in one pass.  That is much cheaper than walking a `Configuration` from Python, but
+ * not free, so callers should poll at a modest rate.  Thread-safe.
+ */
+class StateVersions {
+ public:
+  using Key = std::pair<std::string, std::string>;  // device label, property name
+
+  struct Entry {
+    std::string value;
+    uint64_t version = 0;  // version in which the setting last changed
+    bool removed = false;  // the setting is no longer in the cache (e.g. device unloaded)
+    uint64_t seen = 0;     // last refresh that found the setting in the cache
+  };
+
+  // Compares the cache of `core` with the previous refresh, in O(cache size); returns the
+  // current version
+  uint64_t refresh(CMMCore& core) {
+    Configuration cache = core.getSystemStateCache();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++refreshes_;
+    std::vector<Entry*> changed;
+    Key lookup;
+    for (size_t i = 0; i < cache.size(); ++i) {
+      PropertySetting s = cache.getSetting(i);
+      lookup.first = s.getDeviceLabel();
+      lookup.second = s.getPropertyName();
+      auto [it, inserted] = entries_.try_emplace(lookup);  // copies the key only when inserting
+      Entry& e = it->second;
+      e.seen = refreshes_;
+      std::string value = s.getPropertyValue();
+      if (inserted || e.removed || e.value != value) {
+        e.value = std::move(value);
+        e.removed = false;
+        changed.push_back(&e);
+      }
+    }
+    for (auto& [key, e] : entries_) {
+      if (!e.removed && e.seen != refreshes_) {
+        e.value.clear();
+        e.removed = true;
+        changed.push_back(&e);
+      }
+    }
+    if (!changed.empty()) {
+      ++version_;
+      for (Entry* e : changed) e->version = version_;
+    }
+    return version_;
+  }
+
+  // Calls `fn(key, entry)` for each setting that changed after `version`, by device and property
+  template <typename Fn>
+  uint64_t changedSince(uint64_t version, Fn&& fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [key, e] : entries_) {
+      if (e.version > version) fn(key, e);
+    }
+    return version_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::map<Key, Entry> entries_;  // sorted by device, then property
+  uint64_t version_ = 0;
+  uint64_t refreshes_ = 0;
+};
+
+// Get (or create) the state versions of `core`.  Must be called with the GIL held.
+std::shared_ptr<StateVersions> state_versions(CMMCore& core) {
+  CoreExtras& extras = core_extras(core);
+  if (!extras.versions) extras.versions = std::make_shared<StateVersions>();
+  return extras.versions;
+}
+
+///////////////// Property handles ///////////////////
+
+// A flag that stays true until `label` is unloaded from `core`.  Must be called with the GIL held.
+std::shared_ptr<std::atomic<bool>> device_token(CMMCore& core, const std::string& label) {
+  auto& token = core_extras(core).deviceTokens[label];
+  if (!token) token = std::make_shared<std::atomic<bool>>(true);
+  return token;
+}
+
+// Clears the tokens of `label`, or of all devices if null.  Must be called with the GIL held.
+void invalidate_devices(CMMCore& core, const char* label = nullptr) {
+  auto& tokens = core_extras(core).deviceTokens;
+  for (auto it = tokens.begin(); it != tokens.end();) {
+    if (label && it->first != label) {
+      ++it;
+      continue;
+    }
+    it->second->store(false);
+    it = tokens.erase(it);
+  }
+}
+
+/**
+ * @brief Runs `call` (a core call that unloads devices) with the GIL released, then invalidates
+ * the handles of `label` (or of all devices if null).  Must be called with the GIL held.
+ *
+ * Handles are only invalidated once `call` succeeded; if it failed, only the handles of devices
+ * that it did unload are, since the core may have stopped partway.
+ */
+template <typename Call>
+void unloading_call(CMMCore& core, const char* label, Call&& call) {
+  try {
+    nb::gil_scoped_release gil;
+    call();
+  } catch (...) {
+    std::vector<std::string> loaded;
+    {
+      nb::gil_scoped_release gil;
+      loaded = core.getLoadedDevices();
+    }
+    auto& tokens = core_extras(core).deviceTokens;
+    for (auto it = tokens.begin(); it != tokens.end();) {
+      if (std::find(loaded.begin(), loaded.end(), it->first) != loaded.end()) {
+        ++it;
+        continue;
+      }
+      it->second->store(false);
+      it = tokens.erase(it);
+    }
+    throw;
+  }
+  invalidate_devices(core, label);
+}
+
+/**
+ * @brief One property of one device, resolved when the handle is made.
+ *
+ * The property type and read-only flag are looked up once, and values are converted to and from
+ * Python numbers in C++, so a poll is a single binding call that returns an int or float.
+ * CMMCore only addresses properties by label and name, so it still looks these up on each access.
+ *
+ * The handle becomes invalid when its device is unloaded through the bindings (including by
+ * `reset` and `loadSystemConfiguration`), and stays invalid if a device with the same label is
+ * loaded again.
+ */
+class PropertyHandle {
+ public:
+  PropertyHandle(CMMCore& core, std::string label, std::string property)
+      : core_(core),
+        owner_(nb::cast(core, nb::rv_policy::reference)),
+        label_(std::move(label)),
+        property_(std::move(property)),
+        valid_(device_token(core, label_)) {  // before the lookup, so no unload goes unnoticed
+    bool exists;
+    {
+      nb::gil_scoped_release gil;
+      exists = core.hasProperty(label_.c_str(), property_.c_str());
+      if (exists) {
+        type_ = core.getPropertyType(label_.c_str(), property_.c_str());
+        readOnly_ = core.isPropertyReadOnly(label_.c_str(), property_.c_str());
+      }
+    }
+    if (!exists) {
+      throw nb::value_error(
+          ("No property \"" + property_ + "\" in device \"" + label_ + "\"").c_str());
+    }
+  }
+
+  // The current value as an int, float or str, depending on the property type
+  nb::object get() {
+    check();
+    std::string value;
+    {
+      nb::gil_scoped_release gil;
+      value = core_.getProperty(label_.c_str(), property_.c_str());
+    }
+    return convert(value);
+  }
+
+  // Like `get`, but from the system state cache
+  nb::object getCached() {
+    check();
+    std::string value;
+    {
+      nb::gil_scoped_release gil;
+      value = core_.getPropertyFromCache(label_.c_str(), property_.c_str());
+    }
+    return convert(value);
+  }
+
+  // Sets `value`, which must be an int for Integer properties and a number for Float properties
+  void set(nb::handle value) {
+    check();
+    if (readOnly_) throw nb::value_error(("Property \"" + name() + "\" is read-only").c_str());
+    bool isInt = nb::isinstance<nb::int_>(value);
+    if (type_ == MM::Integer && !isInt) {
+      throw nb::type_error(("Property \"" + name() + "\" takes an int").c_str());
+    }
+    if (type_ == MM::Float && !isInt && !nb::isinstance<nb::float_>(value)) {
+      throw nb::type_error(("Property \"" + name() + "\" takes a number").c_str());
+    }
+    std::string s;
+    if (type_ == MM::Integer) {
+      s = std::to_string(nb::cast<long long>(value));
+    } else if (type_ == MM::Float) {
+      char buf[32];
+      std::snprintf(buf, sizeof(buf), "%.15g", nb::cast<double>(value));
+      s = buf;
+    } else {
+      s = nb::str(value).c_str();
+    }
+    nb::gil_scoped_release gil;
+    core_.setProperty(label_.c_str(), property_.c_str(), s.c_str());
+  }
+
+  const std::string& label() const { return label_; }
+  const std::string& property() const { return property_; }
+  MM::PropertyType type() const { return type_; }
+  bool readOnly() const { return readOnly_; }
+  bool valid() const { return valid_->load(); }
+
+ private:
+  std::string name() const { return label_ + "-" + property_; }
+
+  void check() const {
+    if (!valid_->load()) {
+      throw std::runtime_error("Property handle \"" + name() +
+                               "\" is no longer valid: its device was unloaded");
+    }
+  }
+
+  nb::object convert(const std::string& value) const {
+    if (type_ == MM::Integer) {
+      int64_t i;
+      if (parse_int64(value, i)) return nb::int_(i);
+    } else if (type_ == MM::Float) {
+      double d;
+      if (parse_double(value, d)) return nb::float_(d);
+    } else {
+      return nb::str(value.c_str(), value.size());
+    }
+    throw std::runtime_error("Property \"" + name() + "\" has a non-numeric value: " + value);
+  }
+
+  CMMCore& core_;
+  nb::object owner_;  // keeps the core alive
+  std::string label_;
+  std::string property_;
+  MM::PropertyType type_ = MM::Undef;
+  bool readOnly_ = false;
+  std::shared_ptr<std::atomic<bool>> valid_;
+};
+
+///////////////// Hardware sequence plans ///////////////////
+
+// Copies a 1D array into a vector (e.g. to hand it to CMMCore without the GIL)
+std::vector<double> to_vector(const double_array& a) {
+  return std::vector<double>(a.data(), a.data() + a.size());
+}
+
+/**
+ * @brief A hardware-triggered acquisition: per-event sequences of stage positions, XY positions,
+ * camera exposures and property values that are validated, loaded and started as one unit.
+ *
+ * Sequences are copied out of the Python arrays when they are added, so that validating, loading
+ * and starting run without the GIL.  Loading runs one thread per device, since CMMCore serializes
+ * calls per device adapter rather than globally.  Sequences are started in the order they were
+ * added (and the camera last, if requested) and stopped in reverse; if one fails to start, the
+ * ones already started are stopped again before the error is raised.
+ */
+class SequencePlan {
+ public:
+  explicit SequencePlan(CMMCore& core)
+      : core_(core),
+        owner_(nb::cast(core, nb::rv_policy::reference)),
+        sequenceStarts_(&core_extras(core).sequenceStarts) {}
+
+  void addStage(std::string label, std::vector<double> positions) {
+    add({Axis::Stage, std::move(label), {}, std::move(positions), {}, {}});
+  }
+  void addXYStage(std::string label, std::vector<double> x, std::vector<double> y) {
+    if (x.size() != y.size()) throw nb::value_error("x and y must have the same length");
+    add({Axis::XYStage, std::move(label), {}, std::move(x), std::move(y), {}});
+  }
+  void addExposure(std::string camera, std::vector<double> exposures) {
+    add({Axis::Exposure, std::move(camera), {}, std::move(exposures), {}, {}});
+  }
+  void addProperty(std::string label, std::string property, std::vector<std::string> values) {
+    add({Axis::Property, std::move(label), std::move(property), {}, {}, std::move(values)});
+  }
+
+  size_t events() const { return axes_.empty() ? 0 : axes_.front().size(); }
+
+  std::vector<std::string> axisNames() const {
+    std::vector<std::string> names;
+    for (const Axis& axis : axes_) names.push_back(axis.name());
+    return names;
+  }
+
+  bool loaded() const { return loaded_; }
+  bool running() const { return !started_.empty() || cameraStarted_; }
+
+  nb::dict timings() const {
+    nb::dict d;
+    for (const auto& [name, ms] : timings_) d[name.c_str()] = ms;
+    return d;
+  }
+
+  /**
+   * @brief Checks every sequence against its device up front.
+   *
+   * @throws nb::value_error Listing all problems: mismatched lengths, devices that cannot
+   *         sequence the axis, and sequences longer than the device's maximum.
+   */
+  void validate() {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::string> errors;
+    if (axes_.empty()) errors.push_back("the plan is empty");
+    for (const Axis& axis : axes_) {
+      if (axis.size() != events()) {
+        errors.push_back(axis.name() + " has " + std::to_string(axis.size()) + " events, " +
+                         axes_.front().name() + " has " + std::to_string(events()));
+        continue;
+      }
+      try {
+        if (!sequenceable(axis)) {
+          errors.push_back(axis.name() + " is not sequenceable");
+        } else if (long max = maxLength(axis); static_cast<long>(axis.size()) > max) {
+          errors.push_back(axis.name() + " has " + std::to_string(axis.size()) +
+                           " events, the device takes at most " + std::to_string(max));
+        }
+      } catch (const std::exception& e) {
+        errors.push_back(axis.name() + ": " + e.what());
+      }
+    }
+    timings_["validate_ms"] = elapsed_ms(t0);
+    if (!errors.empty()) throw nb::value_error(("Invalid sequence plan: " + join(errors)).c_str());
+  }
+
+  // Validates the plan and loads all sequences, in parallel across devices
+  void load() {
+    validate();
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::string> labels;
+    for (const Axis& axis : axes_) labels.push_back(axis.label);
+    std::mutex mutex;
+    std::vector<std::string> errors;
+    for_each_by_device(labels, [&](size_t i) {
+      try {
+        loadAxis(axes_[i]);
+      } catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        errors.push_back(axes_[i].name() + ": " + e.what());
+      }
+    });
+    timings_["load_ms"] = elapsed_ms(t0);
+    loaded_ = errors.empty();
+    if (!errors.empty()) throw std::runtime_error("Failed to load sequences: " + join(errors));
+  }
+
+  // Starts all sequences (loading them first if needed), then optionally the camera
+  void start(bool camera) {
+    if (running()) throw std::runtime_error("The sequence plan is already running.");
+    if (!loaded_) load();
+    auto t0 = std::chrono::steady_clock::now();
+    try {
+      for (const Axis& axis : axes_) {
+        startAxis(axis);
+        started_.push_back(&axis);
+      }
+      if (camera) {
+        core_.startSequenceAcquisition(static_cast<long>(events()), 0, true);
+        sequenceStarts_->fetch_add(1, std::memory_order_relaxed);
+        cameraStarted_ = true;
+      }
+    } catch (...) {
+      stopStarted();  // best effort; the start error is the one worth reporting
+      throw;
+    }
+    timings_["start_ms"] = elapsed_ms(t0);
+  }
+
+  // Stops the camera (if started by the plan), then all sequences in reverse order
+  void stop() {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::string> errors = stopStarted();
+    timings_["stop_ms"] = elapsed_ms(t0);
+    if (!errors.empty()) throw std::runtime_error("Failed to stop sequences: " + join(errors));
+  }
+
+ private:
+  struct Axis {
+    enum Kind { Stage, XYStage, Exposure, Property } kind;
+    std::string label;
+    std::string property;              // Property only
+    std::vector<double> values;        // Stage, Exposure, and X for XYStage
+    std::vector<double> y;             // XYStage only
+    std::vector<std::string> strings;  // Property only
+
+    size_t size() const { return kind == Property ? strings.size() : values.size(); }
+
+    std::string name() const {
+      switch (kind) {
+        case Exposure:
+          return label + "-Exposure";
+        case Property:
+          return label + "-" + property;
+        default:
+          return label;
+      }
+    }
+  };
+
+  static std::string join(const std::vector<std::string>& parts) {
+    std::string s;
+    for (const std::string& part : parts) s += (s.empty() ? "" : "; ") + part;
+    return s;
+  }
+
+  void add(Axis axis) {
+    if (running()) throw std::runtime_error("Cannot change a running sequence plan.");
+    for (const Axis& other : axes_) {
+      if (other.name() == axis.name() && other.kind == axis.kind) {
+        throw nb::value_error(("Duplicate sequence for " + axis.name()).c_str());
+      }
+    }
+    axes_.push_back(std::move(axis));
+    loaded_ = false;
+  }
+
+  bool sequenceable(const Axis& axis) {
+    const char* label = axis.label.c_str();
+    switch (axis.kind) {
+      case Axis::Stage:
+        return core_.isStageSequenceable(label);
+      case Axis::XYStage:
+        return core_.isXYStageSequenceable(label);
+      case Axis::Exposure:
+        return core_.isExposureSequenceable(label);
+      default:
+        return core_.isPropertySequenceable(label, axis.property.c_str());
+    }
+  }
+
+  long maxLength(const Axis& axis) {
+    const char* label = axis.label.c_str();
+    switch (axis.kind) {
+      case Axis::Stage:
+        return core_.getStageSequenceMaxLength(label);
+      case Axis::XYStage:
+        return core_.getXYStageSequenceMaxLength(label);
+      case Axis::Exposure:
+        return core_.getExposureSequenceMaxLength(label);
+      default:
+        return core_.getPropertySequenceMaxLength(label, axis.property.c_str());
+    }
+  }
+
+  void loadAxis(const Axis& axis) {
+    const char* label = axis.label.c_str();
+    switch (axis.kind) {
+      case Axis::Stage:
+        return core_.loadStageSequence(label, axis.values);
+      case Axis::XYStage:
+        return core_.loadXYStageSequence(label, axis.values, axis.y);
+      case Axis::Exposure:
+        return core_.loadExposureSequence(label, axis.values);
+      default:
+        return core_.loadPropertySequence(label, axis.property.c_str(), axis.strings);
+    }
+  }
+
+  void startAxis(const Axis& axis) {
+    const char* label = axis.label.c_str();
+    switch (axis.kind) {
+      case Axis::Stage:
+        return core_.startStageSequence(label);
+      case Axis::XYStage:
+        return core_.startXYStageSequence(label);
+      case Axis::Exposure:
+        return core_.startExposureSequence(label);
+      default:
+        return core_.startPropertySequence(label, axis.property.c_str());
+    }
+  }
+
+  void stopAxis(const Axis& axis) {
+    const char* label = axis.label.c_str();
+    switch (axis.kind) {
+      case Axis::Stage:
+        return core_.stopStageSequence(label);
+      case Axis::XYStage:
+        return core_.stopXYStageSequence(label);
+      case Axis::Exposure:
+        return core_.stopExposureSequence(label);
+      default:
+        return core_.stopPropertySequence(label, axis.property.c_str());
+    }
+  }
+
+  // Stops the camera and the started sequences in reverse order; returns the errors
+  std::vector<std::string> stopStarted() {
+    std::vector<std::string> errors;
+    if (cameraStarted_) {
+      try {
+        core_.stopSequenceAcquisition();
+      } catch (const std::exception& e) {
+        errors.push_back(std::string("camera: ") + e.what());
+      }
+      cameraStarted_ = false;
+    }
+    for (auto it = started_.rbegin(); it != started_.rend(); ++it) {
+      try {
+        stopAxis(**it);
+      } catch (const std::exception& e) {
+        errors.push_back((*it)->name() + ": " + e.what());
+      }
+    }
+    started_.clear();
+    return errors;
+  }
+
+  CMMCore& core_;
+  nb::object owner_;                       // keeps the core alive
+  std::atomic<uint64_t>* sequenceStarts_;  // CoreExtras::sequenceStarts of core_
+  std::vector<Axis> axes_;
+  std::vector<const Axis*> started_;  // in start order
+  bool cameraStarted_ = false;
+  bool loaded_ = false;
+  std::map<std::string, double> timings_;
+};
+
+///////////////// Synthetic camera ///////////////////
+
+// Names under which the built-in adapter and its camera are registered (see
+// `registerSyntheticAdapter`)
+const char* const kSyntheticAdapterName = "PymmcoreNanoSynthetic";
+const char* const kSyntheticCameraName = "SyntheticCamera";
+
+/**
+ * @brief A camera device compiled into the extension, for tests and load generation.
+ *
+ * In synthetic mode, frames of `Width` x `Height` pixels (or the current ROI) of `PixelType` are
+ * generated at `FrameRateHz` (0 = as fast as possible).  Pixel (x, y) of the n-th frame of a
+ * sequence is `(x + y + n) % 256` in every color component, so the content of every frame can be
+ * checked.  Frame n is due exactly `n * 1000 / FrameRateHz` ms after the sequence started, which
+ * is reported in its `ElapsedTime-ms` tag, along with `ImageNumber` = n and how late the frame
+ * was sent (`SyntheticCamera-LatenessUs`).
+ *
+ * Setting `ReplayFile` to a stream recorded with `StreamWriter` switches to replay mode: the
+ * format follows the file and its frames are sent at their original relative timing (from the
+ * `.idx` file).  With `ReplayLoop`, the recording is repeated until the sequence is stopped.
+ */
+class SyntheticCamera : public CCameraBase<SyntheticCamera> {
+ public:
+  static constexpr int kErrReplayFile = 30001;
+  static constexpr int kErrReplayActive = 30002;
+
+  SyntheticCamera() {
+    SetErrorText(kErrReplayActive, "The format is fixed by the replay file; clear ReplayFile.");
+  }
+
+  ~SyntheticCamera() { Shutdown(); }
+
+  int Initialize() override {
+    CreateIntegerProperty("Width", width_, false,
+                          new CPropertyAction(this, &SyntheticCamera::OnWidth));
+    SetPropertyLimits("Width", 1, 16384);
+    CreateIntegerProperty("Height", height_, false,
+                          new CPropertyAction(this, &SyntheticCamera::OnHeight));
+    SetPropertyLimits("Height", 1, 16384);
+    CreateStringProperty(MM::g_Keyword_PixelType, "16bit", false,
+                         new CPropertyAction(this, &SyntheticCamera::OnPixelType));
+    for (const char* pt : {"8bit", "16bit", "32bit", "32bitRGB"}) {
+      AddAllowedValue(MM::g_Keyword_PixelType, pt);
+    }
+    CreateStringProperty(MM::g_Keyword_Binning, "1", false);
+    AddAllowedValue(MM::g_Keyword_Binning, "1");
+    CreateFloatProperty(MM::g_Keyword_Exposure, exposureMs_, false,
+                        new CPropertyAction(this, &SyntheticCamera::OnExposure));
+    CreateFloatProperty("FrameRateHz", frameRateHz_, false,
+                        new CPropertyAction(this, &SyntheticCamera::OnFrameRate));
+    SetPropertyLimits("FrameRateHz", 0, 1e6);
+    CreateStringProperty("ReplayFile", "", false,
+                         new CPropertyAction(this, &SyntheticCamera::OnReplayFile));
+    CreateStringProperty("ReplayLoop", "No", false,
+                         new CPropertyAction(this, &SyntheticCamera::OnReplayLoop));
+    AddAllowedValue("ReplayLoop", "No");
+    AddAllowedValue("ReplayLoop", "Yes");
+    resetFormat();
+    return DEVICE_OK;
+  }
+
+  int Shutdown() override {
+    StopSequenceAcquisition();
+    closeReplay();
+    return DEVICE_OK;
+  }
+
+  void GetName(char* name) const override {
+    CDeviceUtils::CopyLimitedString(name, kSyntheticCameraName);
+  }
+  bool Busy() override { return false; }
+
+  int SnapImage() override {
+    if (IsCapturing()) return DEVICE_CAMERA_BUSY_ACQUIRING;
+    // like a real camera, a snap takes (at least) the exposure time
+    auto exposed = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::duration<double, std::milli>(exposureMs_));
+    int ret = DEVICE_OK;
+    if (replay_) {
+      ret = readReplayFrame(snapCount_++ % replayTimes_.size(), snapFrame_.data());
+    } else {
+      fillFrame(snapFrame_.data(), snapCount_++);
+    }
+    std::this_thread::sleep_until(exposed);
+    return ret;
+  }
+  const unsigned char* GetImageBuffer() override { return snapFrame_.data(); }
+  long GetImageBufferSize() const override { return static_cast<long>(frameBytes()); }
+  unsigned GetImageWidth() const override { return roi_[2]; }
+  unsigned GetImageHeight() const override { return roi_[3]; }
+  unsigned GetImageBytesPerPixel() const override { return bytesPerPixel_; }
+  unsigned GetNumberOfComponents() const override { return components_; }
+  unsigned GetBitDepth() const override { return components_ > 1 ? 8 : 8 * bytesPerPixel_; }
+
+  double GetExposure() const override { return exposureMs_; }
+  void SetExposure(double exposureMs) override { exposureMs_ = exposureMs; }
+  int GetBinning() const override { return 1; }
+  int SetBinning(int binning) override {
+    return binning == 1 ? DEVICE_OK : DEVICE_INVALID_PROPERTY_VALUE;
+  }
+  int IsExposureSequenceable(bool& isSequenceable) const override {
+    isSequenceable = false;
+    return DEVICE_OK;
+  }
+
+  int SetROI(unsigned x, unsigned y, unsigned xSize, unsigned ySize) override {
+    if (IsCapturing()) return DEVICE_CAMERA_BUSY_ACQUIRING;
+    if (replay_) return kErrReplayActive;
+    if (xSize == 0 || ySize == 0 || x + xSize > width_ || y + ySize > height_) {
+      return DEVICE_INVALID_INPUT_PARAM;
+    }
+    roi_[0] = x;
+    roi_[1] = y;
+    roi_[2] = xSize;
+    roi_[3] = ySize;
+    resizeFrames();
+    return DEVICE_OK;
+  }
+  int GetROI(unsigned& x, unsigned& y, unsigned& xSize, unsigned& ySize) override {
+    x = roi_[0];
+    y = roi_[1];
+    xSize = roi_[2];
+    ySize = roi_[3];
+    return DEVICE_OK;
+  }
+  int ClearROI() override {
+    if (IsCapturing()) return DEVICE_CAMERA_BUSY_ACQUIRING;
+    resetFormat();
+    return DEVICE_OK;
+  }
+
+  int StartSequenceAcquisition(double intervalMs) override {
+    return StartSequenceAcquisition(LONG_MAX, intervalMs, false);
+  }
+  int StartSequenceAcquisition(long numImages, double intervalMs, bool stopOnOverflow) override {
+    if (IsCapturing()) return DEVICE_CAMERA_BUSY_ACQUIRING;
+    if (thread_.joinable()) thread_.join();  // the previous sequence ended on its own
+    int ret = GetCoreCallback()->PrepareForAcq(this);
+    if (ret != DEVICE_OK) return ret;
+    double periodMs = intervalMs > 0 ? intervalMs : frameRateHz_ > 0 ? 1000 / frameRateHz_ : 0;
+    stop_ = false;
+    capturing_ = true;
+    thread_ = std::thread([this, numImages, periodMs, stopOnOverflow] {
+      runSequence(numImages, periodMs, stopOnOverflow);
+    });
+    return DEVICE_OK;
+  }
+  int StopSequenceAcquisition() override {
+    stop_ = true;
+    if (thread_.joinable()) thread_.join();
+    return DEVICE_OK;
+  }
+  bool IsCapturing() override { return capturing_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  size_t frameBytes() const { return size_t(roi_[2]) * roi_[3] * bytesPerPixel_; }
+
+  // Full-frame ROI and buffers for the current format
+  void resetFormat() {
+    roi_[0] = roi_[1] = 0;
+    roi_[2] = width_;
+    roi_[3] = height_;
+    resizeFrames();
+  }
+
+  // Rebuilds the snap buffer and the pixel ramp that rows are copied from
+  void resizeFrames() {
+    snapFrame_.assign(frameBytes(), 0);
+    ramp_.assign((size_t(roi_[2]) + 256) * bytesPerPixel_, 0);
+    for (size_t i = 0; i < ramp_.size() / bytesPerPixel_; ++i) {
+      uint8_t* px = ramp_.data() + i * bytesPerPixel_;
+      uint32_t v = i % 256;
+      if (components_ > 1) {
+        px[0] = px[1] = px[2] = static_cast<uint8_t>(v);
+      } else if (bytesPerPixel_ == 1) {
+        px[0] = static_cast<uint8_t>(v);
+      } else if (bytesPerPixel_ == 2) {
+        uint16_t v16 = static_cast<uint16_t>(v);
+        std::memcpy(px, &v16, 2);
+      } else {
+        std::memcpy(px, &v, 4);
+      }
+    }
+  }
+
+  // Writes frame n of the synthetic pattern; each row is a single copy out of the ramp
+  void fillFrame(uint8_t* dst, uint64_t n) const {
+    size_t rowBytes = size_t(roi_[2]) * bytesPerPixel_;
+    for (unsigned y = 0; y < roi_[3]; ++y) {
+      size_t offset = (roi_[0] + roi_[1] + y + n) % 256;
+      std::memcpy(dst + y * rowBytes, ramp_.data() + offset * bytesPerPixel_, rowBytes);
+    }
+  }
+
+  void runSequence(long numImages, double periodMs, bool stopOnOverflow) {
+    std::vector<uint8_t> frame(frameBytes());
+    // replayed recordings repeat one mean frame interval after their last frame; a recording of
+    // a single frame (or with identical timestamps) loops at the configured frame interval
+    double replaySpan = 0;
+    if (replay_ && replayTimes_.size() > 1) {
+      replaySpan = replayTimes_.back() * replayTimes_.size() / (replayTimes_.size() - 1);
+    }
+    replaySpan = std::max(replaySpan, periodMs);
+
+    Clock::time_point start = Clock::now();
+    for (long n = 0; n < numImages && !stop_; ++n) {
+      double dueMs = n * periodMs;
+      if (replay_) {
+        size_t count = replayTimes_.size();
+        if (static_cast<size_t>(n) >= count && !replayLoop_) break;
+        dueMs = (n / count) * replaySpan + replayTimes_[n % count];
+        if (readReplayFrame(n % count, frame.data()) != DEVICE_OK) break;
+      } else {
+        fillFrame(frame.data(), n);
+      }
+
+      auto due = start + std::chrono::duration_cast<Clock::duration>(
+                             std::chrono::duration<double, std::milli>(dueMs));
+      // sleep most of the way, then yield until due; at thousands of frames per second the
+      // sleep granularity alone would cost most of the frame interval
+      for (Clock::time_point now = Clock::now(); now < due && !stop_; now = Clock::now()) {
+        if (due - now > std::chrono::milliseconds(1)) {
+          std::this_thread::sleep_for(
+              std::min<Clock::duration>(due - now - std::chrono::microseconds(500),
+                                        std::chrono::milliseconds(10)));
+        } else {
+          std::this_thread::yield();
+        }
+      }
+      if (stop_) break;
+
+      Metadata md;
+      md.PutImageTag(MM::g_Keyword_Metadata_ImageNumber, std::to_string(n));
+      md.PutImageTag(MM::g_Keyword_Elapsed_Time_ms, std::to_string(dueMs));
+      double lateUs = std::chrono::duration<double, std::micro>(Clock::now() - due).count();
+      md.PutImageTag("SyntheticCamera-LatenessUs", std::to_string(lateUs));
+      std::string serialized = md.Serialize();
+
+      int ret = GetCoreCallback()->InsertImage(this, frame.data(), roi_[2], roi_[3],
+                                               bytesPerPixel_, components_, serialized.c_str());
+      if (ret == DEVICE_BUFFER_OVERFLOW && !stopOnOverflow) {
+        GetCoreCallback()->ClearImageBuffer(this);
+        ret = GetCoreCallback()->InsertImage(this, frame.data(), roi_[2], roi_[3],
+                                             bytesPerPixel_, components_, serialized.c_str());
+      }
+      if (ret != DEVICE_OK) break;
+    }
+    GetCoreCallback()->AcqFinished(this, DEVICE_OK);
+    capturing_ = false;
+  }
+
+  /////// replay
+
+  // Opens a stream written by `StreamWriter` and takes over its frame format
+  int openReplay(const std::string& path) {
+    auto fail = [&](const std::string& msg) {
+      closeReplay();
+      SetErrorText(kErrReplayFile, ("Cannot replay '" + path + "': " + msg).c_str());
+      return kErrReplayFile;
+    };
+    closeReplay();
+    replayFile_ = std::fopen(path.c_str(), "rb");
+    if (!replayFile_) return fail(std::strerror(errno));
+    StreamHeader h;
+    if (std::fread(&h, sizeof(h), 1, replayFile_) != 1 ||
+        std::memcmp(h.magic, StreamHeader().magic, sizeof(h.magic)) != 0 || h.version != 1) {
+      return fail("not a pymmcore-nano stream");
+    }
+    std::string dtype(h.dtype, strnlen(h.dtype, sizeof(h.dtype)));
+    unsigned itemsize = dtype == "|u1" ? 1 : dtype == "<u2" ? 2 : dtype == "<u4" ? 4 : 0;
+    unsigned components = h.ndim == 3 ? static_cast<unsigned>(h.shape[2]) : 1;
+    if (itemsize == 0 || h.ndim < 2 || h.ndim > 3 || (components != 1 && itemsize != 1)) {
+      return fail("unsupported frame format " + dtype);
+    }
+    if (h.frameCount == 0) return fail("no frames");
+
+    std::FILE* index = std::fopen((path + ".idx").c_str(), "rb");
+    if (!index) return fail("missing index file");
+    std::vector<StreamIndexEntry> entries(h.frameCount);
+    size_t read = std::fread(entries.data(), sizeof(StreamIndexEntry), entries.size(), index);
+    std::fclose(index);
+    if (read != entries.size()) return fail("truncated index file");
+    replayTimes_.clear();
+    for (const StreamIndexEntry& e : entries) {
+      if (std::isnan(e.elapsedTimeMs)) return fail("frames without elapsed time");
+      replayTimes_.push_back(std::max(e.elapsedTimeMs - entries[0].elapsedTimeMs, 0.0));
+    }
+
+    replay_ = true;
+    replayOffset_ = h.headerBytes;
+    height_ = static_cast<unsigned>(h.shape[0]);
+    width_ = static_cast<unsigned>(h.shape[1]);
+    components_ = components;
+    bytesPerPixel_ = itemsize * components;
+    resetFormat();
+    return DEVICE_OK;
+  }
+
+  void closeReplay() {
+    if (replayFile_) std::fclose(replayFile_);
+    replayFile_ = nullptr;
+    replay_ = false;
+    replayTimes_.clear();
+  }
+
+  int readReplayFrame(size_t i, uint8_t* dst) {
+    size_t bytes = frameBytes();
+    if (std::fseek(replayFile_, static_cast<long>(replayOffset_ + i * bytes), SEEK_SET) != 0 ||
+        std::fread(dst, 1, bytes, replayFile_) != bytes) {
+      SetErrorText(kErrReplayFile, "Could not read from the replay file.");
+      return kErrReplayFile;
+    }
+    return DEVICE_OK;
+  }
+
+  /////// property handlers
+
+  // Shared by the format properties, which cannot change while capturing or replaying
+  int checkFormatChange() {
+    if (IsCapturing()) return DEVICE_CAMERA_BUSY_ACQUIRING;
+    if (replay_) return kErrReplayActive;
+    return DEVICE_OK;
+  }
+
+  int OnWidth(MM::PropertyBase* pProp, MM::ActionType eAct) {
+    if (eAct == MM::BeforeGet) {
+      pProp->Set(static_cast<long>(width_));
+    } else if (eAct == MM::AfterSet) {
+      if (int ret = checkFormatChange()) return ret;
+      long value;
+      pProp->Get(value);
+      width_ = static_cast<unsigned>(value);
+      resetFormat();
+    }
+    return DEVICE_OK;
   }
-}
 
-/**
- * @brief Creates a read-only NumPy array representing an image from the provided buffer and
- * `CMMCore` instance.
- *
- * This function wraps a raw memory buffer from a `CMMCore` instance into a `nanobind::ndarray` of
- * type `numpy.ndarray`. The array is read-only and shares ownership with the provided `CMMCore`
- * instance to ensure memory safety.
- *
- * @param core A reference to the `CMMCore` object, which provides image metadata and ensures
- *             ownership of the buffer.
- * @param pBuf Pointer to the data buffer containing the image data.
- *
- * @return A `nanobind::ndarray` representing the image buffer as a `numpy.ndarray`.
- *
- * @throws std::runtime_error If the combination of image properties (e.g., bytes per pixel, number
- *                            of components) is not supported.
- *
- * @note The resulting array is C-contiguous by default, as no strides are specified.
- *       Ownership of the buffer is tied to the lifetime of the `CMMCore` object.
- */
-ro_np_array create_image_array(CMMCore& core, void* pBuf) {
-  // Retrieve image properties
-  unsigned width = core.getImageWidth();
-  unsigned height = core.getImageHeight();
-  unsigned bytesPerPixel = core.getBytesPerPixel();
-  unsigned numComponents = core.getNumberOfComponents();
+  int OnHeight(MM::PropertyBase* pProp, MM::ActionType eAct) {
+    if (eAct == MM::BeforeGet) {
+      pProp->Set(static_cast<long>(height_));
+    } else if (eAct == MM::AfterSet) {
+      if (int ret = checkFormatChange()) return ret;
+      long value;
+      pProp->Get(value);
+      height_ = static_cast<unsigned>(value);
+      resetFormat();
+    }
+    return DEVICE_OK;
+  }
 
-  // Create and return the ndarray
-  auto [dt, shape] = get_dtype_shape(height, width, bytesPerPixel, numComponents);
+  int OnPixelType(MM::PropertyBase* pProp, MM::ActionType eAct) {
+    if (eAct == MM::BeforeGet) {
+      pProp->Set(components_ > 1          ? "32bitRGB"
+                 : bytesPerPixel_ == 1 ? "8bit"
+                 : bytesPerPixel_ == 2 ? "16bit"
+                                       : "32bit");
+    } else if (eAct == MM::AfterSet) {
+      if (int ret = checkFormatChange()) return ret;
+      std::string value;
+      pProp->Get(value);
+      components_ = value == "32bitRGB" ? 4 : 1;
+      bytesPerPixel_ = value == "8bit" ? 1 : value == "16bit" ? 2 : 4;
+      resetFormat();
+    }
+    return DEVICE_OK;
+  }
 
-  // Cast the CMMCore object to an nb::object for ownership
-  nb::object owner = nb::cast(core, nb::rv_policy::reference);
+  int OnExposure(MM::PropertyBase* pProp, MM::ActionType eAct) {
+    if (eAct == MM::BeforeGet) {
+      pProp->Set(exposureMs_);
+    } else if (eAct == MM::AfterSet) {
+      pProp->Get(exposureMs_);
+    }
+    return DEVICE_OK;
+  }
 
-  return ro_np_array(pBuf,          // std::conditional_t<ReadOnly, const void*, void*>
-                     shape.size(),  // size_t ndim
-                     shape.data(),  // const size_t* shape
-                     owner,         // handle owner
-                     nullptr,       // const int64_t *stride (nullptr for default C-contiguous)
-                     dt             // Data type
-  );
-}
-/**
- * @brief Creates a read-only NumPy array representing image metadata from the provided buffer and
- * `CMMCore` instance.
- *
- * This function wraps a raw memory buffer from a `CMMCore` instance into a `nanobind::ndarray` of
- * type `numpy.ndarray`. The array is read-only and shares ownership with the provided `CMMCore`
- * instance to ensure memory safety.
- *
- * @param core A reference to the `CMMCore` object, which provides image metadata and ensures
- *            ownership of the buffer.
- * @param pBuf Pointer to the data buffer containing the image metadata.
- * @param md The metadata object containing the image properties.
- *
- * @return A `nanobind::ndarray` representing the image metadata buffer as a `numpy.ndarray`.
- *
- * @throws std::runtime_error If the combination of image properties (e.g., bytes per pixel, number
- *                          of components) is not supported.
- *
- * @note The resulting array is C-contiguous by default, as no strides are specified.
- */
-ro_np_array create_metadata_array(CMMCore& core, void* pBuf, const Metadata md) {
-  // These keys are unfortunately hard-coded in the source code
-  // see https://github.com/micro-manager/mmCoreAndDevices/pull/531
-  // Retrieve and log the values of the tags
-  std::string width_str = md.GetSingleTag("Width").GetValue();
-  std::string height_str = md.GetSingleTag("Height").GetValue();
-  std::string pixel_type = md.GetSingleTag("PixelType").GetValue();
-  auto [dt, shape] = get_dtype_shape(std::stoi(height_str), std::stoi(width_str), pixel_type);
+  int OnFrameRate(MM::PropertyBase* pProp, MM::ActionType eAct) {
+    if (eAct == MM::BeforeGet) {
+      pProp->Set(frameRateHz_);
+    } else if (eAct == MM::AfterSet) {
+      if (IsCapturing()) return DEVICE_CAMERA_BUSY_ACQUIRING;
+      pProp->Get(frameRateHz_);
+    }
+    return DEVICE_OK;
+  }
 
-  // Cast the CMMCore object to an nb::object for ownership
-  nb::object owner = nb::cast(core, nb::rv_policy::reference);
+  int OnReplayFile(MM::PropertyBase* pProp, MM::ActionType eAct) {
+    if (eAct == MM::BeforeGet) {
+      pProp->Set(replayPath_.c_str());
+    } else if (eAct == MM::AfterSet) {
+      if (IsCapturing()) return DEVICE_CAMERA_BUSY_ACQUIRING;
+      std::string value;
+      pProp->Get(value);
+      replayPath_.clear();
+      if (value.empty()) {
+        closeReplay();
+        return DEVICE_OK;
+      }
+      if (int ret = openReplay(value)) return ret;
+      replayPath_ = value;
+    }
+    return DEVICE_OK;
+  }
 
-  return ro_np_array(pBuf,          // std::conditional_t<ReadOnly, const void*, void*>
-                     shape.size(),  // size_t ndim
-                     shape.data(),  // const size_t* shape
-                     owner,         // handle owner
-                     nullptr,       // const int64_t *stride (nullptr for default C-contiguous)
-                     dt             // Data type
-  );
+  int OnReplayLoop(MM::PropertyBase* pProp, MM::ActionType eAct) {
+    if (eAct == MM::BeforeGet) {
+      pProp->Set(replayLoop_ ? "Yes" : "No");
+    } else if (eAct == MM::AfterSet) {
+      if (IsCapturing()) return DEVICE_CAMERA_BUSY_ACQUIRING;
+      std::string value;
+      pProp->Get(value);
+      replayLoop_ = value == "Yes";
+    }
+    return DEVICE_OK;
+  }
+
+  // format; only changed while not capturing, so the sequence thread reads it unlocked
+  unsigned width_ = 512;
+  unsigned height_ = 512;
+  unsigned bytesPerPixel_ = 2;
+  unsigned components_ = 1;
+  unsigned roi_[4] = {0, 0, 512, 512};  // x, y, width, height
+  std::vector<uint8_t> ramp_;
+  std::vector<uint8_t> snapFrame_;
+  uint64_t snapCount_ = 0;
+  double exposureMs_ = 10;
+  double frameRateHz_ = 1000;
+
+  std::string replayPath_;
+  std::FILE* replayFile_ = nullptr;
+  bool replay_ = false;
+  bool replayLoop_ = false;
+  uint64_t replayOffset_ = 0;
+  std::vector<double> replayTimes_;  // ms since the first recorded frame
+
+  std::atomic<bool> capturing_{false};
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+#if PMN_HAVE_MOCK_ADAPTER
+// Serves `SyntheticCamera` to CMMCore in-process, without loading a device adapter library
+class SyntheticAdapter : public MockDeviceAdapter {
+ public:
+  void InitializeModuleData(
+      std::function<void(const char*, MM::DeviceType, const char*)> registerDevice) override {
+    registerDevice(kSyntheticCameraName, MM::CameraDevice,
+                   "Synthetic high-speed camera with stream replay");
+  }
+  MM::Device* CreateDevice(const char* name) override {
+    if (std::strcmp(name, kSyntheticCameraName) == 0) return new SyntheticCamera();
+    return nullptr;
+  }
+  void DeleteDevice(MM::Device* device) override { delete device; }
+};
+#endif
+
+// Registers the built-in adapter with `core` (once per core); must be called with the GIL held
+void register_synthetic_adapter(CMMCore& core) {
+#if PMN_HAVE_MOCK_ADAPTER
+  static SyntheticAdapter adapter;  // stateless, shared by all cores
+  CoreExtras& extras = core_extras(core);
+  if (extras.syntheticAdapter) return;
+  core.loadMockDeviceAdapter(kSyntheticAdapterName, &adapter);
+  extras.syntheticAdapter = true;
+#else
+  (void)core;
+  throw std::runtime_error("This MMCore cannot register in-process device adapters.");
+#endif
 }
 
 ///////////////// Trampoline class for MMEventCallback ///////////////////
 
 // Allow Python to override virtual functions in MMEventCallback
 // https://nanobind.readthedocs.io/en/latest/classes.html#overriding-virtual-functions-in-python
+//
+// Most CMMCore bindings release the GIL (see `release_gil`), so these methods may be invoked
+// from device threads, or from the calling thread while it does not hold the GIL.  NB_OVERRIDE
+// acquires the GIL (via PyGILState_Ensure) before looking up and calling the Python override,
+// so no additional locking is needed here.  Never call into Python from these methods without
+// going through NB_OVERRIDE.
 
 class PyMMEventCallback : public MMEventCallback {
  public:
   NB_TRAMPOLINE(MMEventCallback, 11);  // Total number of overridable virtual methods.
 
-  void onPropertiesChanged() override { NB_OVERRIDE(onPropertiesChanged); }
+  void onPropertiesChanged() override {
+    static BindingStat& stat = binding_stat("MMEventCallback.onPropertiesChanged");
+    CallbackTimer timer(stat);
+    NB_OVERRIDE(onPropertiesChanged);
+  }
 
   void onPropertyChanged(const char* name, const char* propName, const char* propValue) override {
+    static BindingStat& stat = binding_stat("MMEventCallback.onPropertyChanged");
+    CallbackTimer timer(stat);
     NB_OVERRIDE(onPropertyChanged, name, propName, propValue);
   }
 
   void onChannelGroupChanged(const char* newChannelGroupName) override {
+    static BindingStat& stat = binding_stat("MMEventCallback.onChannelGroupChanged");
+    CallbackTimer timer(stat);
     NB_OVERRIDE(onChannelGroupChanged, newChannelGroupName);
   }
 
   void onConfigGroupChanged(const char* groupName, const char* newConfigName) override {
+    static BindingStat& stat = binding_stat("MMEventCallback.onConfigGroupChanged");
+    CallbackTimer timer(stat);
     NB_OVERRIDE(onConfigGroupChanged, groupName, newConfigName);
   }
 
-  void onSystemConfigurationLoaded() override { NB_OVERRIDE(onSystemConfigurationLoaded); }
+  void onSystemConfigurationLoaded() override {
+    static BindingStat& stat = binding_stat("MMEventCallback.onSystemConfigurationLoaded");
+    CallbackTimer timer(stat);
+    NB_OVERRIDE(onSystemConfigurationLoaded);
+  }
 
   void onPixelSizeChanged(double newPixelSizeUm) override {
+    static BindingStat& stat = binding_stat("MMEventCallback.onPixelSizeChanged");
+    CallbackTimer timer(stat);
     NB_OVERRIDE(onPixelSizeChanged, newPixelSizeUm);
   }
 
   void onPixelSizeAffineChanged(double v0, double v1, double v2, double v3, double v4,
                                 double v5) override {
+    static BindingStat& stat = binding_stat("MMEventCallback.onPixelSizeAffineChanged");
+    CallbackTimer timer(stat);
     NB_OVERRIDE(onPixelSizeAffineChanged, v0, v1, v2, v3, v4, v5);
   }
 
   void onStagePositionChanged(char* name, double pos) override {
+    static BindingStat& stat = binding_stat("MMEventCallback.onStagePositionChanged");
+    CallbackTimer timer(stat);
     NB_OVERRIDE(onStagePositionChanged, name, pos);
   }
 
   void onXYStagePositionChanged(char* name, double xpos, double ypos) override {
+    static BindingStat& stat = binding_stat("MMEventCallback.onXYStagePositionChanged");
+    CallbackTimer timer(stat);
     NB_OVERRIDE(onXYStagePositionChanged, name, xpos, ypos);
   }
 
   void onExposureChanged(char* name, double newExposure) override {
+    static BindingStat& stat = binding_stat("MMEventCallback.onExposureChanged");
+    CallbackTimer timer(stat);
     NB_OVERRIDE(onExposureChanged, name, newExposure);
   }
 
   void onSLMExposureChanged(char* name, double newExposure) override {
+    static BindingStat& stat = binding_stat("MMEventCallback.onSLMExposureChanged");
+    CallbackTimer timer(stat);
     NB_OVERRIDE(onSLMExposureChanged, name, newExposure);
   }
 };
 
+///////////////// Queued event dispatch ///////////////////
+
+/**
+ * @brief An `MMEventCallback` that queues events in C++ instead of calling into Python.
+ *
+ * The callback methods run on whichever (device) thread fires the event and only take a short
+ * mutex; the GIL is never touched.  Python drains the queue in batches on a thread of its choice
+ * with `drain` or `dispatch`.
+ *
+ * When coalescing is enabled, an event replaces the arguments of a still-queued event of the same
+ * type and key (the device and property of `onPropertyChanged`, the stage of
+ * `onStagePositionChanged`, etc.), keeping its place in the queue, so a streaming focus drive
+ * adds one entry per drain instead of one per position.  Only `onSystemConfigurationLoaded` is
+ * never coalesced.  Events can be filtered by callback name and by device; events that are not
+ * associated with a device pass the device filter.  When the queue is full, new events are
+ * dropped and counted.
+ */
+class EventQueue : public MMEventCallback {
+ public:
+  // The callback names, in declaration order
+  static constexpr const char* kEventNames[] = {
+      "onPropertiesChanged",      "onPropertyChanged",        "onChannelGroupChanged",
+      "onConfigGroupChanged",     "onSystemConfigurationLoaded", "onPixelSizeChanged",
+      "onPixelSizeAffineChanged", "onStagePositionChanged",   "onXYStagePositionChanged",
+      "onExposureChanged",        "onSLMExposureChanged"};
+
+  EventQueue(size_t maxSize, bool coalesce, std::optional<std::vector<std::string>> types,
+             std::optional<std::vector<std::string>> devices)
+      : maxSize_(maxSize), coalesce_(coalesce) {
+    if (types) {
+      for (const std::string& type : *types) {
+        if (std::find_if(std::begin(kEventNames), std::end(kEventNames), [&](const char* n) {
+              return type == n;
+            }) == std::end(kEventNames)) {
+          throw nb::value_error(("Unknown event type: " + type).c_str());
+        }
+        types_.insert(type);
+      }
+    }
+    if (devices) devices_.insert(devices->begin(), devices->end());
+  }
+
+  void onPropertiesChanged() override { push("onPropertiesChanged", "", "*", {}, {}); }
+  void onPropertyChanged(const char* name, const char* propName, const char* propValue) override {
+    push("onPropertyChanged", name, std::string(name) + '\0' + propName,
+         {name, propName, propValue}, {});
+  }
+  void onChannelGroupChanged(const char* newChannelGroupName) override {
+    push("onChannelGroupChanged", "", "*", {newChannelGroupName}, {});
+  }
+  void onConfigGroupChanged(const char* groupName, const char* newConfigName) override {
+    push("onConfigGroupChanged", "", groupName, {groupName, newConfigName}, {});
+  }
+  void onSystemConfigurationLoaded() override {
+    push("onSystemConfigurationLoaded", "", "", {}, {});
+  }
+  void onPixelSizeChanged(double newPixelSizeUm) override {
+    push("onPixelSizeChanged", "", "*", {}, {newPixelSizeUm});
+  }
+  void onPixelSizeAffineChanged(double v0, double v1, double v2, double v3, double v4,
+                                double v5) override {
+    push("onPixelSizeAffineChanged", "", "*", {}, {v0, v1, v2, v3, v4, v5});
+  }
+  void onStagePositionChanged(char* name, double pos) override {
+    push("onStagePositionChanged", name, name, {name}, {pos});
+  }
+  void onXYStagePositionChanged(char* name, double xpos, double ypos) override {
+    push("onXYStagePositionChanged", name, name, {name}, {xpos, ypos});
+  }
+  void onExposureChanged(char* name, double newExposure) override {
+    push("onExposureChanged", name, name, {name}, {newExposure});
+  }
+  void onSLMExposureChanged(char* name, double newExposure) override {
+    push("onSLMExposureChanged", name, name, {name}, {newExposure});
+  }
+
+  /**
+   * @brief Removes up to `maxEvents` events (0 = all) from the queue, waiting up to `timeoutMs`
+   * (negative = forever) with the GIL released if it is empty.
+   *
+   * @return A list of `(name, args)` tuples, where `name` is the callback method name.
+   */
+  nb::list drain(size_t maxEvents, double timeoutMs) {
+    nb::list out;
+    for (const Event& event : take(maxEvents, timeoutMs)) {
+      out.append(nb::make_tuple(event.name, event.args()));
+    }
+    return out;
+  }
+
+  /**
+   * @brief Drains the queue like `drain` and calls the method of the same name on `target`
+   * (typically an `MMEventCallback` subclass) for each event.
+   *
+   * @return The number of events dispatched.
+   */
+  size_t dispatch(nb::handle target, size_t maxEvents, double timeoutMs) {
+    std::vector<Event> batch = take(maxEvents, timeoutMs);
+    for (const Event& event : batch) target.attr(event.name)(*event.args());
+    return batch.size();
+  }
+
+  size_t depth() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
+  uint64_t dropped() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+  }
+  uint64_t coalesced() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return coalesced_;
+  }
+
+ private:
+  struct Event {
+    const char* name;  // one of kEventNames
+    std::string key;   // coalescing key, empty if the event is never coalesced
+    std::vector<std::string> strArgs;
+    std::vector<double> numArgs;  // callbacks take string arguments first, then numbers
+
+    // The callback arguments as a Python tuple (requires the GIL)
+    nb::tuple args() const {
+      nb::list out;
+      for (const std::string& s : strArgs) out.append(nb::str(s.c_str(), s.size()));
+      for (double d : numArgs) out.append(nb::float_(d));
+      return nb::tuple(out);
+    }
+  };
+
+  std::vector<Event> take(size_t maxEvents, double timeoutMs) {
+    nb::gil_scoped_release gil;
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto nonEmpty = [&] { return !queue_.empty(); };
+    if (timeoutMs < 0) {
+      ready_.wait(lock, nonEmpty);
+    } else if (timeoutMs > 0) {
+      ready_.wait_for(lock, std::chrono::duration<double, std::milli>(timeoutMs), nonEmpty);
+    }
+    size_t n = maxEvents == 0 ? queue_.size() : std::min(maxEvents, queue_.size());
+    std::vector<Event> batch;
+    batch.reserve(n);
+    for (size_t i = 0; i < n; ++i, ++head_) {
+      Event& event = queue_.front();
+      if (!event.key.empty()) {
+        auto it = index_.find(event.key);
+        if (it != index_.end() && it->second == head_) index_.erase(it);
+      }
+      batch.push_back(std::move(event));
+      queue_.pop_front();
+    }
+    return batch;
+  }
+
+  void push(const char* name, const char* device, std::string key,
+            std::vector<std::string> strArgs, std::vector<double> numArgs) {
+    if (!types_.empty() && !types_.count(name)) return;
+    if (!devices_.empty() && *device && !devices_.count(device)) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (coalesce_ && !key.empty()) {
+      key.insert(0, name);  // keys are per event type
+      auto it = index_.find(key);
+      if (it != index_.end()) {
+        Event& queued = queue_[it->second - head_];
+        queued.strArgs = std::move(strArgs);
+        queued.numArgs = std::move(numArgs);
+        ++coalesced_;
+        return;
+      }
+    } else {
+      key.clear();
+    }
+    if (maxSize_ != 0 && queue_.size() >= maxSize_) {
+      ++dropped_;
+      return;
+    }
+    if (!key.empty()) index_.emplace(key, head_ + queue_.size());
+    queue_.push_back({name, std::move(key), std::move(strArgs), std::move(numArgs)});
+    ready_.notify_one();
+  }
+
+  const size_t maxSize_;
+  const bool coalesce_;
+  std::set<std::string> types_;    // empty = all event types
+  std::set<std::string> devices_;  // empty = all devices
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<Event> queue_;
+  uint64_t head_ = 0;                                // sequence number of queue_.front()
+  std::unordered_map<std::string, uint64_t> index_;  // coalescing key -> sequence number
+  uint64_t dropped_ = 0;
+  uint64_t coalesced_ = 0;
+};
+
+///////////////// Microbenchmarks ///////////////////
+
+// Mean duration of one call of `fn` in nanoseconds, over `iterations` calls after a short warm-up
+template <typename F>
+double time_per_call_ns(size_t iterations, F&& fn) {
+  for (size_t i = 0; i < std::min<size_t>(iterations / 10, 1000); ++i) fn();
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) fn();
+  auto dt = std::chrono::steady_clock::now() - t0;
+  return std::chrono::duration<double, std::nano>(dt).count() / std::max<size_t>(iterations, 1);
+}
+
+// Metadata shaped like a frame popped from the circular buffer, with `extraTags` device tags
+Metadata benchmark_metadata(CMMCore& core, size_t extraTags) {
+  Metadata md;
+  md.PutImageTag("Width", std::to_string(core.getImageWidth()));
+  md.PutImageTag("Height", std::to_string(core.getImageHeight()));
+  md.PutImageTag("PixelType", core.getBytesPerPixel() == 1 ? "GRAY8" : "GRAY16");
+  md.PutImageTag(MM::g_Keyword_Metadata_ImageNumber, "0");
+  md.PutImageTag(MM::g_Keyword_Elapsed_Time_ms, "0.0");
+  for (size_t i = 0; i < extraTags; ++i) {
+    md.PutTag("Property" + std::to_string(i), "Device", std::to_string(i));
+  }
+  return md;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 ///////////////// main _pymmcore_nano module definition  ///////////////////
 ////////////////////////////////////////////////////////////////////////////
@@ -208,6 +5440,8 @@ NB_MODULE(_pymmcore_nano, m) {
   /////////////////// Module Attributes ///////////////////
 
   m.attr("DEVICE_INTERFACE_VERSION") = DEVICE_INTERFACE_VERSION;
+  m.attr("SYNTHETIC_ADAPTER") = kSyntheticAdapterName;
+  m.attr("SYNTHETIC_CAMERA") = kSyntheticCameraName;
 
   m.attr("MM_CODE_OK") = MM_CODE_OK;
   m.attr("MM_CODE_ERR") = MM_CODE_ERR;
@@ -483,7 +5717,16 @@ NB_MODULE(_pymmcore_nano, m) {
           [](Metadata& self, const std::string& key, const std::string& value) {
             self.PutImageTag(key, value);
           },
-          "key"_a, "value"_a, "Adds an image tag");
+          "key"_a, "value"_a, "Adds an image tag")
+
+      // Bulk conversion
+      .def("to_dict", &metadata_to_dict,
+           "Returns all tags as a dict in one call.  Single tags map to their string value, array "
+           "tags to a list of strings.")
+      .def_static("to_columns", &metadata_to_columns, "metadata"_a,
+                  "Converts a sequence of Metadata objects to a dict of columns, one per tag.  "
+                  "Integer tags become int64 arrays, other numeric tags float64 arrays (NaN where "
+                  "missing); all other tags are lists with None where missing.");
 
   nb::class_<MetadataTag>(m, "MetadataTag")
       // MetadataTag is Abstract ... no constructors
@@ -545,6 +5788,227 @@ NB_MODULE(_pymmcore_nano, m) {
       .def("Restore", nb::overload_cast<const char*>(&MetadataArrayTag::Restore), "stream"_a,
            "Restores from a serialized string");
 
+  nb::class_<StreamWriter>(m, "StreamWriter")
+      .def(
+          "__init__",
+          [](StreamWriter* self, CMMCore& core, nb::object path, size_t chunk_bytes,
+             bool metadata) {
+            new (self) StreamWriter(core, nb::str(path).c_str(), chunk_bytes, metadata);
+          },
+          "core"_a, "path"_a, "chunk_bytes"_a = 16 << 20, "metadata"_a = true,
+          "Writer that drains the circular buffer of core to a raw stream file on a background "
+          "thread, without the GIL.  path receives a 4096-byte header followed by the frames "
+          "(memory-mappable with NumPy); path + '.idx' receives a per-frame index of "
+          "(image_number <i8, elapsed_ms <f8) records, and path + '.jsonl' (if metadata is "
+          "True) all metadata tags, one JSON object per frame.  Frames are written in chunks "
+          "of about chunk_bytes.")
+      .def("start", &StreamWriter::start,
+           "Open the output files and start writing frames as they arrive in the circular "
+           "buffer.  The writer finishes on its own once it has written at least one frame and "
+           "the sequence has stopped and the buffer has been drained.")
+      .def("stop", &StreamWriter::stop,
+           "Write the frames remaining in the circular buffer, finalize the files and stop the "
+           "writer.  Raises RuntimeError if writing failed.")
+      .def("flush", &StreamWriter::flush,
+           "Block until all frames popped so far are on disk and the header is up to date")
+      .def_prop_ro("running", &StreamWriter::running, "Whether the writer thread is running")
+      .def_prop_ro("frames_written", &StreamWriter::framesWritten,
+                   "Number of frames written so far")
+      .def_prop_ro("bytes_written", &StreamWriter::bytesWritten,
+                   "Number of image bytes written so far")
+      .def_prop_ro("throughput_mb_s", &StreamWriter::throughputMBps,
+                   "Average write throughput since start(), in MB/s")
+      .def_prop_ro("error", &StreamWriter::error,
+                   "Error message if the writer failed, otherwise an empty string");
+
+  nb::class_<SharedFrameRing>(m, "SharedFrameRing")
+      .def(nb::init<CMMCore&, std::string, uint32_t>(), "core"_a, "name"_a, "slots"_a = 64,
+           "Publishes the frames of core's circular buffer into a named POSIX shared-memory "
+           "ring (e.g. name='/pmn-ring') that other processes can map read-only with "
+           "SharedFrameReader.  Frames are popped on a background thread without the GIL, so "
+           "the ring consumes the circular buffer: do not pop frames in this process (e.g. with "
+           "popNextImage, iterSequence or a StreamWriter) while it runs.  Not supported on "
+           "Windows.")
+      .def("start", &SharedFrameRing::start,
+           "Create the shared-memory segment for the current camera format and start "
+           "publishing frames as they arrive in the circular buffer")
+      .def("stop", &SharedFrameRing::stop,
+           "Stop publishing and unlink the segment name (attached readers keep their mapping).  "
+           "Raises RuntimeError if publishing failed.")
+      .def_prop_ro("name", &SharedFrameRing::name, "Name of the shared-memory segment")
+      .def_prop_ro("running", &SharedFrameRing::running,
+                   "Whether the publisher thread is running")
+      .def_prop_ro("frames_published", &SharedFrameRing::framesPublished,
+                   "Number of frames published so far (still valid after stop)")
+      .def_prop_ro("error", &SharedFrameRing::error,
+                   "Error message if publishing failed, otherwise an empty string");
+
+  nb::class_<SharedFrameReader>(m, "SharedFrameReader")
+      .def(nb::init<const std::string&>(), "name"_a,
+           "Attach read-only to the shared-memory frame ring published under name")
+      .def_prop_ro("write_count", &SharedFrameReader::writeCount,
+                   "Number of frames published so far; frame n is in the ring while n >= "
+                   "write_count - slot_count")
+      .def_prop_ro("slot_count", &SharedFrameReader::slotCount, "Number of slots in the ring")
+      .def_prop_ro("shape", &SharedFrameReader::shape, "Shape of each frame")
+      .def_prop_ro("dtype", &SharedFrameReader::dtype, "NumPy dtype string of the frames")
+      .def(
+          "view",
+          [](nb::handle self, uint64_t n) {
+            return nb::cast<SharedFrameReader&>(self).view(self, n);
+          },
+          "n"_a,
+          "Zero-copy, read-only view of frame n.  The publisher may overwrite the slot at any "
+          "time: check is_valid(n) after using the data.  Raises IndexError if frame n is not "
+          "in the ring.")
+      .def("is_valid", &SharedFrameReader::isValid, "n"_a,
+           "Whether frame n is still intact in its slot (seqlock check)")
+      .def("read", &SharedFrameReader::read, "n"_a,
+           "Copy frame n out of the ring, validated against concurrent overwrites.  Returns a "
+           "tuple of (image, image_number, elapsed_ms).  Raises IndexError if frame n is not (or "
+           "no longer) in the ring.");
+
+  nb::class_<LivePreview>(m, "LivePreview")
+      .def(nb::init<CMMCore&, double, size_t, size_t, bool, double, double>(), "core"_a,
+           "max_rate_hz"_a = 30.0, "max_width"_a = 1024, "max_height"_a = 1024,
+           "binning"_a = true, "low_percentile"_a = 0.1, "high_percentile"_a = 99.9,
+           "Renders the newest frame in core's circular buffer into an 8-bit display image on a "
+           "background thread, at most max_rate_hz times per second.  Frames are binned "
+           "(averaged, or decimated if binning is False) by the smallest integer factor that "
+           "fits them into max_width x max_height, and the low_percentile to high_percentile "
+           "range is mapped onto 0-255.  RGB frames render as (h, w, 3) RGB.  Frames are never "
+           "popped, and frames that arrive faster than the rate are skipped.")
+      .def("start", &LivePreview::start, "Start rendering frames as they arrive")
+      .def("stop", &LivePreview::stop,
+           "Stop rendering.  Raises RuntimeError if rendering failed.")
+      .def(
+          "read",
+          [](LivePreview& self, nb::object out) -> nb::object {
+            if (out.is_none()) return self.read();
+            out_array arr = nb::cast<out_array>(out);
+            return self.readInto(arr) ? out : nb::none();
+          },
+          "out"_a = nb::none(),
+          "Return a copy of the latest display image (uint8), or None if no frame has been "
+          "rendered yet.  If out is given, the image is copied into it (its shape must match, "
+          "see stats()['shape']) and out is returned.")
+      .def("stats", &LivePreview::stats,
+           "Return a dict describing the latest display image: image_number, shape, bin_factor, "
+           "min and max of the binned frame, display_min and display_max (the range mapped onto "
+           "0-255), histogram (a uint64 array of 256 bins over [min, max]) and render_ms, plus "
+           "the frames_rendered and frames_skipped counts.")
+      .def("set_percentiles", &LivePreview::setPercentiles, "low"_a, "high"_a,
+           "Set the percentiles of the autoscaled display range")
+      .def_prop_ro("running", &LivePreview::running, "Whether the render thread is running")
+      .def_prop_ro("error", &LivePreview::error,
+                   "Error message if rendering failed, otherwise an empty string");
+
+  nb::class_<SequencePlan>(m, "SequencePlan")
+      .def(nb::init<CMMCore&>(), "core"_a,
+           "A hardware-triggered acquisition plan for core: one sequence per stage, XY stage, "
+           "camera exposure or property, each with one value per event.  The plan is validated "
+           "against the devices as a whole, loaded in parallel across devices and started and "
+           "stopped in order, all without the GIL.")
+      .def(
+          "add_stage",
+          [](SequencePlan& self, std::string label, const double_array& positions) {
+            self.addStage(std::move(label), to_vector(positions));
+          },
+          "label"_a, "positions"_a, "Add a sequence of focus stage positions (um)")
+      .def(
+          "add_xy_stage",
+          [](SequencePlan& self, std::string label, const double_array& x, const double_array& y) {
+            self.addXYStage(std::move(label), to_vector(x), to_vector(y));
+          },
+          "label"_a, "x"_a, "y"_a, "Add a sequence of XY stage positions (um)")
+      .def(
+          "add_exposure",
+          [](SequencePlan& self, std::string camera, const double_array& exposures) {
+            self.addExposure(std::move(camera), to_vector(exposures));
+          },
+          "camera"_a, "exposures_ms"_a, "Add a sequence of camera exposures (ms)")
+      .def(
+          "add_property",
+          [](SequencePlan& self, std::string label, std::string property, nb::iterable values) {
+            std::vector<std::string> strings;
+            for (nb::handle value : values) strings.emplace_back(nb::str(value).c_str());
+            self.addProperty(std::move(label), std::move(property), std::move(strings));
+          },
+          "label"_a, "property"_a, "values"_a,
+          "Add a sequence of property values (any iterable; values are converted with str)")
+      .def("validate", &SequencePlan::validate, release_gil(),
+           "Check all sequences against their devices: equal lengths, sequenceable devices and "
+           "device maximum lengths.  Raises ValueError listing every problem.")
+      .def("load", &SequencePlan::load, release_gil(),
+           "Validate the plan and load all sequences, in parallel across devices")
+      .def("start", &SequencePlan::start, "camera"_a = false, release_gil(),
+           "Start all sequences in the order they were added (loading them first if needed), "
+           "then, if camera is True, a sequence acquisition of n_events images on the current "
+           "camera.  If anything fails to start, whatever was started is stopped again.")
+      .def("stop", &SequencePlan::stop, release_gil(),
+           "Stop the camera (if started by the plan), then all sequences in reverse order")
+      .def_prop_ro("n_events", &SequencePlan::events, "Number of events in the plan")
+      .def_prop_ro("axes", &SequencePlan::axisNames,
+                   "Names of the sequences in the plan, in the order they were added")
+      .def_prop_ro("loaded", &SequencePlan::loaded, "Whether all sequences are loaded")
+      .def_prop_ro("running", &SequencePlan::running, "Whether the plan has been started")
+      .def_prop_ro("timings", &SequencePlan::timings,
+                   "Duration in ms of the last validate, load, start and stop");
+
+  nb::class_<PropertyHandle>(m, "PropertyHandle")
+      .def(nb::init<CMMCore&, std::string, std::string>(), "core"_a, "label"_a, "property"_a,
+           "A handle to one device property of core, for polling and setting it in tight loops.  "
+           "The property type is looked up once, and values are returned as int, float or str "
+           "according to it.  The handle becomes invalid when the device is unloaded.")
+      .def("get", &PropertyHandle::get,
+           "Return the current value, as an int for Integer properties, a float for Float "
+           "properties and a str otherwise")
+      .def("get_cached", &PropertyHandle::getCached,
+           "Return the value from the system state cache, converted like get")
+      .def("set", &PropertyHandle::set, "value"_a,
+           "Set the value: an int for Integer properties, a number for Float properties, and "
+           "anything convertible with str otherwise")
+      .def_prop_ro("label", &PropertyHandle::label, "Device label")
+      .def_prop_ro("property_name", &PropertyHandle::property, "Property name")
+      .def_prop_ro("type", &PropertyHandle::type, "Property type")
+      .def_prop_ro("read_only", &PropertyHandle::readOnly, "Whether the property is read-only")
+      .def_prop_ro("valid", &PropertyHandle::valid,
+                   "False once the device has been unloaded (the handle then raises on use)");
+
+  nb::class_<SequenceIterator>(m, "SequenceIterator")
+      .def("__iter__", [](nb::handle self) { return self; })
+      .def("__next__", &SequenceIterator::next)
+      .def_prop_ro("overflowed", &SequenceIterator::overflowed,
+                   "Whether the iteration ended because the circular buffer overflowed");
+
+  nb::class_<FrameGrouper>(m, "FrameGrouper")
+      .def(nb::init<CMMCore&, std::optional<std::vector<std::string>>, double,
+                    const std::string&, size_t>(),
+           "core"_a, "cameras"_a = nb::none(), "timeout_ms"_a = 1000.0, "policy"_a = "drop",
+           "max_pending"_a = 64,
+           "Pops frames of several cameras from the circular buffer of core and groups them "
+           "into one set per image number.  A frame's camera is the position of its Camera tag "
+           "in cameras, else its CameraChannelIndex tag, else (without cameras) the order in "
+           "which camera labels first appear; without cameras, getNumberOfCameraChannels() "
+           "cameras are expected.  A set that cannot complete (its missing cameras moved on to "
+           "later images, the sequence ended, or timeout_ms passed since its first frame; "
+           "negative = no timeout) is dropped, or with policy='partial' returned with zeros for "
+           "the missing frames.  At most max_pending sets are held; a frame that starts another "
+           "set evicts (drops) the oldest one, complete or not.")
+      .def("pop", &FrameGrouper::pop, "wait_ms"_a = 0.0,
+           "Return the next set in image number order as (images, metadata): a (ncams, height, "
+           "width[, components]) array and a dict of metadata columns with one entry per camera "
+           "(like popNextImages; missing frames have ImageNumber -1).  Returns None if no set "
+           "is ready within wait_ms (negative = until the sequence ends).")
+      .def("reset", &FrameGrouper::reset,
+           "Drop all pending frames (counting them as unmatched), e.g. between sequences")
+      .def("stats", &FrameGrouper::stats,
+           "Return counters: frames popped, complete sets, partial_sets, dropped_sets, "
+           "evicted_sets (dropped to stay within max_pending), unmatched_frames (frames in "
+           "partial or dropped sets, or whose image format differs from the rest of their set), "
+           "unassigned_frames (no camera or image number) and pending_sets.")
+      .def_prop_ro("n_cameras", &FrameGrouper::cameras, "Number of cameras in a set");
+
   nb::class_<MMEventCallback, PyMMEventCallback>(m, "MMEventCallback")
       .def(nb::init<>())
 
@@ -592,6 +6056,30 @@ NB_MODULE(_pymmcore_nano, m) {
           },
           "name"_a, "xpos"_a, "ypos"_a);
 
+  nb::class_<EventQueue, MMEventCallback>(m, "EventQueue")
+      .def(nb::init<size_t, bool, std::optional<std::vector<std::string>>,
+                    std::optional<std::vector<std::string>>>(),
+           "max_size"_a = 10000, "coalesce"_a = true, "types"_a = nb::none(),
+           "devices"_a = nb::none(),
+           "Event callback that queues events without taking the GIL.  Register it with "
+           "CMMCore.registerCallback and drain it from Python with drain() or dispatch().  "
+           "max_size=0 means unbounded; types and devices optionally restrict the queued events "
+           "to the given callback names (e.g. 'onStagePositionChanged') and device labels.")
+      .def("drain", &EventQueue::drain, "max_events"_a = 0, "timeout_ms"_a = 0.0,
+           "Remove up to max_events queued events (0 = all) and return them as a list of "
+           "(name, args) tuples, waiting up to timeout_ms (negative = forever) for the first "
+           "event with the GIL released")
+      .def("dispatch", &EventQueue::dispatch, "target"_a, "max_events"_a = 0,
+           "timeout_ms"_a = 0.0,
+           "Drain the queue like drain() and call the method of the same name on target (e.g. "
+           "an MMEventCallback subclass) for each event.  Returns the number of events "
+           "dispatched.")
+      .def_prop_ro("depth", &EventQueue::depth, "Number of events currently queued")
+      .def_prop_ro("dropped", &EventQueue::dropped,
+                   "Number of events dropped because the queue was full")
+      .def_prop_ro("coalesced", &EventQueue::coalesced,
+                   "Number of events merged into an already-queued event");
+
   //////////////////// Exceptions ////////////////////
 
   // Register the exception with RuntimeError as the base
@@ -607,40 +6095,123 @@ NB_MODULE(_pymmcore_nano, m) {
 
   //////////////////// MMCore ////////////////////
 
-  nb::class_<CMMCore>(m, "CMMCore")
+  nb::class_<CMMCore>(m, "CMMCore", nb::is_weak_referenceable())
       .def(nb::init<>())
 
       .def(
           "loadSystemConfiguration",
           [](CMMCore& self,
              nb::object fileName) {  // accept any object that can be cast to a string (e.g. Path)
-            self.loadSystemConfiguration(nb::str(fileName).c_str());
+            std::string path = nb::str(fileName).c_str();
+            // loading a configuration unloads all devices first
+            unloading_call(self, nullptr, [&] { self.loadSystemConfiguration(path.c_str()); });
           },
           "fileName"_a)
 
-      .def("saveSystemConfiguration", &CMMCore::saveSystemConfiguration, "fileName"_a)
+      .def("saveSystemConfiguration", &CMMCore::saveSystemConfiguration, "fileName"_a,
+           release_gil())
       .def_static("enableFeature", &CMMCore::enableFeature, "name"_a, "enable"_a)
       .def_static("isFeatureEnabled", &CMMCore::isFeatureEnabled, "name"_a)
-      .def("loadDevice", &CMMCore::loadDevice, "label"_a, "moduleName"_a, "deviceName"_a)
-      .def("unloadDevice", &CMMCore::unloadDevice, "label"_a)
-      .def("unloadAllDevices", &CMMCore::unloadAllDevices)
-      .def("initializeAllDevices", &CMMCore::initializeAllDevices)
-      .def("initializeDevice", &CMMCore::initializeDevice, "label"_a)
-      .def("getDeviceInitializationState", &CMMCore::getDeviceInitializationState, "label"_a)
-      .def("reset", &CMMCore::reset)
-      .def("unloadLibrary", &CMMCore::unloadLibrary, "moduleName"_a)
-      .def("updateCoreProperties", &CMMCore::updateCoreProperties)
+      .def("loadDevice", &CMMCore::loadDevice, "label"_a, "moduleName"_a, "deviceName"_a,
+           release_gil())
+      .def(
+          "unloadDevice",
+          [](CMMCore& self, const char* label) {
+            unloading_call(self, label, [&] { self.unloadDevice(label); });
+          },
+          "label"_a)
+      .def(
+          "unloadAllDevices",
+          [](CMMCore& self) {
+            unloading_call(self, nullptr, [&] { self.unloadAllDevices(); });
+          })
+      .def("initializeAllDevices", &CMMCore::initializeAllDevices, release_gil())
+      .def("initializeDevice", &CMMCore::initializeDevice, "label"_a, release_gil())
+      .def("getDeviceInitializationState", &CMMCore::getDeviceInitializationState, "label"_a,
+           release_gil())
+      .def(
+          "initializeAllDevicesOrdered",
+          [](CMMCore& self) {
+            DeviceGraph graph;
+            std::vector<DeviceInitResult> results;
+            bool parallel = false;
+            auto t0 = std::chrono::steady_clock::now();
+            {
+              nb::gil_scoped_release gil;
+              graph = DeviceGraph::of(self);
+              results = initialize_devices(self, graph, parallel);
+            }
+            double totalMs = elapsed_ms(t0);
+            nb::dict devices;
+            for (size_t i = 0; i < results.size(); ++i) {
+              const DeviceInitResult& r = results[i];
+              nb::dict d;
+              d["state"] = r.state;
+              d["ms"] = std::isnan(r.ms) ? nb::object(nb::none()) : nb::cast(r.ms);
+              d["error"] = r.error.empty() ? nb::object(nb::none()) : nb::cast(r.error);
+              devices[graph.labels[i].c_str()] = d;
+            }
+            nb::dict result;
+            result["parallel"] = parallel;
+            result["total_ms"] = totalMs;
+            result["devices"] = devices;
+            return result;
+          },
+          "Initialize all loaded devices that are not initialized yet, serially and in "
+          "dependency order, with the GIL released: hubs before their peripherals and ports "
+          "before the devices that use them.  Unlike initializeAllDevices, a failing device does "
+          "not stop the others (only the devices that depend on it are skipped).  If no device "
+          "is initialized yet and the ParallelDeviceInitialization feature has been enabled "
+          "(with CMMCore.enableFeature, which applies to all cores in the process), the core "
+          "initializes the devices of different adapter modules concurrently instead, in its own "
+          "order and without per-device timing; devices it did not get to because of a failure "
+          "are then initialized one at a time.  Returns a dict with 'parallel', 'total_ms' and "
+          "'devices', which maps each label, in dependency order, to a dict with 'state', 'ms' "
+          "(None if not timed individually) and 'error' (None on success).")
+      .def(
+          "reset",
+          [](CMMCore& self) {
+            unloading_call(self, nullptr, [&] { self.reset(); });
+          })
+      .def(
+          "unloadLibrary",
+          [](CMMCore& self, const char* moduleName) {
+            // conservatively: devices of the module go with it
+            unloading_call(self, nullptr, [&] { self.unloadLibrary(moduleName); });
+          },
+          "moduleName"_a)
+      .def("updateCoreProperties", &CMMCore::updateCoreProperties, release_gil())
       .def("getCoreErrorText", &CMMCore::getCoreErrorText, "code"_a)
       .def("getVersionInfo", &CMMCore::getVersionInfo)
       .def("getAPIVersionInfo", &CMMCore::getAPIVersionInfo)
-      .def("getSystemState", &CMMCore::getSystemState)
-      .def("setSystemState", &CMMCore::setSystemState, "conf"_a)
-      .def("getConfigState", &CMMCore::getConfigState, "group"_a, "config"_a)
+      .def("getSystemState", &CMMCore::getSystemState, release_gil())
+      .def("setSystemState", &CMMCore::setSystemState, "conf"_a, release_gil())
+      .def(
+          "setSystemStateDiff",
+          [](CMMCore& self, const Configuration& conf) {
+            ConfigDiffResult result;
+            {
+              nb::gil_scoped_release gil;
+              result = apply_configuration_diff(self, conf);
+            }
+            return config_diff_dict(result);
+          },
+          "conf"_a,
+          "Like setSystemState, but skips the settings that already have their value in the "
+          "system state cache, and writes to different devices concurrently (the settings of "
+          "each device in order).  Core settings are applied last, one at a time.  Failed "
+          "settings are retried once after the others (Core settings last); raises if any still "
+          "fail.  Returns a dict with 'skipped' and 'issued' (number of settings), "
+          "'total_ms', and 'device_ms' (time spent writing to each device).")
+      .def("getConfigState", &CMMCore::getConfigState, "group"_a, "config"_a, release_gil())
       .def("getConfigGroupState", nb::overload_cast<const char*>(&CMMCore::getConfigGroupState),
-           "group"_a)
-      .def("saveSystemState", &CMMCore::saveSystemState, "fileName"_a)
-      .def("loadSystemState", &CMMCore::loadSystemState, "fileName"_a)
-      .def("registerCallback", &CMMCore::registerCallback, "cb"_a)
+           "group"_a, release_gil())
+      .def("saveSystemState", &CMMCore::saveSystemState, "fileName"_a, release_gil())
+      .def("loadSystemState", &CMMCore::loadSystemState, "fileName"_a, release_gil())
+      .def("registerCallback", &CMMCore::registerCallback, "cb"_a, nb::keep_alive<1, 2>(),
+           "Register a callback (e.g. an EventQueue) for core events.  The core keeps a "
+           "reference to every callback registered with it, so it stays alive as long as the "
+           "core even if the caller drops its own reference.")
       .def(
           "setPrimaryLogFile",
           [](CMMCore& self,
@@ -672,56 +6243,137 @@ NB_MODULE(_pymmcore_nano, m) {
 
       .def("getDeviceAdapterSearchPaths", &CMMCore::getDeviceAdapterSearchPaths)
       .def("setDeviceAdapterSearchPaths", &CMMCore::setDeviceAdapterSearchPaths, "paths"_a)
-      .def("getDeviceAdapterNames", &CMMCore::getDeviceAdapterNames)
-      .def("getAvailableDevices", &CMMCore::getAvailableDevices, "library"_a)
-      .def("getAvailableDeviceDescriptions", &CMMCore::getAvailableDeviceDescriptions, "library"_a)
-      .def("getAvailableDeviceTypes", &CMMCore::getAvailableDeviceTypes, "library"_a)
+      .def("getDeviceAdapterNames", &CMMCore::getDeviceAdapterNames, release_gil())
+      .def("getAvailableDevices", &CMMCore::getAvailableDevices, "library"_a, release_gil())
+      .def("getAvailableDeviceDescriptions", &CMMCore::getAvailableDeviceDescriptions, "library"_a,
+           release_gil())
+      .def("getAvailableDeviceTypes", &CMMCore::getAvailableDeviceTypes, "library"_a,
+           release_gil())
       .def("getLoadedDevices", &CMMCore::getLoadedDevices)
       .def("getLoadedDevicesOfType", &CMMCore::getLoadedDevicesOfType, "devType"_a)
-      .def("getDeviceType", &CMMCore::getDeviceType, "label"_a)
-      .def("getDeviceLibrary", &CMMCore::getDeviceLibrary, "label"_a)
-      .def("getDeviceName", nb::overload_cast<const char*>(&CMMCore::getDeviceName), "label"_a)
-      .def("getDeviceDescription", &CMMCore::getDeviceDescription, "label"_a)
-      .def("getDevicePropertyNames", &CMMCore::getDevicePropertyNames, "label"_a)
-      .def("hasProperty", &CMMCore::hasProperty, "label"_a, "propName"_a)
-      .def("getProperty", &CMMCore::getProperty, "label"_a, "propName"_a)
+      .def("getDeviceType", &CMMCore::getDeviceType, "label"_a, release_gil())
+      .def("getDeviceLibrary", &CMMCore::getDeviceLibrary, "label"_a, release_gil())
+      .def("getDeviceName", nb::overload_cast<const char*>(&CMMCore::getDeviceName), "label"_a,
+           release_gil())
+      .def("getDeviceDescription", &CMMCore::getDeviceDescription, "label"_a, release_gil())
+      .def("getDevicePropertyNames", &CMMCore::getDevicePropertyNames, "label"_a, release_gil())
+      .def("hasProperty", &CMMCore::hasProperty, "label"_a, "propName"_a, release_gil())
+      .def("getProperty", &CMMCore::getProperty, "label"_a, "propName"_a, release_gil())
       .def("setProperty",
            nb::overload_cast<const char*, const char*, const char*>(&CMMCore::setProperty),
-           "label"_a, "propName"_a, "propValue"_a)
+           "label"_a, "propName"_a, "propValue"_a, release_gil())
       .def("setProperty", nb::overload_cast<const char*, const char*, bool>(&CMMCore::setProperty),
-           "label"_a, "propName"_a, "propValue"_a)
+           "label"_a, "propName"_a, "propValue"_a, release_gil())
       .def("setProperty", nb::overload_cast<const char*, const char*, long>(&CMMCore::setProperty),
-           "label"_a, "propName"_a, "propValue"_a)
+           "label"_a, "propName"_a, "propValue"_a, release_gil())
       .def("setProperty",
            nb::overload_cast<const char*, const char*, float>(&CMMCore::setProperty), "label"_a,
-           "propName"_a, "propValue"_a)
-      .def("getAllowedPropertyValues", &CMMCore::getAllowedPropertyValues, "label"_a, "propName"_a)
-      .def("isPropertyReadOnly", &CMMCore::isPropertyReadOnly, "label"_a, "propName"_a)
-      .def("isPropertyPreInit", &CMMCore::isPropertyPreInit, "label"_a, "propName"_a)
-      .def("isPropertySequenceable", &CMMCore::isPropertySequenceable, "label"_a, "propName"_a)
-      .def("hasPropertyLimits", &CMMCore::hasPropertyLimits, "label"_a, "propName"_a)
-      .def("getPropertyLowerLimit", &CMMCore::getPropertyLowerLimit, "label"_a, "propName"_a)
-      .def("getPropertyUpperLimit", &CMMCore::getPropertyUpperLimit, "label"_a, "propName"_a)
-      .def("getPropertyType", &CMMCore::getPropertyType, "label"_a, "propName"_a)
-      .def("startPropertySequence", &CMMCore::startPropertySequence, "label"_a, "propName"_a)
-      .def("stopPropertySequence", &CMMCore::stopPropertySequence, "label"_a, "propName"_a)
+           "propName"_a, "propValue"_a, release_gil())
+      .def(
+          "getProperties",
+          [](CMMCore& self, std::vector<std::pair<std::string, std::string>> items) {
+            std::vector<std::string> labels, values(items.size()), errors(items.size());
+            for (const auto& item : items) labels.push_back(item.first);
+            {
+              nb::gil_scoped_release gil;
+              for_each_by_device(labels, [&](size_t i) {
+                try {
+                  values[i] = self.getProperty(items[i].first.c_str(), items[i].second.c_str());
+                } catch (const std::exception& e) {
+                  errors[i] = e.what();
+                }
+              });
+            }
+            nb::list result;
+            for (size_t i = 0; i < items.size(); ++i) {
+              if (errors[i].empty()) {
+                result.append(nb::make_tuple(values[i], nb::none()));
+              } else {
+                result.append(nb::make_tuple(nb::none(), errors[i]));
+              }
+            }
+            return result;
+          },
+          "items"_a,
+          "Get many properties in one call, given as (label, propName) pairs.  Devices are "
+          "queried concurrently, the properties of each device in order; Core properties are "
+          "read last, one at a time.  Returns a list of "
+          "(value, error) tuples in the order of items: error is None on success, otherwise "
+          "value is None and error is the error message.")
+      .def(
+          "setProperties",
+          [](CMMCore& self, nb::iterable items, bool waitForSystem) {
+            std::vector<std::string> labels, props;
+            std::vector<PropertyValue> values;
+            for (nb::handle item : items) {
+              auto [label, prop, value] =
+                  nb::cast<std::tuple<std::string, std::string, nb::object>>(item);
+              labels.push_back(std::move(label));
+              props.push_back(std::move(prop));
+              values.push_back(PropertyValue::from(value));
+            }
+            std::vector<std::string> errors(labels.size());
+            {
+              nb::gil_scoped_release gil;
+              for_each_by_device(labels, [&](size_t i) {
+                try {
+                  values[i].set(self, labels[i].c_str(), props[i].c_str());
+                } catch (const std::exception& e) {
+                  errors[i] = e.what();
+                }
+              });
+              if (waitForSystem) self.waitForSystem();
+            }
+            nb::list result;
+            for (const std::string& error : errors) {
+              result.append(error.empty() ? nb::object(nb::none()) : nb::cast(error));
+            }
+            return result;
+          },
+          "items"_a, "waitForSystem"_a = false,
+          "Set many properties in one call, given as (label, propName, value) tuples.  Writes to "
+          "different devices are issued concurrently, the writes to each device in order; Core "
+          "properties are written last, one at a time, once all device writes are done.  "
+          "Values are converted as setProperty would.  With waitForSystem, waits for all devices "
+          "once after the writes (raising if that fails).  Returns a list with one entry per "
+          "item: None on success, otherwise the error message.")
+      .def("getAllowedPropertyValues", &CMMCore::getAllowedPropertyValues, "label"_a, "propName"_a,
+           release_gil())
+      .def("isPropertyReadOnly", &CMMCore::isPropertyReadOnly, "label"_a, "propName"_a,
+           release_gil())
+      .def("isPropertyPreInit", &CMMCore::isPropertyPreInit, "label"_a, "propName"_a,
+           release_gil())
+      .def("isPropertySequenceable", &CMMCore::isPropertySequenceable, "label"_a, "propName"_a,
+           release_gil())
+      .def("hasPropertyLimits", &CMMCore::hasPropertyLimits, "label"_a, "propName"_a,
+           release_gil())
+      .def("getPropertyLowerLimit", &CMMCore::getPropertyLowerLimit, "label"_a, "propName"_a,
+           release_gil())
+      .def("getPropertyUpperLimit", &CMMCore::getPropertyUpperLimit, "label"_a, "propName"_a,
+           release_gil())
+      .def("getPropertyType", &CMMCore::getPropertyType, "label"_a, "propName"_a, release_gil())
+      .def("startPropertySequence", &CMMCore::startPropertySequence, "label"_a, "propName"_a,
+           release_gil())
+      .def("stopPropertySequence", &CMMCore::stopPropertySequence, "label"_a, "propName"_a,
+           release_gil())
       .def("getPropertySequenceMaxLength", &CMMCore::getPropertySequenceMaxLength, "label"_a,
-           "propName"_a)
+           "propName"_a, release_gil())
       .def("loadPropertySequence", &CMMCore::loadPropertySequence, "label"_a, "propName"_a,
-           "eventSequence"_a)
-      .def("deviceBusy", &CMMCore::deviceBusy, "label"_a)
-      .def("waitForDevice", nb::overload_cast<const char*>(&CMMCore::waitForDevice), "label"_a)
-      .def("waitForConfig", &CMMCore::waitForConfig, "group"_a, "configName"_a)
-      .def("systemBusy", &CMMCore::systemBusy)
-      .def("waitForSystem", &CMMCore::waitForSystem)
-      .def("deviceTypeBusy", &CMMCore::deviceTypeBusy, "devType"_a)
-      .def("waitForDeviceType", &CMMCore::waitForDeviceType, "devType"_a)
-      .def("getDeviceDelayMs", &CMMCore::getDeviceDelayMs, "label"_a)
-      .def("setDeviceDelayMs", &CMMCore::setDeviceDelayMs, "label"_a, "delayMs"_a)
-      .def("usesDeviceDelay", &CMMCore::usesDeviceDelay, "label"_a)
+           "eventSequence"_a, release_gil())
+      .def("deviceBusy", &CMMCore::deviceBusy, "label"_a, release_gil())
+      .def("waitForDevice", nb::overload_cast<const char*>(&CMMCore::waitForDevice), "label"_a,
+           release_gil())
+      .def("waitForConfig", &CMMCore::waitForConfig, "group"_a, "configName"_a, release_gil())
+      .def("systemBusy", &CMMCore::systemBusy, release_gil())
+      .def("waitForSystem", &CMMCore::waitForSystem, release_gil())
+      .def("deviceTypeBusy", &CMMCore::deviceTypeBusy, "devType"_a, release_gil())
+      .def("waitForDeviceType", &CMMCore::waitForDeviceType, "devType"_a, release_gil())
+      .def("getDeviceDelayMs", &CMMCore::getDeviceDelayMs, "label"_a, release_gil())
+      .def("setDeviceDelayMs", &CMMCore::setDeviceDelayMs, "label"_a, "delayMs"_a, release_gil())
+      .def("usesDeviceDelay", &CMMCore::usesDeviceDelay, "label"_a, release_gil())
       .def("setTimeoutMs", &CMMCore::setTimeoutMs, "timeoutMs"_a)
       .def("getTimeoutMs", &CMMCore::getTimeoutMs)
-      .def("sleep", &CMMCore::sleep, "intervalMs"_a)
+      .def("sleep", &CMMCore::sleep, "intervalMs"_a, release_gil())
 
       .def("getCameraDevice", &CMMCore::getCameraDevice)
       .def("getShutterDevice", &CMMCore::getShutterDevice)
@@ -732,18 +6384,86 @@ NB_MODULE(_pymmcore_nano, m) {
       .def("getSLMDevice", &CMMCore::getSLMDevice)
       .def("getGalvoDevice", &CMMCore::getGalvoDevice)
       .def("getChannelGroup", &CMMCore::getChannelGroup)
-      .def("setCameraDevice", &CMMCore::setCameraDevice, "cameraLabel"_a)
-      .def("setShutterDevice", &CMMCore::setShutterDevice, "shutterLabel"_a)
-      .def("setFocusDevice", &CMMCore::setFocusDevice, "focusLabel"_a)
-      .def("setXYStageDevice", &CMMCore::setXYStageDevice, "xyStageLabel"_a)
-      .def("setAutoFocusDevice", &CMMCore::setAutoFocusDevice, "focusLabel"_a)
-      .def("setImageProcessorDevice", &CMMCore::setImageProcessorDevice, "procLabel"_a)
-      .def("setSLMDevice", &CMMCore::setSLMDevice, "slmLabel"_a)
-      .def("setGalvoDevice", &CMMCore::setGalvoDevice, "galvoLabel"_a)
+      .def("setCameraDevice", &CMMCore::setCameraDevice, "cameraLabel"_a, release_gil())
+      .def("setShutterDevice", &CMMCore::setShutterDevice, "shutterLabel"_a, release_gil())
+      .def("setFocusDevice", &CMMCore::setFocusDevice, "focusLabel"_a, release_gil())
+      .def("setXYStageDevice", &CMMCore::setXYStageDevice, "xyStageLabel"_a, release_gil())
+      .def("setAutoFocusDevice", &CMMCore::setAutoFocusDevice, "focusLabel"_a, release_gil())
+      .def("setImageProcessorDevice", &CMMCore::setImageProcessorDevice, "procLabel"_a,
+           release_gil())
+      .def("setSLMDevice", &CMMCore::setSLMDevice, "slmLabel"_a, release_gil())
+      .def("setGalvoDevice", &CMMCore::setGalvoDevice, "galvoLabel"_a, release_gil())
       .def("setChannelGroup", &CMMCore::setChannelGroup, "channelGroup"_a)
 
       .def("getSystemStateCache", &CMMCore::getSystemStateCache)
-      .def("updateSystemStateCache", &CMMCore::updateSystemStateCache)
+      .def(
+          "getSystemStateVersion",
+          [](CMMCore& self) {
+            std::shared_ptr<StateVersions> versions = state_versions(self);
+            nb::gil_scoped_release gil;
+            return versions->refresh(self);
+          },
+          "Return the version of the system state cache.  The version starts at 0 and goes up "
+          "by one whenever a call to this method, getSystemStateChanges or getSystemStateDict "
+          "finds that the cache changed since the previous such call.  CMMCore keeps no version "
+          "of its own, so each of these calls copies and compares the whole cache (O(cache "
+          "size)); poll at a modest rate.")
+      .def(
+          "getSystemStateChanges",
+          [](CMMCore& self, uint64_t sinceVersion) {
+            std::shared_ptr<StateVersions> versions = state_versions(self);
+            std::vector<std::pair<StateVersions::Key, StateVersions::Entry>> changes;
+            uint64_t version;
+            {
+              nb::gil_scoped_release gil;
+              versions->refresh(self);
+              version = versions->changedSince(sinceVersion, [&](const auto& key, const auto& e) {
+                changes.emplace_back(key, e);
+              });
+            }
+            nb::list out;
+            for (const auto& [key, e] : changes) {
+              out.append(nb::make_tuple(key.first, key.second,
+                                        e.removed ? nb::object(nb::none()) : nb::cast(e.value)));
+            }
+            return nb::make_tuple(version, out);
+          },
+          "sinceVersion"_a,
+          "Return (version, changes): the current version of the system state cache (see "
+          "getSystemStateVersion) and the (device, property, value) settings that changed after "
+          "sinceVersion, sorted by device and property.  value is None for settings that left "
+          "the cache (e.g. because the device was unloaded).  Pass the returned version next "
+          "time to get only newer changes; 0 returns the whole cache.")
+      .def(
+          "getSystemStateDict",
+          [](CMMCore& self) {
+            std::shared_ptr<StateVersions> versions = state_versions(self);
+            std::vector<std::pair<StateVersions::Key, std::string>> settings;
+            uint64_t version;
+            {
+              nb::gil_scoped_release gil;
+              versions->refresh(self);
+              version = versions->changedSince(0, [&](const auto& key, const auto& e) {
+                if (!e.removed) settings.emplace_back(key, e.value);
+              });
+            }
+            nb::dict state;
+            nb::dict device;
+            const std::string* label = nullptr;
+            for (const auto& [key, value] : settings) {
+              if (!label || *label != key.first) {
+                label = &key.first;
+                device = nb::dict();
+                state[label->c_str()] = device;
+              }
+              device[key.second.c_str()] = value;
+            }
+            return nb::make_tuple(version, state);
+          },
+          "Return (version, state): the current version of the system state cache (see "
+          "getSystemStateVersion) and a snapshot of the cache as a {device: {property: value}} "
+          "dict, built in one call.")
+      .def("updateSystemStateCache", &CMMCore::updateSystemStateCache, release_gil())
       .def("getPropertyFromCache", &CMMCore::getPropertyFromCache, "deviceLabel"_a, "propName"_a)
       .def("getCurrentConfigFromCache", &CMMCore::getCurrentConfigFromCache, "groupName"_a)
       .def("getConfigGroupStateFromCache", &CMMCore::getConfigGroupStateFromCache, "group"_a)
@@ -759,7 +6479,22 @@ NB_MODULE(_pymmcore_nano, m) {
       .def("renameConfigGroup", &CMMCore::renameConfigGroup, "oldGroupName"_a, "newGroupName"_a)
       .def("isGroupDefined", &CMMCore::isGroupDefined, "groupName"_a)
       .def("isConfigDefined", &CMMCore::isConfigDefined, "groupName"_a, "configName"_a)
-      .def("setConfig", &CMMCore::setConfig, "groupName"_a, "configName"_a)
+      .def("setConfig", &CMMCore::setConfig, "groupName"_a, "configName"_a, release_gil())
+      .def(
+          "setConfigDiff",
+          [](CMMCore& self, const char* groupName, const char* configName) {
+            ConfigDiffResult result;
+            {
+              nb::gil_scoped_release gil;
+              result = apply_configuration_diff(self, self.getConfigData(groupName, configName));
+            }
+            return config_diff_dict(result);
+          },
+          "groupName"_a, "configName"_a,
+          "Like setConfig, but applied as setSystemStateDiff: settings whose value is already in "
+          "the system state cache are skipped and different devices are written concurrently.  "
+          "Unlike setConfig, does not emit onConfigGroupChanged.  Returns the same dict as "
+          "setSystemStateDiff.")
 
       .def("deleteConfig", nb::overload_cast<const char*, const char*>(&CMMCore::deleteConfig),
            "groupName"_a, "configName"_a)
@@ -772,19 +6507,22 @@ NB_MODULE(_pymmcore_nano, m) {
            "newConfigName"_a)
       .def("getAvailableConfigGroups", &CMMCore::getAvailableConfigGroups)
       .def("getAvailableConfigs", &CMMCore::getAvailableConfigs, "configGroup"_a)
-      .def("getCurrentConfig", &CMMCore::getCurrentConfig, "groupName"_a)
+      .def("getCurrentConfig", &CMMCore::getCurrentConfig, "groupName"_a, release_gil())
       .def("getConfigData", &CMMCore::getConfigData, "configGroup"_a, "configName"_a)
 
-      .def("getCurrentPixelSizeConfig", nb::overload_cast<>(&CMMCore::getCurrentPixelSizeConfig))
+      .def("getCurrentPixelSizeConfig", nb::overload_cast<>(&CMMCore::getCurrentPixelSizeConfig),
+           release_gil())
       .def("getCurrentPixelSizeConfig",
-           nb::overload_cast<bool>(&CMMCore::getCurrentPixelSizeConfig), "cached"_a)
-      .def("getPixelSizeUm", nb::overload_cast<>(&CMMCore::getPixelSizeUm))
-      .def("getPixelSizeUm", nb::overload_cast<bool>(&CMMCore::getPixelSizeUm), "cached"_a)
+           nb::overload_cast<bool>(&CMMCore::getCurrentPixelSizeConfig), "cached"_a, release_gil())
+      .def("getPixelSizeUm", nb::overload_cast<>(&CMMCore::getPixelSizeUm), release_gil())
+      .def("getPixelSizeUm", nb::overload_cast<bool>(&CMMCore::getPixelSizeUm), "cached"_a,
+           release_gil())
       .def("getPixelSizeUmByID", &CMMCore::getPixelSizeUmByID, "resolutionID"_a)
-      .def("getPixelSizeAffine", nb::overload_cast<>(&CMMCore::getPixelSizeAffine))
-      .def("getPixelSizeAffine", nb::overload_cast<bool>(&CMMCore::getPixelSizeAffine), "cached"_a)
+      .def("getPixelSizeAffine", nb::overload_cast<>(&CMMCore::getPixelSizeAffine), release_gil())
+      .def("getPixelSizeAffine", nb::overload_cast<bool>(&CMMCore::getPixelSizeAffine), "cached"_a,
+           release_gil())
       .def("getPixelSizeAffineByID", &CMMCore::getPixelSizeAffineByID, "resolutionID"_a)
-      .def("getMagnificationFactor", &CMMCore::getMagnificationFactor)
+      .def("getMagnificationFactor", &CMMCore::getMagnificationFactor, release_gil())
       .def("setPixelSizeUm", &CMMCore::setPixelSizeUm, "resolutionID"_a, "pixSize"_a)
       .def("setPixelSizeAffine", &CMMCore::setPixelSizeAffine, "resolutionID"_a, "affine"_a)
       .def("definePixelSizeConfig",
@@ -795,7 +6533,7 @@ NB_MODULE(_pymmcore_nano, m) {
            nb::overload_cast<const char*>(&CMMCore::definePixelSizeConfig), "resolutionID"_a)
       .def("getAvailablePixelSizeConfigs", &CMMCore::getAvailablePixelSizeConfigs)
       .def("isPixelSizeConfigDefined", &CMMCore::isPixelSizeConfigDefined, "resolutionID"_a)
-      .def("setPixelSizeConfig", &CMMCore::setPixelSizeConfig, "resolutionID"_a)
+      .def("setPixelSizeConfig", &CMMCore::setPixelSizeConfig, "resolutionID"_a, release_gil())
       .def("renamePixelSizeConfig", &CMMCore::renamePixelSizeConfig, "oldConfigName"_a,
            "newConfigName"_a)
       .def("deletePixelSizeConfig", &CMMCore::deletePixelSizeConfig, "configName"_a)
@@ -803,15 +6541,16 @@ NB_MODULE(_pymmcore_nano, m) {
 
       // Image Acquisition Methods
       .def("setROI", nb::overload_cast<int, int, int, int>(&CMMCore::setROI), "x"_a, "y"_a,
-           "xSize"_a, "ySize"_a)
+           "xSize"_a, "ySize"_a, release_gil())
       .def("setROI", nb::overload_cast<const char*, int, int, int, int>(&CMMCore::setROI),
-           "label"_a, "x"_a, "y"_a, "xSize"_a, "ySize"_a)
+           "label"_a, "x"_a, "y"_a, "xSize"_a, "ySize"_a, release_gil())
       .def("getROI",
            [](CMMCore& self) {
              int x, y, xSize, ySize;
              self.getROI(x, y, xSize, ySize);             // Call C++ method
              return std::make_tuple(x, y, xSize, ySize);  // Return a tuple
-           })
+           },
+           release_gil())
       .def(
           "getROI",
           [](CMMCore& self, const char* label) {
@@ -819,78 +6558,145 @@ NB_MODULE(_pymmcore_nano, m) {
             self.getROI(label, x, y, xSize, ySize);      // Call the C++ method
             return std::make_tuple(x, y, xSize, ySize);  // Return as Python tuple
           },
-          "label"_a)
-      .def("clearROI", &CMMCore::clearROI)
-      .def("isMultiROISupported", &CMMCore::isMultiROISupported)
-      .def("isMultiROIEnabled", &CMMCore::isMultiROIEnabled)
-      .def("setMultiROI", &CMMCore::setMultiROI, "xs"_a, "ys"_a, "widths"_a, "heights"_a)
-      .def("getMultiROI", &CMMCore::getMultiROI, "xs"_a, "ys"_a, "widths"_a, "heights"_a)
-      .def("setExposure", nb::overload_cast<double>(&CMMCore::setExposure), "exp"_a)
+          "label"_a, release_gil())
+      .def("clearROI", &CMMCore::clearROI, release_gil())
+      .def("isMultiROISupported", &CMMCore::isMultiROISupported, release_gil())
+      .def("isMultiROIEnabled", &CMMCore::isMultiROIEnabled, release_gil())
+      .def("setMultiROI", &CMMCore::setMultiROI, "xs"_a, "ys"_a, "widths"_a, "heights"_a,
+           release_gil())
+      .def("getMultiROI", &CMMCore::getMultiROI, "xs"_a, "ys"_a, "widths"_a, "heights"_a,
+           release_gil())
+      .def("setExposure", nb::overload_cast<double>(&CMMCore::setExposure), "exp"_a, release_gil())
       .def("setExposure", nb::overload_cast<const char*, double>(&CMMCore::setExposure),
-           "cameraLabel"_a, "dExp"_a)
-      .def("getExposure", nb::overload_cast<>(&CMMCore::getExposure))
-      .def("getExposure", nb::overload_cast<const char*>(&CMMCore::getExposure), "label"_a)
-      .def("snapImage", &CMMCore::snapImage)
+           "cameraLabel"_a, "dExp"_a, release_gil())
+      .def("getExposure", nb::overload_cast<>(&CMMCore::getExposure), release_gil())
+      .def("getExposure", nb::overload_cast<const char*>(&CMMCore::getExposure), "label"_a,
+           release_gil())
+      .def("snapImage",
+           [](CMMCore& self) {
+             static BindingStat& stat = binding_stat("snapImage");
+             BindingTimer timer(stat);
+             nb::gil_scoped_release gil;
+             self.snapImage();
+           })
       .def("getImage",
-           [](CMMCore& self) -> ro_np_array { return create_image_array(self, self.getImage()); })
+           [](CMMCore& self) -> ro_np_array {
+             static BindingStat& stat = binding_stat("getImage");
+             BindingTimer timer(stat);
+             return fetch_image_array(self, [&] { return self.getImage(); });
+           })
       .def("getImage",
            [](CMMCore& self, unsigned channel) -> ro_np_array {
-             return create_image_array(self, self.getImage(channel));
+             static BindingStat& stat = binding_stat("getImage");
+             BindingTimer timer(stat);
+             return fetch_image_array(self, [&] { return self.getImage(channel); });
            })
-      .def("getImageWidth", &CMMCore::getImageWidth)
-      .def("getImageHeight", &CMMCore::getImageHeight)
-      .def("getBytesPerPixel", &CMMCore::getBytesPerPixel)
-      .def("getImageBitDepth", &CMMCore::getImageBitDepth)
-      .def("getNumberOfComponents", &CMMCore::getNumberOfComponents)
-      .def("getNumberOfCameraChannels", &CMMCore::getNumberOfCameraChannels)
-      .def("getCameraChannelName", &CMMCore::getCameraChannelName, "channelNr"_a)
-      .def("getImageBufferSize", &CMMCore::getImageBufferSize)
+      .def(
+          "getImage",
+          [](CMMCore& self, out_array out) {
+            static BindingStat& stat = binding_stat("getImage");
+            BindingTimer timer(stat);
+            fetch_image_into(self, out, [&] { return self.getImage(); });
+          },
+          "out"_a, "Copy the last snapped image into the provided (writable) array")
+      .def("getImageWidth", &CMMCore::getImageWidth, release_gil())
+      .def("getImageHeight", &CMMCore::getImageHeight, release_gil())
+      .def("getBytesPerPixel", &CMMCore::getBytesPerPixel, release_gil())
+      .def("getImageBitDepth", &CMMCore::getImageBitDepth, release_gil())
+      .def("getNumberOfComponents", &CMMCore::getNumberOfComponents, release_gil())
+      .def("getNumberOfCameraChannels", &CMMCore::getNumberOfCameraChannels, release_gil())
+      .def("getCameraChannelName", &CMMCore::getCameraChannelName, "channelNr"_a, release_gil())
+      .def("getImageBufferSize", &CMMCore::getImageBufferSize, release_gil())
       .def("setAutoShutter", &CMMCore::setAutoShutter, "state"_a)
       .def("getAutoShutter", &CMMCore::getAutoShutter)
-      .def("setShutterOpen", nb::overload_cast<bool>(&CMMCore::setShutterOpen), "state"_a)
-      .def("getShutterOpen", nb::overload_cast<>(&CMMCore::getShutterOpen))
+      .def("setShutterOpen", nb::overload_cast<bool>(&CMMCore::setShutterOpen), "state"_a,
+           release_gil())
+      .def("getShutterOpen", nb::overload_cast<>(&CMMCore::getShutterOpen), release_gil())
       .def("setShutterOpen", nb::overload_cast<const char*, bool>(&CMMCore::setShutterOpen),
-           "shutterLabel"_a, "state"_a)
+           "shutterLabel"_a, "state"_a, release_gil())
       .def("getShutterOpen", nb::overload_cast<const char*>(&CMMCore::getShutterOpen),
-           "shutterLabel"_a)
+           "shutterLabel"_a, release_gil())
       .def("startSequenceAcquisition",
-           nb::overload_cast<long, double, bool>(&CMMCore::startSequenceAcquisition),
+           [](CMMCore& self, long numImages, double intervalMs, bool stopOnOverflow) {
+             std::atomic<uint64_t>& starts = core_extras(self).sequenceStarts;
+             nb::gil_scoped_release gil;
+             self.startSequenceAcquisition(numImages, intervalMs, stopOnOverflow);
+             starts.fetch_add(1, std::memory_order_relaxed);
+           },
            "numImages"_a, "intervalMs"_a, "stopOnOverflow"_a)
       .def("startSequenceAcquisition",
-           nb::overload_cast<const char*, long, double, bool>(&CMMCore::startSequenceAcquisition),
+           [](CMMCore& self, const char* cameraLabel, long numImages, double intervalMs,
+              bool stopOnOverflow) {
+             std::atomic<uint64_t>& starts = core_extras(self).sequenceStarts;
+             nb::gil_scoped_release gil;
+             self.startSequenceAcquisition(cameraLabel, numImages, intervalMs, stopOnOverflow);
+             starts.fetch_add(1, std::memory_order_relaxed);
+           },
            "cameraLabel"_a, "numImages"_a, "intervalMs"_a, "stopOnOverflow"_a)
-      .def("prepareSequenceAcquisition", &CMMCore::prepareSequenceAcquisition, "cameraLabel"_a)
-      .def("startContinuousSequenceAcquisition", &CMMCore::startContinuousSequenceAcquisition,
+      .def("prepareSequenceAcquisition", &CMMCore::prepareSequenceAcquisition, "cameraLabel"_a,
+           release_gil())
+      .def("startContinuousSequenceAcquisition",
+           [](CMMCore& self, double intervalMs) {
+             std::atomic<uint64_t>& starts = core_extras(self).sequenceStarts;
+             nb::gil_scoped_release gil;
+             self.startContinuousSequenceAcquisition(intervalMs);
+             starts.fetch_add(1, std::memory_order_relaxed);
+           },
            "intervalMs"_a)
-      .def("stopSequenceAcquisition", nb::overload_cast<>(&CMMCore::stopSequenceAcquisition))
+      .def("stopSequenceAcquisition", nb::overload_cast<>(&CMMCore::stopSequenceAcquisition),
+           release_gil())
       .def("stopSequenceAcquisition",
-           nb::overload_cast<const char*>(&CMMCore::stopSequenceAcquisition), "cameraLabel"_a)
-      .def("isSequenceRunning", nb::overload_cast<>(&CMMCore::isSequenceRunning))
+           nb::overload_cast<const char*>(&CMMCore::stopSequenceAcquisition), "cameraLabel"_a,
+           release_gil())
+      .def("isSequenceRunning", nb::overload_cast<>(&CMMCore::isSequenceRunning), release_gil())
       .def("isSequenceRunning", nb::overload_cast<const char*>(&CMMCore::isSequenceRunning),
-           "cameraLabel"_a)
+           "cameraLabel"_a, release_gil())
       .def("getLastImage",
            [](CMMCore& self) -> ro_np_array {
-             return create_image_array(self, self.getLastImage());
+             static BindingStat& stat = binding_stat("getLastImage");
+             BindingTimer timer(stat);
+             return fetch_image_array(self, [&] { return self.getLastImage(); });
            })
       .def("popNextImage",
            [](CMMCore& self) -> ro_np_array {
-             return create_image_array(self, self.popNextImage());
+             static BindingStat& stat = binding_stat("popNextImage");
+             BindingTimer timer(stat);
+             return fetch_popped_array(self, [&] { return self.popNextImage(); });
            })
+      .def(
+          "getLastImage",
+          [](CMMCore& self, out_array out) {
+            static BindingStat& stat = binding_stat("getLastImage");
+            BindingTimer timer(stat);
+            fetch_image_into(self, out, [&] { return self.getLastImage(); });
+          },
+          "out"_a, "Copy the last image in the circular buffer into the provided array")
+      .def(
+          "popNextImage",
+          [](CMMCore& self, out_array out) {
+            static BindingStat& stat = binding_stat("popNextImage");
+            BindingTimer timer(stat);
+            fetch_popped_into(self, out, [&] { return self.popNextImage(); });
+          },
+          "out"_a, "Pop the next image from the circular buffer into the provided array")
       // this is a new overload that returns both the image and the metadata
       // not present in the original C++ API
       .def(
           "getLastImageMD",
           [](CMMCore& self) -> std::tuple<ro_np_array, Metadata> {
+            static BindingStat& stat = binding_stat("getLastImageMD");
+            BindingTimer timer(stat);
             Metadata md;
-            auto img = self.getLastImageMD(md);
-            return {create_metadata_array(self, img, md), md};
+            auto img = fetch_image_array(self, [&] { return self.getLastImageMD(md); }, &md);
+            return {img, md};
           },
           "Get the last image in the circular buffer, return as tuple of image and metadata")
       .def(
           "getLastImageMD",
           [](CMMCore& self, Metadata& md) -> ro_np_array {
-            auto img = self.getLastImageMD(md);
-            return create_metadata_array(self, img, md);
+            static BindingStat& stat = binding_stat("getLastImageMD");
+            BindingTimer timer(stat);
+            return fetch_image_array(self, [&] { return self.getLastImageMD(md); }, &md);
           },
           "md"_a,
           "Get the last image in the circular buffer, store metadata in the provided object")
@@ -898,9 +6704,12 @@ NB_MODULE(_pymmcore_nano, m) {
           "getLastImageMD",
           [](CMMCore& self, unsigned channel,
              unsigned slice) -> std::tuple<ro_np_array, Metadata> {
+            static BindingStat& stat = binding_stat("getLastImageMD");
+            BindingTimer timer(stat);
             Metadata md;
-            auto img = self.getLastImageMD(channel, slice, md);
-            return {create_metadata_array(self, img, md), md};
+            auto img = fetch_image_array(
+                self, [&] { return self.getLastImageMD(channel, slice, md); }, &md);
+            return {img, md};
           },
           "channel"_a, "slice"_a,
           "Get the last image in the circular buffer for a specific channel and slice, return"
@@ -908,8 +6717,10 @@ NB_MODULE(_pymmcore_nano, m) {
       .def(
           "getLastImageMD",
           [](CMMCore& self, unsigned channel, unsigned slice, Metadata& md) -> ro_np_array {
-            auto img = self.getLastImageMD(channel, slice, md);
-            return create_metadata_array(self, img, md);
+            static BindingStat& stat = binding_stat("getLastImageMD");
+            BindingTimer timer(stat);
+            return fetch_image_array(self, [&] { return self.getLastImageMD(channel, slice, md); },
+                                     &md);
           },
           "channel"_a, "slice"_a, "md"_a,
           "Get the last image in the circular buffer for a specific channel and slice, store "
@@ -918,16 +6729,19 @@ NB_MODULE(_pymmcore_nano, m) {
       .def(
           "popNextImageMD",
           [](CMMCore& self) -> std::tuple<ro_np_array, Metadata> {
+            static BindingStat& stat = binding_stat("popNextImageMD");
+            BindingTimer timer(stat);
             Metadata md;
-            auto img = self.popNextImageMD(md);
-            return {create_metadata_array(self, img, md), md};
+            auto img = fetch_popped_array(self, [&] { return self.popNextImageMD(md); }, &md);
+            return {img, md};
           },
           "Get the last image in the circular buffer, return as tuple of image and metadata")
       .def(
           "popNextImageMD",
           [](CMMCore& self, Metadata& md) -> ro_np_array {
-            auto img = self.popNextImageMD(md);
-            return create_metadata_array(self, img, md);
+            static BindingStat& stat = binding_stat("popNextImageMD");
+            BindingTimer timer(stat);
+            return fetch_popped_array(self, [&] { return self.popNextImageMD(md); }, &md);
           },
           "md"_a,
           "Get the last image in the circular buffer, store metadata in the provided object")
@@ -935,9 +6749,12 @@ NB_MODULE(_pymmcore_nano, m) {
           "popNextImageMD",
           [](CMMCore& self, unsigned channel,
              unsigned slice) -> std::tuple<ro_np_array, Metadata> {
+            static BindingStat& stat = binding_stat("popNextImageMD");
+            BindingTimer timer(stat);
             Metadata md;
-            auto img = self.popNextImageMD(channel, slice, md);
-            return {create_metadata_array(self, img, md), md};
+            auto img = fetch_popped_array(
+                self, [&] { return self.popNextImageMD(channel, slice, md); }, &md);
+            return {img, md};
           },
           "channel"_a, "slice"_a,
           "Get the last image in the circular buffer for a specific channel and slice, return"
@@ -945,19 +6762,90 @@ NB_MODULE(_pymmcore_nano, m) {
       .def(
           "popNextImageMD",
           [](CMMCore& self, unsigned channel, unsigned slice, Metadata& md) -> ro_np_array {
-            auto img = self.popNextImageMD(channel, slice, md);
-            return create_metadata_array(self, img, md);
+            static BindingStat& stat = binding_stat("popNextImageMD");
+            BindingTimer timer(stat);
+            return fetch_popped_array(
+                self, [&] { return self.popNextImageMD(channel, slice, md); }, &md);
           },
           "channel"_a, "slice"_a, "md"_a,
           "Get the last image in the circular buffer for a specific channel and slice, store "
           "metadata in the provided object")
+      .def(
+          "popNextImageMD",
+          [](CMMCore& self, out_array out) -> Metadata {
+            static BindingStat& stat = binding_stat("popNextImageMD");
+            BindingTimer timer(stat);
+            Metadata md;
+            fetch_popped_into(self, out, [&] { return self.popNextImageMD(md); }, &md);
+            return md;
+          },
+          "out"_a,
+          "Pop the next image from the circular buffer into the provided array, return its "
+          "metadata")
+      .def(
+          "popNextImageMD",
+          [](CMMCore& self, out_array out, Metadata& md) {
+            static BindingStat& stat = binding_stat("popNextImageMD");
+            BindingTimer timer(stat);
+            fetch_popped_into(self, out, [&] { return self.popNextImageMD(md); }, &md);
+          },
+          "out"_a, "md"_a,
+          "Pop the next image from the circular buffer into the provided array, store metadata "
+          "in the provided object")
+
+      .def("popNextImages", &pop_next_images, "n"_a,
+           "Pop up to n images from the circular buffer in one call.  Returns a tuple of a "
+           "stacked (n, height, width[, components]) array and a dict of per-frame metadata "
+           "columns (ImageNumber, ElapsedTime-ms, Camera)")
+      .def("popNextImages", &pop_next_images_into, "out"_a,
+           "Pop up to out.shape[0] images from the circular buffer into consecutive slices of "
+           "the provided array.  Returns a tuple of the number of images copied and a dict of "
+           "per-frame metadata columns")
+      .def(
+          "iterSequence",
+          [](CMMCore& self, double timeout_ms, std::optional<size_t> batch) {
+            if (batch && *batch == 0) throw nb::value_error("batch must be at least 1");
+            return SequenceIterator(self, timeout_ms, batch.value_or(0));
+          },
+          "timeout_ms"_a = -1.0, "batch"_a = nb::none(),
+          "Iterate over the images of the running sequence acquisition as they arrive, waiting "
+          "with the GIL released.  Yields single images, or (if batch is given) tuples like "
+          "popNextImages(batch).  Iteration ends once the sequence has stopped or the buffer "
+          "overflowed and all remaining images have been popped.  Raises TimeoutError if no "
+          "image arrives within timeout_ms (a negative value waits indefinitely); a partial "
+          "batch is returned instead if some images are available.  With block-averaging image "
+          "correction, each image averages a full block; a partial block left when the sequence "
+          "ends is not returned and stays in the buffer.")
+      .def(
+          "openFrameReadyFd",
+          [](CMMCore& self, double minIntervalMs) {
+            auto minInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::milli>(std::max(minIntervalMs, 0.0)));
+            return buffer_watcher(self)->openFd(minInterval);
+          },
+          "minIntervalMs"_a = 5.0,
+          "Open a non-blocking file descriptor (eventfd on Linux, pipe on macOS) that becomes "
+          "readable when images are waiting in the circular buffer or a sequence acquisition "
+          "has stopped, e.g. for asyncio's loop.add_reader.  Read up to 8 bytes from it to "
+          "reset it, then drain the buffer with popNextImage*.  Signals are coalesced to at most "
+          "one per minIntervalMs.  Returns the same fd until closeFrameReadyFd is called.  Not "
+          "supported on Windows.")
+      .def(
+          "closeFrameReadyFd",
+          [](CMMCore& self) {
+            if (auto& watcher = core_extras(self).watcher) watcher->closeFd();
+          },
+          "Close the file descriptor returned by openFrameReadyFd")
 
       .def(
           "getNBeforeLastImageMD",
           [](CMMCore& self, unsigned long n) -> std::tuple<ro_np_array, Metadata> {
+            static BindingStat& stat = binding_stat("getNBeforeLastImageMD");
+            BindingTimer timer(stat);
             Metadata md;
-            auto img = self.getNBeforeLastImageMD(n, md);
-            return {create_metadata_array(self, img, md), md};
+            auto img = fetch_image_array(self, [&] { return self.getNBeforeLastImageMD(n, md); },
+                                         &md);
+            return {img, md};
           },
           "n"_a,
           "Get the nth image before the last image in the circular buffer and return it as a "
@@ -966,8 +6854,9 @@ NB_MODULE(_pymmcore_nano, m) {
       .def(
           "getNBeforeLastImageMD",
           [](CMMCore& self, unsigned long n, Metadata& md) -> ro_np_array {
-            auto img = self.getNBeforeLastImageMD(n, md);
-            return create_metadata_array(self, img, md);
+            static BindingStat& stat = binding_stat("getNBeforeLastImageMD");
+            BindingTimer timer(stat);
+            return fetch_image_array(self, [&] { return self.getNBeforeLastImageMD(n, md); }, &md);
           },
           "n"_a, "md"_a,
           "Get the nth image before the last image in the circular buffer and store the metadata "
@@ -978,190 +6867,541 @@ NB_MODULE(_pymmcore_nano, m) {
       .def("getBufferTotalCapacity", &CMMCore::getBufferTotalCapacity)
       .def("getBufferFreeCapacity", &CMMCore::getBufferFreeCapacity)
       .def("isBufferOverflowed", &CMMCore::isBufferOverflowed)
-      .def("setCircularBufferMemoryFootprint", &CMMCore::setCircularBufferMemoryFootprint,
-           "sizeMB"_a)
+      .def(
+          "setCircularBufferMemoryFootprint",
+          [](CMMCore& self, unsigned sizeMB) {
+            bool reused;
+            {
+              nb::gil_scoped_release gil;
+              // same size for the same frame format: keep the (already touched) buffer
+              reused = circular_buffer_fits(self, sizeMB);
+              if (reused) self.clearCircularBuffer();
+            }
+            if (reused) {
+              ++core_extras(self).allocationStats.circularBufferReused;
+              return;
+            }
+            allocate_circular_buffer(self, [&] { self.setCircularBufferMemoryFootprint(sizeMB); });
+          },
+          "sizeMB"_a,
+          "Reserve sizeMB of memory for the circular buffer.  If the buffer already has this "
+          "size for the current camera format, it is cleared and kept instead of being "
+          "reallocated.")
       .def("getCircularBufferMemoryFootprint", &CMMCore::getCircularBufferMemoryFootprint)
-      .def("initializeCircularBuffer", &CMMCore::initializeCircularBuffer)
+      .def(
+          "initializeCircularBuffer",
+          [](CMMCore& self) {
+            allocate_circular_buffer(self, [&] { self.initializeCircularBuffer(); });
+          })
       .def("clearCircularBuffer", &CMMCore::clearCircularBuffer)
+      .def(
+          "setBufferAllocationOptions",
+          [](CMMCore& self, bool prefault, bool hugepages) {
+            core_extras(self).allocation = AllocationOptions{prefault, hugepages};
+          },
+          "prefault"_a = true, "hugepages"_a = false,
+          "Set how the bindings allocate their own large buffers (StreamWriter chunks and "
+          "SharedFrameRing segments).  With prefault, every page is touched at allocation time so "
+          "acquisition does not page-fault.  With hugepages, binding-owned buffers are backed by "
+          "hugepages where the OS allows it (Linux).  Applies to buffers allocated afterwards.  "
+          "The circular buffer is allocated by MMCore and is not affected.")
+      .def(
+          "getBufferAllocationStats",
+          [](CMMCore& self) {
+            const AllocationStats& st = core_extras(self).allocationStats;
+            nb::dict d;
+            d["circular_buffer_alloc_ms"] = st.circularBufferAllocMs;
+            d["circular_buffer_reused"] = st.circularBufferReused;
+            d["buffers"] = st.buffers;
+            d["bytes"] = st.bytes;
+            d["hugepage_buffers"] = st.hugepageBuffers;
+            d["alloc_ms"] = st.allocMs;
+            d["fault_ms"] = st.faultMs;
+            return d;
+          },
+          "Return allocation statistics: the duration of the last circular buffer allocation, "
+          "how often an unchanged footprint reused the existing buffer, and the number, total "
+          "size, hugepage count, allocation time and prefault time of binding-owned buffers.")
+      .def(
+          "enableBindingStats",
+          [](CMMCore&, bool enable) {
+            if (enable && !PMN_BINDING_STATS) {
+              throw std::runtime_error("pymmcore-nano was built without binding stats.");
+            }
+            g_bindingStatsEnabled = enable;
+          },
+          "enable"_a,
+          "Enable or disable recording of call counts, bytes and latency histograms for the "
+          "image retrieval, metadata conversion and callback bindings (see getBindingStats).  "
+          "Stats are process-wide, shared by all cores.  Disabled by default; when disabled the "
+          "cost is a single flag check per call.")
+      .def(
+          "isBindingStatsEnabled",
+          [](CMMCore&) { return binding_stats_enabled(); },
+          "Return True if binding stats are being recorded")
+      .def(
+          "getBindingStats",
+          [](CMMCore&) {
+            nb::dict d;
+            std::lock_guard<std::mutex> lock(g_bindingStatsMutex);
+            for (const auto& [name, stat] : binding_stats()) {
+              uint64_t calls = stat.calls.load(std::memory_order_relaxed);
+              uint64_t totalNs = stat.totalNs.load(std::memory_order_relaxed);
+              std::vector<uint64_t> histogram;
+              for (const auto& b : stat.histogram) {
+                histogram.push_back(b.load(std::memory_order_relaxed));
+              }
+              nb::dict s;
+              s["calls"] = calls;
+              s["bytes"] = stat.bytes.load(std::memory_order_relaxed);
+              s["total_ns"] = totalNs;
+              s["mean_ns"] = calls ? static_cast<double>(totalNs) / calls : 0.0;
+              s["max_ns"] = stat.maxNs.load(std::memory_order_relaxed);
+              s["histogram"] = create_column_array(std::move(histogram));
+              d[name.c_str()] = s;
+            }
+            return d;
+          },
+          "Return a dict of binding stats by name (e.g. 'popNextImageMD', "
+          "'MMEventCallback.onExposureChanged', or 'MMEventCallback.gil_wait' for the time spent "
+          "acquiring the GIL before a callback).  Each entry has calls, bytes (wrapped or copied "
+          "image data), total_ns, mean_ns, max_ns and histogram, a uint64 array whose element i "
+          "counts calls that took [2**i, 2**(i+1)) ns.")
+      .def(
+          "resetBindingStats",
+          [](CMMCore&) {
+            std::lock_guard<std::mutex> lock(g_bindingStatsMutex);
+            for (auto& [name, stat] : binding_stats()) stat.reset();
+          },
+          "Reset all binding stats to zero")
+      .def(
+          "setAcquisitionMonitor",
+          [](CMMCore& self, bool enable, double nearOverflowFraction) {
+            if (nearOverflowFraction <= 0 || nearOverflowFraction > 1) {
+              throw nb::value_error("nearOverflowFraction must be in (0, 1]");
+            }
+            CoreExtras& extras = core_extras(self);
+            if (!enable) {
+              std::shared_ptr<AcquisitionMonitor> monitor = std::move(extras.monitor);
+              nb::gil_scoped_release gil;
+              monitor.reset();  // joins the sampling thread
+            } else if (extras.monitor) {
+              extras.monitor->setNearOverflow(nearOverflowFraction);
+            } else {
+              extras.monitor = std::make_shared<AcquisitionMonitor>(
+                  self, extras.poppedFrames, extras.sequenceStarts, nearOverflowFraction);
+            }
+          },
+          "enable"_a, "nearOverflowFraction"_a = 0.9,
+          "Start or stop a background thread that samples the circular buffer every 20 ms "
+          "and keeps health statistics of the current sequence acquisition (see "
+          "getAcquisitionHealth).  The buffer counts as near overflow when its occupancy reaches "
+          "nearOverflowFraction of its capacity.")
+      .def(
+          "getAcquisitionHealth",
+          [](CMMCore& self) {
+            std::shared_ptr<AcquisitionMonitor> monitor = core_extras(self).monitor;
+            if (!monitor) throw std::runtime_error("The acquisition monitor is not enabled.");
+            AcquisitionMonitor::Health h = monitor->health();
+            auto optional_s = [](double s) {
+              return s < 0 ? nb::object(nb::none()) : nb::cast(s);
+            };
+            nb::dict d;
+            d["sequence_running"] = h.running;
+            d["elapsed_s"] = h.elapsedS;
+            d["inserted"] = h.inserted;
+            d["popped"] = h.popped;
+            d["dropped"] = h.dropped;
+            d["remaining"] = h.remaining;
+            d["capacity"] = h.capacity;
+            d["max_occupancy"] = h.maxOccupancy;
+            d["insert_rate_hz"] = h.insertRateHz;
+            d["pop_rate_hz"] = h.popRateHz;
+            d["recent_insert_rate_hz"] = h.recentInsertRateHz;
+            d["recent_pop_rate_hz"] = h.recentPopRateHz;
+            d["lag_frames"] = h.remaining;
+            d["lag_ms"] = h.recentInsertRateHz > 0 ? 1000.0 * h.remaining / h.recentInsertRateHz
+                                                   : 0.0;
+            d["first_near_overflow_s"] = optional_s(h.firstNearOverflowS);
+            d["overflowed"] = h.overflowed;
+            d["overflow_s"] = optional_s(h.overflowS);
+            d["interval_count"] = h.intervals;
+            d["interval_mean_ms"] = h.intervalMeanMs;
+            d["window_interval_std_ms"] =
+                h.intervals > 1 ? std::sqrt(h.windowMeanM2 / (h.intervals - 1)) : 0.0;
+            d["window_interval_min_ms"] = h.windowMeanMinMs;
+            d["window_interval_max_ms"] = h.windowMeanMaxMs;
+            return d;
+          },
+          "Return a snapshot of the acquisition health statistics (requires "
+          "setAcquisitionMonitor(True)).  Counts are for the current or last sequence: frames "
+          "inserted into the circular buffer, popped through the bindings, and dropped (inserted "
+          "but neither popped nor remaining, e.g. overwritten on overflow).  Also reports the "
+          "occupancy (remaining, capacity, max_occupancy), overall and last-second insert and pop "
+          "rates, the consumer lag in frames and milliseconds, seconds into the sequence at which "
+          "the buffer first neared overflow and overflowed (None if never), and the number and "
+          "mean of the intervals between frame insertions.  The window_interval_* entries are "
+          "the std, min and max of the mean interval of each monitor sample (about 20 ms, "
+          "weighted by its frame count): a rate spread, not per-frame jitter, which averages "
+          "out within a sample.")
+      .def(
+          "setImageCorrection",
+          [](CMMCore& self, std::optional<float_array> dark, std::optional<float_array> flat,
+             size_t average, bool rolling, size_t threads) {
+            auto values = [](const std::optional<float_array>& a) {
+              return a ? std::vector<float>(a->data(), a->data() + a->size())
+                       : std::vector<float>();
+            };
+            if (threads == 0) threads = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+            CoreExtras& extras = core_extras(self);
+            extras.correction = std::make_shared<ImageCorrection>(
+                values(dark), values(flat), average, rolling, threads, extras.sequenceStarts);
+          },
+          "dark"_a = nb::none(), "flat"_a = nb::none(), "average"_a = 1, "rolling"_a = false,
+          "threads"_a = 0,
+          "Correct frames as they are popped through popNextImage, popNextImageMD, "
+          "popNextImages and iterSequence, which then return float32 images: subtract dark, "
+          "multiply by the flat-field gain mean(flat - dark) / (flat - dark), and average over "
+          "average frames, either in blocks (each returned image consumes average frames, "
+          "waiting for them while the sequence runs) or rolling (each returned image is the mean "
+          "of the last average frames, starting over with each sequence).  dark and flat must "
+          "have the shape of the camera images.  The work is split across threads worker threads "
+          "(0 for one per core, up to 8).  Frames drained by StreamWriter, SharedFrameRing or "
+          "getLastImage are not corrected, and a frame that does not match the camera format is "
+          "left in the buffer.")
+      .def(
+          "clearImageCorrection", [](CMMCore& self) { core_extras(self).correction.reset(); },
+          "Stop correcting popped frames (see setImageCorrection)")
+      .def(
+          "getImageCorrectionStats",
+          [](CMMCore& self) {
+            std::shared_ptr<ImageCorrection> correction = core_extras(self).correction;
+            if (!correction) throw std::runtime_error("Image correction is not enabled.");
+            ImageCorrection::Stats st = correction->stats();
+            nb::dict d;
+            d["frames_in"] = st.framesIn;
+            d["frames_out"] = st.framesOut;
+            for (auto [name, stage] : {std::pair{"dark", &st.dark}, std::pair{"flat", &st.flat},
+                                       std::pair{"average", &st.average}}) {
+              nb::dict s;
+              s["calls"] = stage->calls;
+              s["total_ms"] = stage->totalMs;
+              s["mean_ms"] = stage->calls ? stage->totalMs / stage->calls : 0.0;
+              s["max_ms"] = stage->maxMs;
+              d[name] = s;
+            }
+            return d;
+          },
+          "Return image correction statistics: frames_in (raw frames popped), frames_out "
+          "(images returned), and for each stage ('dark', which includes the conversion to "
+          "float32, 'flat' and 'average') a dict of calls, total_ms, mean_ms and max_ms.")
+      .def(
+          "setImageCopyPool",
+          [](CMMCore& self, bool enable, size_t maxPooledImages) {
+            CoreExtras& extras = core_extras(self);
+            if (!enable) {
+              extras.copyPool.reset();
+            } else if (!extras.copyPool || extras.copyPool->maxPooled() != maxPooledImages) {
+              extras.copyPool = std::make_shared<FrameCopyPool>(maxPooledImages);
+            }
+          },
+          "enable"_a, "maxPooledImages"_a = 64,
+          "Enable or disable pooled image copies.  When enabled, images returned by getImage, "
+          "getLastImage, popNextImage and the *MD variants are copied out of the circular buffer "
+          "into a slot of a bounded pool right after they are retrieved, and the copy stays "
+          "valid until the array is garbage collected.  This does not pin the frame: the copy is "
+          "made after the core call returns, so MMCore may still overwrite the frame in between "
+          "(e.g. getLastImage on a full buffer).  At most maxPooledImages can be held at once; "
+          "retrieving another image raises CMMError, without popping a frame, until one is "
+          "released.")
+      .def(
+          "isImageCopyPoolEnabled",
+          [](CMMCore& self) -> bool { return core_extras(self).copyPool != nullptr; },
+          "Return True if pooled image copies are enabled")
+      .def(
+          "getPooledImageCount",
+          [](CMMCore& self) -> size_t {
+            const auto& pool = core_extras(self).copyPool;
+            return pool ? pool->inUseCount() : 0;
+          },
+          "Return the number of pooled image copies that are still referenced from Python")
+      .def(
+          "registerSyntheticAdapter", [](CMMCore& self) { register_synthetic_adapter(self); },
+          "Register the device adapter built into pymmcore-nano (SYNTHETIC_ADAPTER) with this "
+          "core, so its SYNTHETIC_CAMERA can be loaded with loadDevice or from a configuration "
+          "file without any adapter library on the search path.  Registering again is a no-op.")
+      .def(
+          "loadSyntheticCamera",
+          [](CMMCore& self, const std::string& label) {
+            register_synthetic_adapter(self);
+            nb::gil_scoped_release gil;
+            self.loadDevice(label.c_str(), kSyntheticAdapterName, kSyntheticCameraName);
+            self.initializeDevice(label.c_str());
+            self.setCameraDevice(label.c_str());
+          },
+          "label"_a = "Camera",
+          "Load, initialize and select the built-in synthetic camera.  It generates frames of "
+          "the configured Width, Height and PixelType at FrameRateHz (thousands of frames per "
+          "second are possible), where pixel (x, y) of frame n is (x + y + n) % 256 and frame n "
+          "carries ImageNumber n and ElapsedTime-ms n * 1000 / FrameRateHz.  Setting its "
+          "ReplayFile property to a recording made with StreamWriter replays that recording at "
+          "its original timing instead (repeatedly if ReplayLoop is Yes).  snapImage takes the "
+          "exposure time.")
 
       // Exposure Sequence Methods
-      .def("isExposureSequenceable", &CMMCore::isExposureSequenceable, "cameraLabel"_a)
-      .def("startExposureSequence", &CMMCore::startExposureSequence, "cameraLabel"_a)
-      .def("stopExposureSequence", &CMMCore::stopExposureSequence, "cameraLabel"_a)
-      .def("getExposureSequenceMaxLength", &CMMCore::getExposureSequenceMaxLength, "cameraLabel"_a)
+      .def("isExposureSequenceable", &CMMCore::isExposureSequenceable, "cameraLabel"_a,
+           release_gil())
+      .def("startExposureSequence", &CMMCore::startExposureSequence, "cameraLabel"_a,
+           release_gil())
+      .def("stopExposureSequence", &CMMCore::stopExposureSequence, "cameraLabel"_a, release_gil())
+      .def("getExposureSequenceMaxLength", &CMMCore::getExposureSequenceMaxLength, "cameraLabel"_a,
+           release_gil())
       .def("loadExposureSequence", &CMMCore::loadExposureSequence, "cameraLabel"_a,
-           "exposureSequence_ms"_a)
+           "exposureSequence_ms"_a, release_gil())
 
       // Autofocus Methods
-      .def("getLastFocusScore", &CMMCore::getLastFocusScore)
-      .def("getCurrentFocusScore", &CMMCore::getCurrentFocusScore)
-      .def("enableContinuousFocus", &CMMCore::enableContinuousFocus, "enable"_a)
-      .def("isContinuousFocusEnabled", &CMMCore::isContinuousFocusEnabled)
-      .def("isContinuousFocusLocked", &CMMCore::isContinuousFocusLocked)
-      .def("isContinuousFocusDrive", &CMMCore::isContinuousFocusDrive, "stageLabel"_a)
-      .def("fullFocus", &CMMCore::fullFocus)
-      .def("incrementalFocus", &CMMCore::incrementalFocus)
-      .def("setAutoFocusOffset", &CMMCore::setAutoFocusOffset, "offset"_a)
-      .def("getAutoFocusOffset", &CMMCore::getAutoFocusOffset)
+      .def("getLastFocusScore", &CMMCore::getLastFocusScore, release_gil())
+      .def("getCurrentFocusScore", &CMMCore::getCurrentFocusScore, release_gil())
+      .def("enableContinuousFocus", &CMMCore::enableContinuousFocus, "enable"_a, release_gil())
+      .def("isContinuousFocusEnabled", &CMMCore::isContinuousFocusEnabled, release_gil())
+      .def("isContinuousFocusLocked", &CMMCore::isContinuousFocusLocked, release_gil())
+      .def("isContinuousFocusDrive", &CMMCore::isContinuousFocusDrive, "stageLabel"_a,
+           release_gil())
+      .def("fullFocus", &CMMCore::fullFocus, release_gil())
+      .def("incrementalFocus", &CMMCore::incrementalFocus, release_gil())
+      .def("setAutoFocusOffset", &CMMCore::setAutoFocusOffset, "offset"_a, release_gil())
+      .def("getAutoFocusOffset", &CMMCore::getAutoFocusOffset, release_gil())
 
       // State Device Control Methods
-      .def("setState", &CMMCore::setState, "stateDeviceLabel"_a, "state"_a)
-      .def("getState", &CMMCore::getState, "stateDeviceLabel"_a)
-      .def("getNumberOfStates", &CMMCore::getNumberOfStates, "stateDeviceLabel"_a)
-      .def("setStateLabel", &CMMCore::setStateLabel, "stateDeviceLabel"_a, "stateLabel"_a)
-      .def("getStateLabel", &CMMCore::getStateLabel, "stateDeviceLabel"_a)
+      .def("setState", &CMMCore::setState, "stateDeviceLabel"_a, "state"_a, release_gil())
+      .def("getState", &CMMCore::getState, "stateDeviceLabel"_a, release_gil())
+      .def("getNumberOfStates", &CMMCore::getNumberOfStates, "stateDeviceLabel"_a, release_gil())
+      .def("setStateLabel", &CMMCore::setStateLabel, "stateDeviceLabel"_a, "stateLabel"_a,
+           release_gil())
+      .def("getStateLabel", &CMMCore::getStateLabel, "stateDeviceLabel"_a, release_gil())
       .def("defineStateLabel", &CMMCore::defineStateLabel, "stateDeviceLabel"_a, "state"_a,
-           "stateLabel"_a)
-      .def("getStateLabels", &CMMCore::getStateLabels, "stateDeviceLabel"_a)
-      .def("getStateFromLabel", &CMMCore::getStateFromLabel, "stateDeviceLabel"_a, "stateLabel"_a)
+           "stateLabel"_a, release_gil())
+      .def("getStateLabels", &CMMCore::getStateLabels, "stateDeviceLabel"_a, release_gil())
+      .def("getStateFromLabel", &CMMCore::getStateFromLabel, "stateDeviceLabel"_a, "stateLabel"_a,
+           release_gil())
 
       // Stage Control Methods
       .def("setPosition", nb::overload_cast<const char*, double>(&CMMCore::setPosition),
-           "stageLabel"_a, "position"_a)
-      .def("setPosition", nb::overload_cast<double>(&CMMCore::setPosition), "position"_a)
-      .def("getPosition", nb::overload_cast<const char*>(&CMMCore::getPosition), "stageLabel"_a)
-      .def("getPosition", nb::overload_cast<>(&CMMCore::getPosition))
+           "stageLabel"_a, "position"_a, release_gil())
+      .def("setPosition", nb::overload_cast<double>(&CMMCore::setPosition), "position"_a,
+           release_gil())
+      .def("getPosition", nb::overload_cast<const char*>(&CMMCore::getPosition), "stageLabel"_a,
+           release_gil())
+      .def("getPosition", nb::overload_cast<>(&CMMCore::getPosition), release_gil())
       .def("setRelativePosition",
            nb::overload_cast<const char*, double>(&CMMCore::setRelativePosition), "stageLabel"_a,
-           "d"_a)
-      .def("setRelativePosition", nb::overload_cast<double>(&CMMCore::setRelativePosition), "d"_a)
-      .def("setOrigin", nb::overload_cast<const char*>(&CMMCore::setOrigin), "stageLabel"_a)
-      .def("setOrigin", nb::overload_cast<>(&CMMCore::setOrigin))
+           "d"_a, release_gil())
+      .def("setRelativePosition", nb::overload_cast<double>(&CMMCore::setRelativePosition), "d"_a,
+           release_gil())
+      .def("setOrigin", nb::overload_cast<const char*>(&CMMCore::setOrigin), "stageLabel"_a,
+           release_gil())
+      .def("setOrigin", nb::overload_cast<>(&CMMCore::setOrigin), release_gil())
       .def("setAdapterOrigin", nb::overload_cast<const char*, double>(&CMMCore::setAdapterOrigin),
-           "stageLabel"_a, "newZUm"_a)
-      .def("setAdapterOrigin", nb::overload_cast<double>(&CMMCore::setAdapterOrigin), "newZUm"_a)
+           "stageLabel"_a, "newZUm"_a, release_gil())
+      .def("setAdapterOrigin", nb::overload_cast<double>(&CMMCore::setAdapterOrigin), "newZUm"_a,
+           release_gil())
 
       // Focus Direction Methods
-      .def("setFocusDirection", &CMMCore::setFocusDirection, "stageLabel"_a, "sign"_a)
-      .def("getFocusDirection", &CMMCore::getFocusDirection, "stageLabel"_a)
+      .def("setFocusDirection", &CMMCore::setFocusDirection, "stageLabel"_a, "sign"_a,
+           release_gil())
+      .def("getFocusDirection", &CMMCore::getFocusDirection, "stageLabel"_a, release_gil())
 
       // Stage Sequence Methods
-      .def("isStageSequenceable", &CMMCore::isStageSequenceable, "stageLabel"_a)
-      .def("isStageLinearSequenceable", &CMMCore::isStageLinearSequenceable, "stageLabel"_a)
-      .def("startStageSequence", &CMMCore::startStageSequence, "stageLabel"_a)
-      .def("stopStageSequence", &CMMCore::stopStageSequence, "stageLabel"_a)
-      .def("getStageSequenceMaxLength", &CMMCore::getStageSequenceMaxLength, "stageLabel"_a)
-      .def("loadStageSequence", &CMMCore::loadStageSequence, "stageLabel"_a, "positionSequence"_a)
+      .def("isStageSequenceable", &CMMCore::isStageSequenceable, "stageLabel"_a, release_gil())
+      .def("isStageLinearSequenceable", &CMMCore::isStageLinearSequenceable, "stageLabel"_a,
+           release_gil())
+      .def("startStageSequence", &CMMCore::startStageSequence, "stageLabel"_a, release_gil())
+      .def("stopStageSequence", &CMMCore::stopStageSequence, "stageLabel"_a, release_gil())
+      .def("getStageSequenceMaxLength", &CMMCore::getStageSequenceMaxLength, "stageLabel"_a,
+           release_gil())
+      .def("loadStageSequence", &CMMCore::loadStageSequence, "stageLabel"_a, "positionSequence"_a,
+           release_gil())
       .def("setStageLinearSequence", &CMMCore::setStageLinearSequence, "stageLabel"_a, "dZ_um"_a,
-           "nSlices"_a)
+           "nSlices"_a, release_gil())
 
       // XY Stage Control Methods
       .def("setXYPosition",
            nb::overload_cast<const char*, double, double>(&CMMCore::setXYPosition),
-           "xyStageLabel"_a, "x"_a, "y"_a)
+           "xyStageLabel"_a, "x"_a, "y"_a, release_gil())
       .def("setXYPosition", nb::overload_cast<double, double>(&CMMCore::setXYPosition), "x"_a,
-           "y"_a)
+           "y"_a, release_gil())
       .def("setRelativeXYPosition",
            nb::overload_cast<const char*, double, double>(&CMMCore::setRelativeXYPosition),
-           "xyStageLabel"_a, "dx"_a, "dy"_a)
+           "xyStageLabel"_a, "dx"_a, "dy"_a, release_gil())
       .def("setRelativeXYPosition",
-           nb::overload_cast<double, double>(&CMMCore::setRelativeXYPosition), "dx"_a, "dy"_a)
+           nb::overload_cast<double, double>(&CMMCore::setRelativeXYPosition), "dx"_a, "dy"_a,
+           release_gil())
       .def("getXYPosition",
            nb::overload_cast<const char*, double&, double&>(&CMMCore::getXYPosition),
-           "xyStageLabel"_a, "x_stage"_a, "y_stage"_a)
+           "xyStageLabel"_a, "x_stage"_a, "y_stage"_a, release_gil())
       .def("getXYPosition", nb::overload_cast<double&, double&>(&CMMCore::getXYPosition),
-           "x_stage"_a, "y_stage"_a)
+           "x_stage"_a, "y_stage"_a, release_gil())
       .def("getXPosition", nb::overload_cast<const char*>(&CMMCore::getXPosition),
-           "xyStageLabel"_a)
+           "xyStageLabel"_a, release_gil())
       .def("getYPosition", nb::overload_cast<const char*>(&CMMCore::getYPosition),
-           "xyStageLabel"_a)
-      .def("getXPosition", nb::overload_cast<>(&CMMCore::getXPosition))
-      .def("getYPosition", nb::overload_cast<>(&CMMCore::getYPosition))
-      .def("stop", &CMMCore::stop, "xyOrZStageLabel"_a)
-      .def("home", &CMMCore::home, "xyOrZStageLabel"_a)
-      .def("setOriginXY", nb::overload_cast<const char*>(&CMMCore::setOriginXY), "xyStageLabel"_a)
-      .def("setOriginXY", nb::overload_cast<>(&CMMCore::setOriginXY))
-      .def("setOriginX", nb::overload_cast<const char*>(&CMMCore::setOriginX), "xyStageLabel"_a)
-      .def("setOriginX", nb::overload_cast<>(&CMMCore::setOriginX))
-      .def("setOriginY", nb::overload_cast<const char*>(&CMMCore::setOriginY), "xyStageLabel"_a)
-      .def("setOriginY", nb::overload_cast<>(&CMMCore::setOriginY))
+           "xyStageLabel"_a, release_gil())
+      .def("getXPosition", nb::overload_cast<>(&CMMCore::getXPosition), release_gil())
+      .def("getYPosition", nb::overload_cast<>(&CMMCore::getYPosition), release_gil())
+      .def("stop", &CMMCore::stop, "xyOrZStageLabel"_a, release_gil())
+      .def("home", &CMMCore::home, "xyOrZStageLabel"_a, release_gil())
+      .def("setOriginXY", nb::overload_cast<const char*>(&CMMCore::setOriginXY), "xyStageLabel"_a,
+           release_gil())
+      .def("setOriginXY", nb::overload_cast<>(&CMMCore::setOriginXY), release_gil())
+      .def("setOriginX", nb::overload_cast<const char*>(&CMMCore::setOriginX), "xyStageLabel"_a,
+           release_gil())
+      .def("setOriginX", nb::overload_cast<>(&CMMCore::setOriginX), release_gil())
+      .def("setOriginY", nb::overload_cast<const char*>(&CMMCore::setOriginY), "xyStageLabel"_a,
+           release_gil())
+      .def("setOriginY", nb::overload_cast<>(&CMMCore::setOriginY), release_gil())
       .def("setAdapterOriginXY",
            nb::overload_cast<const char*, double, double>(&CMMCore::setAdapterOriginXY),
-           "xyStageLabel"_a, "newXUm"_a, "newYUm"_a)
+           "xyStageLabel"_a, "newXUm"_a, "newYUm"_a, release_gil())
       .def("setAdapterOriginXY", nb::overload_cast<double, double>(&CMMCore::setAdapterOriginXY),
-           "newXUm"_a, "newYUm"_a)
+           "newXUm"_a, "newYUm"_a, release_gil())
 
       // XY Stage Sequence Methods
-      .def("isXYStageSequenceable", &CMMCore::isXYStageSequenceable, "xyStageLabel"_a)
-      .def("startXYStageSequence", &CMMCore::startXYStageSequence, "xyStageLabel"_a)
-      .def("stopXYStageSequence", &CMMCore::stopXYStageSequence, "xyStageLabel"_a)
-      .def("getXYStageSequenceMaxLength", &CMMCore::getXYStageSequenceMaxLength, "xyStageLabel"_a)
+      .def("isXYStageSequenceable", &CMMCore::isXYStageSequenceable, "xyStageLabel"_a,
+           release_gil())
+      .def("startXYStageSequence", &CMMCore::startXYStageSequence, "xyStageLabel"_a, release_gil())
+      .def("stopXYStageSequence", &CMMCore::stopXYStageSequence, "xyStageLabel"_a, release_gil())
+      .def("getXYStageSequenceMaxLength", &CMMCore::getXYStageSequenceMaxLength, "xyStageLabel"_a,
+           release_gil())
       .def("loadXYStageSequence", &CMMCore::loadXYStageSequence, "xyStageLabel"_a, "xSequence"_a,
-           "ySequence"_a)
+           "ySequence"_a, release_gil())
 
       // Serial Port Control
       .def("setSerialProperties", &CMMCore::setSerialProperties, "portName"_a, "answerTimeout"_a,
-           "baudRate"_a, "delayBetweenCharsMs"_a, "handshaking"_a, "parity"_a, "stopBits"_a)
+           "baudRate"_a, "delayBetweenCharsMs"_a, "handshaking"_a, "parity"_a, "stopBits"_a,
+           release_gil())
       .def("setSerialPortCommand", &CMMCore::setSerialPortCommand, "portLabel"_a, "command"_a,
-           "term"_a)
-      .def("getSerialPortAnswer", &CMMCore::getSerialPortAnswer, "portLabel"_a, "term"_a)
-      .def("writeToSerialPort", &CMMCore::writeToSerialPort, "portLabel"_a, "data"_a)
-      .def("readFromSerialPort", &CMMCore::readFromSerialPort, "portLabel"_a)
+           "term"_a, release_gil())
+      .def("getSerialPortAnswer", &CMMCore::getSerialPortAnswer, "portLabel"_a, "term"_a,
+           release_gil())
+      .def("writeToSerialPort", &CMMCore::writeToSerialPort, "portLabel"_a, "data"_a,
+           release_gil())
+      .def("readFromSerialPort", &CMMCore::readFromSerialPort, "portLabel"_a, release_gil())
 
       // SLM Control
       .def("setSLMImage", nb::overload_cast<const char*, unsigned char*>(&CMMCore::setSLMImage),
-           "slmLabel"_a, "pixels"_a)
+           "slmLabel"_a, "pixels"_a, release_gil())
       //  .def("setSLMImage", nb::overload_cast<const char*, imgRGB32>(&CMMCore::setSLMImage),
       //       "slmLabel"_a, "pixels"_a)
       .def("setSLMPixelsTo",
            nb::overload_cast<const char*, unsigned char>(&CMMCore::setSLMPixelsTo), "slmLabel"_a,
-           "intensity"_a)
+           "intensity"_a, release_gil())
       .def("setSLMPixelsTo",
            nb::overload_cast<const char*, unsigned char, unsigned char, unsigned char>(
                &CMMCore::setSLMPixelsTo),
-           "slmLabel"_a, "red"_a, "green"_a, "blue"_a)
-      .def("displaySLMImage", &CMMCore::displaySLMImage, "slmLabel"_a)
-      .def("setSLMExposure", &CMMCore::setSLMExposure, "slmLabel"_a, "exposure_ms"_a)
-      .def("getSLMExposure", &CMMCore::getSLMExposure, "slmLabel"_a)
-      .def("getSLMWidth", &CMMCore::getSLMWidth, "slmLabel"_a)
-      .def("getSLMHeight", &CMMCore::getSLMHeight, "slmLabel"_a)
-      .def("getSLMNumberOfComponents", &CMMCore::getSLMNumberOfComponents, "slmLabel"_a)
-      .def("getSLMBytesPerPixel", &CMMCore::getSLMBytesPerPixel, "slmLabel"_a)
+           "slmLabel"_a, "red"_a, "green"_a, "blue"_a, release_gil())
+      .def("displaySLMImage", &CMMCore::displaySLMImage, "slmLabel"_a, release_gil())
+      .def("setSLMExposure", &CMMCore::setSLMExposure, "slmLabel"_a, "exposure_ms"_a,
+           release_gil())
+      .def("getSLMExposure", &CMMCore::getSLMExposure, "slmLabel"_a, release_gil())
+      .def("getSLMWidth", &CMMCore::getSLMWidth, "slmLabel"_a, release_gil())
+      .def("getSLMHeight", &CMMCore::getSLMHeight, "slmLabel"_a, release_gil())
+      .def("getSLMNumberOfComponents", &CMMCore::getSLMNumberOfComponents, "slmLabel"_a,
+           release_gil())
+      .def("getSLMBytesPerPixel", &CMMCore::getSLMBytesPerPixel, "slmLabel"_a, release_gil())
       // SLM Sequence
-      .def("getSLMSequenceMaxLength", &CMMCore::getSLMSequenceMaxLength, "slmLabel"_a)
-      .def("startSLMSequence", &CMMCore::startSLMSequence, "slmLabel"_a)
-      .def("stopSLMSequence", &CMMCore::stopSLMSequence, "slmLabel"_a)
+      .def("getSLMSequenceMaxLength", &CMMCore::getSLMSequenceMaxLength, "slmLabel"_a,
+           release_gil())
+      .def("startSLMSequence", &CMMCore::startSLMSequence, "slmLabel"_a, release_gil())
+      .def("stopSLMSequence", &CMMCore::stopSLMSequence, "slmLabel"_a, release_gil())
       //  .def("loadSLMSequence", &CMMCore::loadSLMSequence, "slmLabel"_a, "imageSequence"_a)
 
       // Galvo Control
       .def("pointGalvoAndFire", &CMMCore::pointGalvoAndFire, "galvoLabel"_a, "x"_a, "y"_a,
-           "pulseTime_us"_a)
+           "pulseTime_us"_a, release_gil())
       .def("setGalvoSpotInterval", &CMMCore::setGalvoSpotInterval, "galvoLabel"_a,
-           "pulseTime_us"_a)
-      .def("setGalvoPosition", &CMMCore::setGalvoPosition, "galvoLabel"_a, "x"_a, "y"_a)
+           "pulseTime_us"_a, release_gil())
+      .def("setGalvoPosition", &CMMCore::setGalvoPosition, "galvoLabel"_a, "x"_a, "y"_a,
+           release_gil())
       .def("getGalvoPosition",
            [](CMMCore& self, const char* galvoLabel) {
              double x, y;
              self.getGalvoPosition(galvoLabel, x, y);  // Call C++ method
              return std::make_tuple(x, y);             // Return a tuple
-           })
+           },
+           release_gil())
       .def("setGalvoIlluminationState", &CMMCore::setGalvoIlluminationState, "galvoLabel"_a,
-           "on"_a)
-      .def("getGalvoXRange", &CMMCore::getGalvoXRange, "galvoLabel"_a)
-      .def("getGalvoXMinimum", &CMMCore::getGalvoXMinimum, "galvoLabel"_a)
-      .def("getGalvoYRange", &CMMCore::getGalvoYRange, "galvoLabel"_a)
-      .def("getGalvoYMinimum", &CMMCore::getGalvoYMinimum, "galvoLabel"_a)
+           "on"_a, release_gil())
+      .def("getGalvoXRange", &CMMCore::getGalvoXRange, "galvoLabel"_a, release_gil())
+      .def("getGalvoXMinimum", &CMMCore::getGalvoXMinimum, "galvoLabel"_a, release_gil())
+      .def("getGalvoYRange", &CMMCore::getGalvoYRange, "galvoLabel"_a, release_gil())
+      .def("getGalvoYMinimum", &CMMCore::getGalvoYMinimum, "galvoLabel"_a, release_gil())
       .def("addGalvoPolygonVertex", &CMMCore::addGalvoPolygonVertex, "galvoLabel"_a,
-           "polygonIndex"_a, "x"_a, "y"_a, R"doc(Add a vertex to a galvo polygon.)doc")
-      .def("deleteGalvoPolygons", &CMMCore::deleteGalvoPolygons, "galvoLabel"_a)
-      .def("loadGalvoPolygons", &CMMCore::loadGalvoPolygons, "galvoLabel"_a)
+           "polygonIndex"_a, "x"_a, "y"_a, release_gil(),
+           R"doc(Add a vertex to a galvo polygon.)doc")
+      .def("deleteGalvoPolygons", &CMMCore::deleteGalvoPolygons, "galvoLabel"_a, release_gil())
+      .def("loadGalvoPolygons", &CMMCore::loadGalvoPolygons, "galvoLabel"_a, release_gil())
       .def("setGalvoPolygonRepetitions", &CMMCore::setGalvoPolygonRepetitions, "galvoLabel"_a,
-           "repetitions"_a)
-      .def("runGalvoPolygons", &CMMCore::runGalvoPolygons, "galvoLabel"_a)
-      .def("runGalvoSequence", &CMMCore::runGalvoSequence, "galvoLabel"_a)
-      .def("getGalvoChannel", &CMMCore::getGalvoChannel, "galvoLabel"_a)
+           "repetitions"_a, release_gil())
+      .def("runGalvoPolygons", &CMMCore::runGalvoPolygons, "galvoLabel"_a, release_gil())
+      .def("runGalvoSequence", &CMMCore::runGalvoSequence, "galvoLabel"_a, release_gil())
+      .def("getGalvoChannel", &CMMCore::getGalvoChannel, "galvoLabel"_a, release_gil())
 
       // Device Discovery
-      .def("supportsDeviceDetection", &CMMCore::supportsDeviceDetection, "deviceLabel"_a)
-      .def("detectDevice", &CMMCore::detectDevice, "deviceLabel"_a)
+      .def("supportsDeviceDetection", &CMMCore::supportsDeviceDetection, "deviceLabel"_a,
+           release_gil())
+      .def("detectDevice", &CMMCore::detectDevice, "deviceLabel"_a, release_gil())
 
       // Hub and Peripheral Devices
-      .def("getParentLabel", &CMMCore::getParentLabel, "peripheralLabel"_a)
-      .def("setParentLabel", &CMMCore::setParentLabel, "deviceLabel"_a, "parentHubLabel"_a)
-      .def("getInstalledDevices", &CMMCore::getInstalledDevices, "hubLabel"_a)
+      .def("getParentLabel", &CMMCore::getParentLabel, "peripheralLabel"_a, release_gil())
+      .def("setParentLabel", &CMMCore::setParentLabel, "deviceLabel"_a, "parentHubLabel"_a,
+           release_gil())
+      .def("getInstalledDevices", &CMMCore::getInstalledDevices, "hubLabel"_a, release_gil())
       .def("getInstalledDeviceDescription", &CMMCore::getInstalledDeviceDescription, "hubLabel"_a,
-           "peripheralLabel"_a)
-      .def("getLoadedPeripheralDevices", &CMMCore::getLoadedPeripheralDevices, "hubLabel"_a)
+           "peripheralLabel"_a, release_gil())
+      .def("getLoadedPeripheralDevices", &CMMCore::getLoadedPeripheralDevices, "hubLabel"_a,
+           release_gil())
 
       ;
+
+  /////////////////// Microbenchmarks ///////////////////
+
+  // Native loops over the internal helpers, driven by benchmarks/run_benchmarks.py.  Each
+  // function returns the mean time per call in nanoseconds.
+  nb::module_ bench = m.def_submodule("_benchmarks", "Microbenchmarks of internal helpers");
+  bench.def(
+      "get_dtype_shape",
+      [](size_t iterations) {
+        volatile size_t sink = 0;
+        return time_per_call_ns(iterations, [&] {
+          sink = sink + get_dtype_shape(512, 512, 2).second.size();
+        });
+      },
+      "iterations"_a);
+  bench.def(
+      "create_image_array",
+      [](CMMCore& core, size_t iterations) {
+        std::vector<uint8_t> frame(core.getImageBufferSize());
+        auto format = camera_dtype_shape(core);
+        return time_per_call_ns(iterations,
+                                [&] { create_image_array(core, frame.data(), format); });
+      },
+      "core"_a, "iterations"_a);
+  bench.def(
+      "create_metadata_array",
+      [](CMMCore& core, size_t iterations) {
+        std::vector<uint8_t> frame(core.getImageBufferSize());
+        Metadata md = benchmark_metadata(core, 0);
+        FrameFormat format;
+        return time_per_call_ns(iterations, [&] {
+          format.update(md);
+          create_metadata_array(core, frame.data(), format);
+        });
+      },
+      "core"_a, "iterations"_a);
+  bench.def(
+      "metadata_copy",
+      [](CMMCore& core, size_t tags, size_t iterations) {
+        Metadata md = benchmark_metadata(core, tags);
+        return time_per_call_ns(iterations, [&] { Metadata copy(md); });
+      },
+      "core"_a, "tags"_a, "iterations"_a, release_gil());
 }
\ No newline at end of file
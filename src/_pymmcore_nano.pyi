@@ -1,4 +1,4 @@
-from collections.abc import Sequence
+from collections.abc import Iterable, Sequence
 import enum
 from typing import Annotated, overload
 from numpy.typing import ArrayLike
@@ -26,6 +26,10 @@ class CMMCore:
     def initializeAllDevices(self) -> None: ...
     def initializeDevice(self, label: str) -> None: ...
     def getDeviceInitializationState(self, label: str) -> DeviceInitializationState: ...
+    def initializeAllDevicesOrdered(self) -> dict:
+        """
+        Initialize all loaded devices that are not initialized yet, serially and in dependency order, with the GIL released: hubs before their peripherals and ports before the devices that use them.  Unlike initializeAllDevices, a failing device does not stop the others (only the devices that depend on it are skipped).  If no device is initialized yet and the ParallelDeviceInitialization feature has been enabled (with CMMCore.enableFeature, which applies to all cores in the process), the core initializes the devices of different adapter modules concurrently instead, in its own order and without per-device timing; devices it did not get to because of a failure are then initialized one at a time.  Returns a dict with 'parallel', 'total_ms' and 'devices', which maps each label, in dependency order, to a dict with 'state', 'ms' (None if not timed individually) and 'error' (None on success).
+        """
     def reset(self) -> None: ...
     def unloadLibrary(self, moduleName: str) -> None: ...
     def updateCoreProperties(self) -> None: ...
@@ -34,11 +38,18 @@ class CMMCore:
     def getAPIVersionInfo(self) -> str: ...
     def getSystemState(self) -> Configuration: ...
     def setSystemState(self, conf: Configuration) -> None: ...
+    def setSystemStateDiff(self, conf: Configuration) -> dict:
+        """
+        Like setSystemState, but skips the settings that already have their value in the system state cache, and writes to different devices concurrently (the settings of each device in order).  Core settings are applied last, one at a time.  Failed settings are retried once after the others (Core settings last); raises if any still fail.  Returns a dict with 'skipped' and 'issued' (number of settings), 'total_ms', and 'device_ms' (time spent writing to each device).
+        """
     def getConfigState(self, group: str, config: str) -> Configuration: ...
     def getConfigGroupState(self, group: str) -> Configuration: ...
     def saveSystemState(self, fileName: str) -> None: ...
     def loadSystemState(self, fileName: str) -> None: ...
-    def registerCallback(self, cb: MMEventCallback) -> None: ...
+    def registerCallback(self, cb: MMEventCallback) -> None:
+        """
+        Register a callback (e.g. an EventQueue) for core events.  The core keeps a reference to every callback registered with it, so it stays alive as long as the core even if the caller drops its own reference.
+        """
     def setPrimaryLogFile(self, filename: object, truncate: bool = False) -> None: ...
     def getPrimaryLogFile(self) -> str: ...
     @overload
@@ -80,6 +91,18 @@ class CMMCore:
     def setProperty(self, label: str, propName: str, propValue: int) -> None: ...
     @overload
     def setProperty(self, label: str, propName: str, propValue: float) -> None: ...
+    def getProperties(
+        self, items: Sequence[tuple[str, str]]
+    ) -> list[tuple[str | None, str | None]]:
+        """
+        Get many properties in one call, given as (label, propName) pairs.  Devices are queried concurrently, the properties of each device in order; Core properties are read last, one at a time.  Returns a list of (value, error) tuples in the order of items: error is None on success, otherwise value is None and error is the error message.
+        """
+    def setProperties(
+        self, items: Iterable, waitForSystem: bool = False
+    ) -> list[str | None]:
+        """
+        Set many properties in one call, given as (label, propName, value) tuples.  Writes to different devices are issued concurrently, the writes to each device in order; Core properties are written last, one at a time, once all device writes are done.  Values are converted as setProperty would.  With waitForSystem, waits for all devices once after the writes (raising if that fails).  Returns a list with one entry per item: None on success, otherwise the error message.
+        """
     def getAllowedPropertyValues(self, label: str, propName: str) -> list[str]: ...
     def isPropertyReadOnly(self, label: str, propName: str) -> bool: ...
     def isPropertyPreInit(self, label: str, propName: str) -> bool: ...
@@ -126,6 +149,20 @@ class CMMCore:
     def setGalvoDevice(self, galvoLabel: str) -> None: ...
     def setChannelGroup(self, channelGroup: str) -> None: ...
     def getSystemStateCache(self) -> Configuration: ...
+    def getSystemStateVersion(self) -> int:
+        """
+        Return the version of the system state cache.  The version starts at 0 and goes up by one whenever a call to this method, getSystemStateChanges or getSystemStateDict finds that the cache changed since the previous such call.  CMMCore keeps no version of its own, so each of these calls copies and compares the whole cache (O(cache size)); poll at a modest rate.
+        """
+    def getSystemStateChanges(
+        self, sinceVersion: int
+    ) -> tuple[int, list[tuple[str, str, str | None]]]:
+        """
+        Return (version, changes): the current version of the system state cache (see getSystemStateVersion) and the (device, property, value) settings that changed after sinceVersion, sorted by device and property.  value is None for settings that left the cache (e.g. because the device was unloaded).  Pass the returned version next time to get only newer changes; 0 returns the whole cache.
+        """
+    def getSystemStateDict(self) -> tuple[int, dict[str, dict[str, str]]]:
+        """
+        Return (version, state): the current version of the system state cache (see getSystemStateVersion) and a snapshot of the cache as a {device: {property: value}} dict, built in one call.
+        """
     def updateSystemStateCache(self) -> None: ...
     def getPropertyFromCache(self, deviceLabel: str, propName: str) -> str: ...
     def getCurrentConfigFromCache(self, groupName: str) -> str: ...
@@ -147,6 +184,10 @@ class CMMCore:
     def isGroupDefined(self, groupName: str) -> bool: ...
     def isConfigDefined(self, groupName: str, configName: str) -> bool: ...
     def setConfig(self, groupName: str, configName: str) -> None: ...
+    def setConfigDiff(self, groupName: str, configName: str) -> dict:
+        """
+        Like setConfig, but applied as setSystemStateDiff: settings whose value is already in the system state cache are skipped and different devices are written concurrently.  Unlike setConfig, does not emit onConfigGroupChanged.  Returns the same dict as setSystemStateDiff.
+        """
     @overload
     def deleteConfig(self, groupName: str, configName: str) -> None: ...
     @overload
@@ -229,6 +270,9 @@ class CMMCore:
     def getImage(self) -> Annotated[ArrayLike, dict(writable=False)]: ...
     @overload
     def getImage(self, arg: int, /) -> Annotated[ArrayLike, dict(writable=False)]: ...
+    @overload
+    def getImage(self, out: Annotated[ArrayLike, dict(device="cpu")]) -> None:
+        """Copy the last snapped image into the provided (writable) array"""
     def getImageWidth(self) -> int: ...
     def getImageHeight(self) -> int: ...
     def getBytesPerPixel(self) -> int: ...
@@ -265,9 +309,17 @@ class CMMCore:
     def isSequenceRunning(self) -> bool: ...
     @overload
     def isSequenceRunning(self, cameraLabel: str) -> bool: ...
+    @overload
     def getLastImage(self) -> Annotated[ArrayLike, dict(writable=False)]: ...
+    @overload
+    def getLastImage(self, out: Annotated[ArrayLike, dict(device="cpu")]) -> None:
+        """Copy the last image in the circular buffer into the provided array"""
+    @overload
     def popNextImage(self) -> Annotated[ArrayLike, dict(writable=False)]: ...
     @overload
+    def popNextImage(self, out: Annotated[ArrayLike, dict(device="cpu")]) -> None:
+        """Pop the next image from the circular buffer into the provided array"""
+    @overload
     def getLastImageMD(
         self,
     ) -> tuple[Annotated[ArrayLike, dict(writable=False)], Metadata]:
@@ -324,6 +376,42 @@ class CMMCore:
         Get the last image in the circular buffer for a specific channel and slice, store metadata in the provided object
         """
     @overload
+    def popNextImageMD(self, out: Annotated[ArrayLike, dict(device="cpu")]) -> Metadata:
+        """
+        Pop the next image from the circular buffer into the provided array, return its metadata
+        """
+    @overload
+    def popNextImageMD(
+        self, out: Annotated[ArrayLike, dict(device="cpu")], md: Metadata
+    ) -> None:
+        """
+        Pop the next image from the circular buffer into the provided array, store metadata in the provided object
+        """
+    @overload
+    def popNextImages(self, n: int) -> tuple[ArrayLike, dict]:
+        """
+        Pop up to n images from the circular buffer in one call.  Returns a tuple of a stacked (n, height, width[, components]) array and a dict of per-frame metadata columns (ImageNumber, ElapsedTime-ms, Camera)
+        """
+    @overload
+    def popNextImages(
+        self, out: Annotated[ArrayLike, dict(device="cpu")]
+    ) -> tuple[int, dict]:
+        """
+        Pop up to out.shape[0] images from the circular buffer into consecutive slices of the provided array.  Returns a tuple of the number of images copied and a dict of per-frame metadata columns
+        """
+    def iterSequence(
+        self, timeout_ms: float = -1.0, batch: int | None = None
+    ) -> SequenceIterator:
+        """
+        Iterate over the images of the running sequence acquisition as they arrive, waiting with the GIL released.  Yields single images, or (if batch is given) tuples like popNextImages(batch).  Iteration ends once the sequence has stopped or the buffer overflowed and all remaining images have been popped.  Raises TimeoutError if no image arrives within timeout_ms (a negative value waits indefinitely); a partial batch is returned instead if some images are available.  With block-averaging image correction, each image averages a full block; a partial block left when the sequence ends is not returned and stays in the buffer.
+        """
+    def openFrameReadyFd(self, minIntervalMs: float = 5.0) -> int:
+        """
+        Open a non-blocking file descriptor (eventfd on Linux, pipe on macOS) that becomes readable when images are waiting in the circular buffer or a sequence acquisition has stopped, e.g. for asyncio's loop.add_reader.  Read up to 8 bytes from it to reset it, then drain the buffer with popNextImage*.  Signals are coalesced to at most one per minIntervalMs.  Returns the same fd until closeFrameReadyFd is called.  Not supported on Windows.
+        """
+    def closeFrameReadyFd(self) -> None:
+        """Close the file descriptor returned by openFrameReadyFd"""
+    @overload
     def getNBeforeLastImageMD(
         self, n: int
     ) -> tuple[Annotated[ArrayLike, dict(writable=False)], Metadata]:
@@ -341,10 +429,86 @@ class CMMCore:
     def getBufferTotalCapacity(self) -> int: ...
     def getBufferFreeCapacity(self) -> int: ...
     def isBufferOverflowed(self) -> bool: ...
-    def setCircularBufferMemoryFootprint(self, sizeMB: int) -> None: ...
+    def setCircularBufferMemoryFootprint(self, sizeMB: int) -> None:
+        """
+        Reserve sizeMB of memory for the circular buffer.  If the buffer already has this size for the current camera format, it is cleared and kept instead of being reallocated.
+        """
     def getCircularBufferMemoryFootprint(self) -> int: ...
     def initializeCircularBuffer(self) -> None: ...
     def clearCircularBuffer(self) -> None: ...
+    def setBufferAllocationOptions(
+        self, prefault: bool = True, hugepages: bool = False
+    ) -> None:
+        """
+        Set how the bindings allocate their own large buffers (StreamWriter chunks and SharedFrameRing segments).  With prefault, every page is touched at allocation time so acquisition does not page-fault.  With hugepages, binding-owned buffers are backed by hugepages where the OS allows it (Linux).  Applies to buffers allocated afterwards.  The circular buffer is allocated by MMCore and is not affected.
+        """
+    def getBufferAllocationStats(self) -> dict[str, float | int]:
+        """
+        Return allocation statistics: the duration of the last circular buffer allocation, how often an unchanged footprint reused the existing buffer, and the number, total size, hugepage count, allocation time and prefault time of binding-owned buffers.
+        """
+    def enableBindingStats(self, enable: bool) -> None:
+        """
+        Enable or disable recording of call counts, bytes and latency histograms for the image retrieval, metadata conversion and callback bindings (see getBindingStats).  Stats are process-wide, shared by all cores.  Disabled by default; when disabled the cost is a single flag check per call.
+        """
+    def isBindingStatsEnabled(self) -> bool:
+        """Return True if binding stats are being recorded"""
+    def getBindingStats(self) -> dict:
+        """
+        Return a dict of binding stats by name (e.g. 'popNextImageMD', 'MMEventCallback.onExposureChanged', or 'MMEventCallback.gil_wait' for the time spent acquiring the GIL before a callback).  Each entry has calls, bytes (wrapped or copied image data), total_ns, mean_ns, max_ns and histogram, a uint64 array whose element i counts calls that took [2**i, 2**(i+1)) ns.
+        """
+    def resetBindingStats(self) -> None:
+        """Reset all binding stats to zero"""
+    def setAcquisitionMonitor(
+        self, enable: bool, nearOverflowFraction: float = 0.9
+    ) -> None:
+        """
+        Start or stop a background thread that samples the circular buffer every 20 ms and keeps health statistics of the current sequence acquisition (see getAcquisitionHealth).  The buffer counts as near overflow when its occupancy reaches nearOverflowFraction of its capacity.
+        """
+    def getAcquisitionHealth(self) -> dict:
+        """
+        Return a snapshot of the acquisition health statistics (requires setAcquisitionMonitor(True)).  Counts are for the current or last sequence: frames inserted into the circular buffer, popped through the bindings, and dropped (inserted but neither popped nor remaining, e.g. overwritten on overflow).  Also reports the occupancy (remaining, capacity, max_occupancy), overall and last-second insert and pop rates, the consumer lag in frames and milliseconds, seconds into the sequence at which the buffer first neared overflow and overflowed (None if never), and the number and mean of the intervals between frame insertions.  The window_interval_* entries are the std, min and max of the mean interval of each monitor sample (about 20 ms, weighted by its frame count): a rate spread, not per-frame jitter, which averages out within a sample.
+        """
+    def setImageCorrection(
+        self,
+        dark: Annotated[
+            ArrayLike, dict(dtype="float32", writable=False, order="C", device="cpu")
+        ]
+        | None = None,
+        flat: Annotated[
+            ArrayLike, dict(dtype="float32", writable=False, order="C", device="cpu")
+        ]
+        | None = None,
+        average: int = 1,
+        rolling: bool = False,
+        threads: int = 0,
+    ) -> None:
+        """
+        Correct frames as they are popped through popNextImage, popNextImageMD, popNextImages and iterSequence, which then return float32 images: subtract dark, multiply by the flat-field gain mean(flat - dark) / (flat - dark), and average over average frames, either in blocks (each returned image consumes average frames, waiting for them while the sequence runs) or rolling (each returned image is the mean of the last average frames, starting over with each sequence).  dark and flat must have the shape of the camera images.  The work is split across threads worker threads (0 for one per core, up to 8).  Frames drained by StreamWriter, SharedFrameRing or getLastImage are not corrected, and a frame that does not match the camera format is left in the buffer.
+        """
+    def clearImageCorrection(self) -> None:
+        """Stop correcting popped frames (see setImageCorrection)"""
+    def getImageCorrectionStats(self) -> dict:
+        """
+        Return image correction statistics: frames_in (raw frames popped), frames_out (images returned), and for each stage ('dark', which includes the conversion to float32, 'flat' and 'average') a dict of calls, total_ms, mean_ms and max_ms.
+        """
+    def setImageCopyPool(self, enable: bool, maxPooledImages: int = 64) -> None:
+        """
+        Enable or disable pooled image copies.  When enabled, images returned by getImage, getLastImage, popNextImage and the *MD variants are copied out of the circular buffer into a slot of a bounded pool right after they are retrieved, and the copy stays valid until the array is garbage collected.  This does not pin the frame: the copy is made after the core call returns, so MMCore may still overwrite the frame in between (e.g. getLastImage on a full buffer).  At most maxPooledImages can be held at once; retrieving another image raises CMMError, without popping a frame, until one is released.
+        """
+    def isImageCopyPoolEnabled(self) -> bool:
+        """Return True if pooled image copies are enabled"""
+    def getPooledImageCount(self) -> int:
+        """
+        Return the number of pooled image copies that are still referenced from Python
+        """
+    def registerSyntheticAdapter(self) -> None:
+        """
+        Register the device adapter built into pymmcore-nano (SYNTHETIC_ADAPTER) with this core, so its SYNTHETIC_CAMERA can be loaded with loadDevice or from a configuration file without any adapter library on the search path.  Registering again is a no-op.
+        """
+    def loadSyntheticCamera(self, label: str = "Camera") -> None:
+        """
+        Load, initialize and select the built-in synthetic camera.  It generates frames of the configured Width, Height and PixelType at FrameRateHz (thousands of frames per second are possible), where pixel (x, y) of frame n is (x + y + n) % 256 and frame n carries ImageNumber n and ElapsedTime-ms n * 1000 / FrameRateHz.  Setting its ReplayFile property to a recording made with StreamWriter replays that recording at its original timing instead (repeatedly if ReplayLoop is Yes).  snapImage takes the exposure time.
+        """
     def isExposureSequenceable(self, cameraLabel: str) -> bool: ...
     def startExposureSequence(self, cameraLabel: str) -> None: ...
     def stopExposureSequence(self, cameraLabel: str) -> None: ...
@@ -614,11 +778,105 @@ class DeviceType(enum.IntEnum):
     HubDevice = 15
     GalvoDevice = 16
 
+class EventQueue(MMEventCallback):
+    def __init__(
+        self,
+        max_size: int = 10000,
+        coalesce: bool = True,
+        types: Sequence[str] | None = None,
+        devices: Sequence[str] | None = None,
+    ) -> None:
+        """
+        Event callback that queues events without taking the GIL.  Register it with CMMCore.registerCallback and drain it from Python with drain() or dispatch().  max_size=0 means unbounded; types and devices optionally restrict the queued events to the given callback names (e.g. 'onStagePositionChanged') and device labels.
+        """
+    def drain(self, max_events: int = 0, timeout_ms: float = 0.0) -> list:
+        """
+        Remove up to max_events queued events (0 = all) and return them as a list of (name, args) tuples, waiting up to timeout_ms (negative = forever) for the first event with the GIL released
+        """
+    def dispatch(
+        self, target: object, max_events: int = 0, timeout_ms: float = 0.0
+    ) -> int:
+        """
+        Drain the queue like drain() and call the method of the same name on target (e.g. an MMEventCallback subclass) for each event.  Returns the number of events dispatched.
+        """
+    @property
+    def depth(self) -> int:
+        """Number of events currently queued"""
+    @property
+    def dropped(self) -> int:
+        """Number of events dropped because the queue was full"""
+    @property
+    def coalesced(self) -> int:
+        """Number of events merged into an already-queued event"""
+
 class FocusDirection(enum.IntEnum):
     FocusDirectionUnknown = 0
     FocusDirectionTowardSample = 1
     FocusDirectionAwayFromSample = 2
 
+class FrameGrouper:
+    def __init__(
+        self,
+        core: CMMCore,
+        cameras: Sequence[str] | None = None,
+        timeout_ms: float = 1000.0,
+        policy: str = "drop",
+        max_pending: int = 64,
+    ) -> None:
+        """
+        Pops frames of several cameras from the circular buffer of core and groups them into one set per image number.  A frame's camera is the position of its Camera tag in cameras, else its CameraChannelIndex tag, else (without cameras) the order in which camera labels first appear; without cameras, getNumberOfCameraChannels() cameras are expected.  A set that cannot complete (its missing cameras moved on to later images, the sequence ended, or timeout_ms passed since its first frame; negative = no timeout) is dropped, or with policy='partial' returned with zeros for the missing frames.  At most max_pending sets are held; a frame that starts another set evicts (drops) the oldest one, complete or not.
+        """
+    def pop(self, wait_ms: float = 0.0) -> tuple[ArrayLike, dict] | None:
+        """
+        Return the next set in image number order as (images, metadata): a (ncams, height, width[, components]) array and a dict of metadata columns with one entry per camera (like popNextImages; missing frames have ImageNumber -1).  Returns None if no set is ready within wait_ms (negative = until the sequence ends).
+        """
+    def reset(self) -> None:
+        """
+        Drop all pending frames (counting them as unmatched), e.g. between sequences
+        """
+    def stats(self) -> dict:
+        """
+        Return counters: frames popped, complete sets, partial_sets, dropped_sets, evicted_sets (dropped to stay within max_pending), unmatched_frames (frames in partial or dropped sets, or whose image format differs from the rest of their set), unassigned_frames (no camera or image number) and pending_sets.
+        """
+    @property
+    def n_cameras(self) -> int:
+        """Number of cameras in a set"""
+
+class LivePreview:
+    def __init__(
+        self,
+        core: CMMCore,
+        max_rate_hz: float = 30.0,
+        max_width: int = 1024,
+        max_height: int = 1024,
+        binning: bool = True,
+        low_percentile: float = 0.1,
+        high_percentile: float = 99.9,
+    ) -> None:
+        """
+        Renders the newest frame in core's circular buffer into an 8-bit display image on a background thread, at most max_rate_hz times per second.  Frames are binned (averaged, or decimated if binning is False) by the smallest integer factor that fits them into max_width x max_height, and the low_percentile to high_percentile range is mapped onto 0-255.  RGB frames render as (h, w, 3) RGB.  Frames are never popped, and frames that arrive faster than the rate are skipped.
+        """
+    def start(self) -> None:
+        """Start rendering frames as they arrive"""
+    def stop(self) -> None:
+        """Stop rendering.  Raises RuntimeError if rendering failed."""
+    def read(self, out: object | None = None) -> object:
+        """
+        Return a copy of the latest display image (uint8), or None if no frame has been rendered yet.  If out is given, the image is copied into it (its shape must match, see stats()['shape']) and out is returned.
+        """
+    def stats(self) -> dict:
+        """
+        Return a dict describing the latest display image: image_number, shape, bin_factor, min and max of the binned frame, display_min and display_max (the range mapped onto 0-255), histogram (a uint64 array of 256 bins over [min, max]) and render_ms, plus the frames_rendered and frames_skipped counts.
+        """
+    def set_percentiles(self, low: float, high: float) -> None:
+        """Set the percentiles of the autoscaled display range"""
+    @property
+    def running(self) -> bool:
+        """Whether the render thread is running"""
+    @property
+    def error(self) -> str:
+        """Error message if rendering failed, otherwise an empty string"""
+
 class MMEventCallback:
     def __init__(self) -> None: ...
     def onPropertiesChanged(self) -> None:
@@ -678,6 +936,15 @@ class Metadata:
         """Adds a MetadataSingleTag"""
     def PutImageTag(self, key: str, value: str) -> None:
         """Adds an image tag"""
+    def to_dict(self) -> dict:
+        """
+        Returns all tags as a dict in one call.  Single tags map to their string value, array tags to a list of strings.
+        """
+    @staticmethod
+    def to_columns(metadata: Sequence[Metadata]) -> dict:
+        """
+        Converts a sequence of Metadata objects to a dict of columns, one per tag.  Integer tags become int64 arrays, other numeric tags float64 arrays (NaN where missing); all other tags are lists with None where missing.
+        """
 
 class MetadataArrayTag(MetadataTag):
     @overload
@@ -761,6 +1028,37 @@ class PortType(enum.IntEnum):
     USBPort = 2
     HIDPort = 3
 
+class PropertyHandle:
+    def __init__(self, core: CMMCore, label: str, property: str) -> None:
+        """
+        A handle to one device property of core, for polling and setting it in tight loops.  The property type is looked up once, and values are returned as int, float or str according to it.  The handle becomes invalid when the device is unloaded.
+        """
+    def get(self) -> int | float | str:
+        """
+        Return the current value, as an int for Integer properties, a float for Float properties and a str otherwise
+        """
+    def get_cached(self) -> int | float | str:
+        """Return the value from the system state cache, converted like get"""
+    def set(self, value: object) -> None:
+        """
+        Set the value: an int for Integer properties, a number for Float properties, and anything convertible with str otherwise
+        """
+    @property
+    def label(self) -> str:
+        """Device label"""
+    @property
+    def property_name(self) -> str:
+        """Property name"""
+    @property
+    def type(self) -> PropertyType:
+        """Property type"""
+    @property
+    def read_only(self) -> bool:
+        """Whether the property is read-only"""
+    @property
+    def valid(self) -> bool:
+        """False once the device has been unloaded (the handle then raises on use)"""
+
 class PropertySetting:
     @overload
     def __init__(
@@ -794,6 +1092,187 @@ class PropertyType(enum.IntEnum):
     Float = 2
     Integer = 3
 
+SYNTHETIC_ADAPTER: str = "PymmcoreNanoSynthetic"
+SYNTHETIC_CAMERA: str = "SyntheticCamera"
+
+class SequenceIterator:
+    def __iter__(self) -> object: ...
+    def __next__(self) -> object: ...
+    @property
+    def overflowed(self) -> bool:
+        """Whether the iteration ended because the circular buffer overflowed"""
+
+class SequencePlan:
+    def __init__(self, core: CMMCore) -> None:
+        """
+        A hardware-triggered acquisition plan for core: one sequence per stage, XY stage, camera exposure or property, each with one value per event.  The plan is validated against the devices as a whole, loaded in parallel across devices and started and stopped in order, all without the GIL.
+        """
+    def add_stage(
+        self,
+        label: str,
+        positions: Annotated[
+            ArrayLike,
+            dict(
+                dtype="float64", shape=(None,), order="C", device="cpu", writable=False
+            ),
+        ],
+    ) -> None:
+        """Add a sequence of focus stage positions (um)"""
+    def add_xy_stage(
+        self,
+        label: str,
+        x: Annotated[
+            ArrayLike,
+            dict(
+                dtype="float64", shape=(None,), order="C", device="cpu", writable=False
+            ),
+        ],
+        y: Annotated[
+            ArrayLike,
+            dict(
+                dtype="float64", shape=(None,), order="C", device="cpu", writable=False
+            ),
+        ],
+    ) -> None:
+        """Add a sequence of XY stage positions (um)"""
+    def add_exposure(
+        self,
+        camera: str,
+        exposures_ms: Annotated[
+            ArrayLike,
+            dict(
+                dtype="float64", shape=(None,), order="C", device="cpu", writable=False
+            ),
+        ],
+    ) -> None:
+        """Add a sequence of camera exposures (ms)"""
+    def add_property(self, label: str, property: str, values: Iterable) -> None:
+        """
+        Add a sequence of property values (any iterable; values are converted with str)
+        """
+    def validate(self) -> None:
+        """
+        Check all sequences against their devices: equal lengths, sequenceable devices and device maximum lengths.  Raises ValueError listing every problem.
+        """
+    def load(self) -> None:
+        """Validate the plan and load all sequences, in parallel across devices"""
+    def start(self, camera: bool = False) -> None:
+        """
+        Start all sequences in the order they were added (loading them first if needed), then, if camera is True, a sequence acquisition of n_events images on the current camera.  If anything fails to start, whatever was started is stopped again.
+        """
+    def stop(self) -> None:
+        """
+        Stop the camera (if started by the plan), then all sequences in reverse order
+        """
+    @property
+    def n_events(self) -> int:
+        """Number of events in the plan"""
+    @property
+    def axes(self) -> list[str]:
+        """Names of the sequences in the plan, in the order they were added"""
+    @property
+    def loaded(self) -> bool:
+        """Whether all sequences are loaded"""
+    @property
+    def running(self) -> bool:
+        """Whether the plan has been started"""
+    @property
+    def timings(self) -> dict:
+        """Duration in ms of the last validate, load, start and stop"""
+
+class SharedFrameReader:
+    def __init__(self, name: str) -> None:
+        """Attach read-only to the shared-memory frame ring published under name"""
+    @property
+    def write_count(self) -> int:
+        """
+        Number of frames published so far; frame n is in the ring while n >= write_count - slot_count
+        """
+    @property
+    def slot_count(self) -> int:
+        """Number of slots in the ring"""
+    @property
+    def shape(self) -> list[int]:
+        """Shape of each frame"""
+    @property
+    def dtype(self) -> str:
+        """NumPy dtype string of the frames"""
+    def view(self, n: int) -> Annotated[ArrayLike, dict(writable=False)]:
+        """
+        Zero-copy, read-only view of frame n.  The publisher may overwrite the slot at any time: check is_valid(n) after using the data.  Raises IndexError if frame n is not in the ring.
+        """
+    def is_valid(self, n: int) -> bool:
+        """Whether frame n is still intact in its slot (seqlock check)"""
+    def read(self, n: int) -> tuple[ArrayLike, int, float]:
+        """
+        Copy frame n out of the ring, validated against concurrent overwrites.  Returns a tuple of (image, image_number, elapsed_ms).  Raises IndexError if frame n is not (or no longer) in the ring.
+        """
+
+class SharedFrameRing:
+    def __init__(self, core: CMMCore, name: str, slots: int = 64) -> None:
+        """
+        Publishes the frames of core's circular buffer into a named POSIX shared-memory ring (e.g. name='/pmn-ring') that other processes can map read-only with SharedFrameReader.  Frames are popped on a background thread without the GIL, so the ring consumes the circular buffer: do not pop frames in this process (e.g. with popNextImage, iterSequence or a StreamWriter) while it runs.  Not supported on Windows.
+        """
+    def start(self) -> None:
+        """
+        Create the shared-memory segment for the current camera format and start publishing frames as they arrive in the circular buffer
+        """
+    def stop(self) -> None:
+        """
+        Stop publishing and unlink the segment name (attached readers keep their mapping).  Raises RuntimeError if publishing failed.
+        """
+    @property
+    def name(self) -> str:
+        """Name of the shared-memory segment"""
+    @property
+    def running(self) -> bool:
+        """Whether the publisher thread is running"""
+    @property
+    def frames_published(self) -> int:
+        """Number of frames published so far (still valid after stop)"""
+    @property
+    def error(self) -> str:
+        """Error message if publishing failed, otherwise an empty string"""
+
+class StreamWriter:
+    def __init__(
+        self,
+        core: CMMCore,
+        path: object,
+        chunk_bytes: int = 16777216,
+        metadata: bool = True,
+    ) -> None:
+        """
+        Writer that drains the circular buffer of core to a raw stream file on a background thread, without the GIL.  path receives a 4096-byte header followed by the frames (memory-mappable with NumPy); path + '.idx' receives a per-frame index of (image_number <i8, elapsed_ms <f8) records, and path + '.jsonl' (if metadata is True) all metadata tags, one JSON object per frame.  Frames are written in chunks of about chunk_bytes.
+        """
+    def start(self) -> None:
+        """
+        Open the output files and start writing frames as they arrive in the circular buffer.  The writer finishes on its own once it has written at least one frame and the sequence has stopped and the buffer has been drained.
+        """
+    def stop(self) -> None:
+        """
+        Write the frames remaining in the circular buffer, finalize the files and stop the writer.  Raises RuntimeError if writing failed.
+        """
+    def flush(self) -> None:
+        """
+        Block until all frames popped so far are on disk and the header is up to date
+        """
+    @property
+    def running(self) -> bool:
+        """Whether the writer thread is running"""
+    @property
+    def frames_written(self) -> int:
+        """Number of frames written so far"""
+    @property
+    def bytes_written(self) -> int:
+        """Number of image bytes written so far"""
+    @property
+    def throughput_mb_s(self) -> float:
+        """Average write throughput since start(), in MB/s"""
+    @property
+    def error(self) -> str:
+        """Error message if the writer failed, otherwise an empty string"""
+
 g_CFGCommand_ConfigGroup: str = "ConfigGroup"
 g_CFGCommand_ConfigPixelSize: str = "ConfigPixelSize"
 g_CFGCommand_Configuration: str = "Config"
@@ -1 +1,2 @@
 from _pymmcore_nano import *  # noqa
+from _pymmcore_nano import _benchmarks  # noqa: F401 (the star import skips private names)
@@ -30,3 +30,11 @@ def demo_core(core: pmn.CMMCore, demo_config: Path) -> pmn.CMMCore:
     """Return a CMMCore instance with the demo configuration loaded."""
     core.loadSystemConfiguration(demo_config)
     return core
+
+
+@pytest.fixture
+def synthetic_core() -> pmn.CMMCore:
+    """Return a CMMCore instance with the built-in synthetic camera as "Camera"."""
+    mmc = pmn.CMMCore()
+    mmc.loadSyntheticCamera("Camera")
+    return mmc
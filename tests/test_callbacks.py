@@ -1,4 +1,7 @@
+import gc
+import weakref
 from unittest.mock import Mock, call
+import pytest
 import pymmcore_nano as pmn
 from pathlib import Path
 
@@ -86,3 +89,69 @@ def test_callback(core: pmn.CMMCore, demo_config: Path):
 
     core.setXYPosition(1, 2)
     mock.assert_called_with("onXYStagePositionChanged")
+
+
+def test_event_queue(core: pmn.CMMCore, demo_config: Path):
+    q = pmn.EventQueue()
+    core.registerCallback(q)
+    core.loadSystemConfiguration(demo_config)
+    assert ("onSystemConfigurationLoaded", ()) in q.drain()
+    assert q.depth == 0
+
+    for z in range(100):
+        core.setPosition(z)
+    core.setXYPosition(1, 2)
+    events = q.drain()
+    # repeated stage positions are coalesced into a single (latest) event
+    z_events = [args for name, args in events if name == "onStagePositionChanged"]
+    assert z_events == [("Z", 99.0)]
+    assert ("onXYStagePositionChanged", ("XY", 1.0, 2.0)) in events
+    assert q.coalesced >= 99
+
+    # events can be dispatched to a regular callback object
+    mock = Mock()
+
+    class MyCallback(pmn.MMEventCallback):
+        def onExposureChanged(self, name: str, exposure: float) -> None:
+            mock(name, exposure)
+
+    core.setExposure(12)
+    assert q.dispatch(MyCallback(), timeout_ms=1000) >= 1
+    mock.assert_called_with("Camera", 12.0)
+
+
+def test_event_queue_kept_alive(core: pmn.CMMCore, demo_config: Path):
+    q = pmn.EventQueue()
+    ref = weakref.ref(q)
+    core.registerCallback(q)
+    del q
+    gc.collect()
+    # the core holds a reference to its callback, so events still have somewhere to go
+    assert ref() is not None
+    core.loadSystemConfiguration(demo_config)
+    assert ("onSystemConfigurationLoaded", ()) in ref().drain()
+
+
+def test_event_queue_filters():
+    q = pmn.EventQueue(max_size=2, coalesce=False, types=["onStagePositionChanged"])
+    q.onStagePositionChanged("Z", 1)
+    q.onStagePositionChanged("Z", 2)
+    q.onStagePositionChanged("Z", 3)
+    q.onExposureChanged("Camera", 10)  # filtered out
+    assert q.depth == 2
+    assert q.dropped == 1
+    assert q.drain(max_events=1) == [("onStagePositionChanged", ("Z", 1.0))]
+    assert q.drain() == [("onStagePositionChanged", ("Z", 2.0))]
+    assert q.drain(timeout_ms=10) == []
+
+    q = pmn.EventQueue(devices=["Z"])
+    q.onStagePositionChanged("Z", 1)
+    q.onStagePositionChanged("Other", 1)
+    q.onPropertiesChanged()  # not associated with a device
+    assert [name for name, _ in q.drain()] == [
+        "onStagePositionChanged",
+        "onPropertiesChanged",
+    ]
+
+    with pytest.raises(ValueError, match="Unknown event type"):
+        pmn.EventQueue(types=["notAnEvent"])
@@ -1,5 +1,11 @@
 import enum
+import gc
+import json
+import os
+import select
+import sys
 from pathlib import Path
+import threading
 import time
 from typing import Callable
 import numpy as np
@@ -99,6 +105,57 @@ def test_device_loading(core: pmn.CMMCore) -> None:
         assert core.getDeviceInitializationState(LABEL)
 
 
+def test_initialize_all_devices_ordered(core: pmn.CMMCore) -> None:
+    # peripherals loaded before their hub are still initialized after it
+    core.loadDevice("Camera", "DemoCamera", "DCam")
+    core.loadDevice("Z", "DemoCamera", "DStage")
+    core.loadDevice("DHub", "DemoCamera", "DHub")
+    core.setParentLabel("Camera", "DHub")
+    core.setParentLabel("Z", "DHub")
+
+    # the core's parallel mode is process-wide, so it is only used when enabled by the caller
+    result = core.initializeAllDevicesOrdered()
+    assert result["total_ms"] >= 0
+    assert not result["parallel"]
+    devices = result["devices"]
+    assert list(devices)[0] == "DHub"
+    assert set(devices) == {"Camera", "Z", "DHub"}
+    success = pmn.DeviceInitializationState.InitializedSuccessfully
+    for label, info in devices.items():
+        assert info["state"] == success
+        assert info["error"] is None
+        assert info["ms"] >= 0
+        assert core.getDeviceInitializationState(label) == success
+
+    # initialized devices are left alone
+    core.loadDevice("Shutter", "DemoCamera", "DShutter")
+    result = core.initializeAllDevicesOrdered()
+    assert not result["parallel"]
+    assert result["devices"]["Camera"]["ms"] == 0
+    assert result["devices"]["Shutter"]["state"] == success
+    assert core.getDeviceInitializationState("Shutter") == success
+
+
+def test_initialize_all_devices_ordered_parallel_feature(core: pmn.CMMCore) -> None:
+    try:
+        enabled = pmn.CMMCore.isFeatureEnabled("ParallelDeviceInitialization")
+    except RuntimeError:
+        pytest.skip("This MMCore has no parallel device initialization")
+    core.loadDevice("DHub", "DemoCamera", "DHub")
+    core.loadDevice("Camera", "DemoCamera", "DCam")
+    core.setParentLabel("Camera", "DHub")
+    pmn.CMMCore.enableFeature("ParallelDeviceInitialization", True)
+    try:
+        result = core.initializeAllDevicesOrdered()
+    finally:
+        pmn.CMMCore.enableFeature("ParallelDeviceInitialization", enabled)
+    assert result["parallel"]
+    success = pmn.DeviceInitializationState.InitializedSuccessfully
+    for info in result["devices"].values():
+        assert info["state"] == success
+        assert info["ms"] is None
+
+
 #    void reset() noexcept(false);
 
 #    void unloadLibrary(const char* moduleName) noexcept(false);
@@ -229,6 +286,38 @@ def test_camera_snap(demo_core: pmn.CMMCore) -> None:
     assert img5.shape == (256, 128, 4)  # new shape
 
 
+def test_snap_releases_gil(demo_core: pmn.CMMCore) -> None:
+    """Other Python threads should keep running while snapImage blocks."""
+    demo_core.setExposure(500)
+    ticks = [0, 0]
+    stop = threading.Event()
+
+    def _count(idx: int) -> None:
+        while not stop.is_set():
+            ticks[idx] += 1
+            time.sleep(0.001)
+
+    threads = [threading.Thread(target=_count, args=(i,)) for i in range(2)]
+    for t in threads:
+        t.start()
+    try:
+        time.sleep(0.05)  # let the workers get going
+        before = list(ticks)
+        start = time.perf_counter()
+        demo_core.snapImage()
+        elapsed = time.perf_counter() - start
+        after = list(ticks)
+    finally:
+        stop.set()
+        for t in threads:
+            t.join()
+
+    assert elapsed >= 0.4
+    # both workers should have ticked many times while the exposure was running
+    assert after[0] - before[0] > 20
+    assert after[1] - before[1] > 20
+
+
 def test_image_processor(demo_core: pmn.CMMCore) -> None:
     assert demo_core.getCameraDevice() == "Camera"
     demo_core.loadDevice("MedianFilter", "DemoCamera", "MedianFilter")
@@ -276,6 +365,10 @@ def test_get_image_metadata(demo_core: pmn.CMMCore) -> None:
     img3 = demo_core.getLastImageMD(md3)
     assert img3.shape == expected_shape
     assert img3.dtype == np.uint8
+    # the (cached) format follows the tags of the frame, not the current camera settings
+    demo_core.setProperty("Camera", "PixelType", "16bit")
+    assert demo_core.getLastImageMD(md3).dtype == np.uint8
+    assert demo_core.getLastImage().dtype == np.uint16
 
     with pytest.raises(KeyError, match="Undefined metadata key"):
         md.GetSingleTag("NumberOfComponents")
@@ -341,6 +434,371 @@ def test_image_sequence(demo_core: pmn.CMMCore) -> None:
     demo_core.clearCircularBuffer()
 
 
+def test_pop_next_images(demo_core: pmn.CMMCore) -> None:
+    demo_core.setProperty("Camera", "OnCameraCCDXSize", 256)
+    expected_shape = (demo_core.getImageHeight(), demo_core.getImageWidth())
+    demo_core.startSequenceAcquisition(10, 0, False)
+    _wait_until(lambda: not demo_core.isSequenceRunning())
+    assert demo_core.getRemainingImageCount() == 10
+
+    imgs, cols = demo_core.popNextImages(4)
+    assert isinstance(imgs, np.ndarray)
+    assert imgs.flags.writeable
+    assert imgs.shape == (4, *expected_shape)
+    assert imgs.dtype == np.uint16
+    assert cols["ImageNumber"].dtype == np.int64
+    assert list(np.diff(cols["ImageNumber"])) == [1, 1, 1]
+    last_number = cols["ImageNumber"][-1]
+    assert len(cols["ElapsedTime-ms"]) == 4
+    assert np.all(np.diff(cols["ElapsedTime-ms"]) >= 0)
+    assert cols["Camera"] == ["Camera"] * 4
+    assert demo_core.getRemainingImageCount() == 6
+
+    # asking for more than is available returns what is left
+    imgs, cols = demo_core.popNextImages(100)
+    assert imgs.shape == (6, *expected_shape)
+    assert list(cols["ImageNumber"]) == list(range(last_number + 1, last_number + 7))
+
+    imgs, cols = demo_core.popNextImages(5)
+    assert imgs.shape == (0, *expected_shape)
+    assert len(cols["ImageNumber"]) == 0
+
+
+def test_image_copy_pool(demo_core: pmn.CMMCore) -> None:
+    assert not demo_core.isImageCopyPoolEnabled()
+    demo_core.startSequenceAcquisition(10, 0, False)
+    _wait_until(lambda: not demo_core.isSequenceRunning())
+
+    demo_core.setImageCopyPool(True, maxPooledImages=2)
+    assert demo_core.isImageCopyPoolEnabled()
+    img = demo_core.popNextImage()
+    assert not img.flags.writeable
+    assert demo_core.getPooledImageCount() == 1
+    img2, md = demo_core.popNextImageMD()
+    assert isinstance(md, pmn.Metadata)
+    assert demo_core.getPooledImageCount() == 2
+    # pooled images are private copies
+    assert not np.shares_memory(img, img2)
+
+    with pytest.raises(pmn.CMMError, match="copy pool exhausted"):
+        demo_core.getLastImage()
+    # a full pool must not consume a frame
+    remaining = demo_core.getRemainingImageCount()
+    with pytest.raises(pmn.CMMError, match="copy pool exhausted"):
+        demo_core.popNextImage()
+    with pytest.raises(pmn.CMMError, match="copy pool exhausted"):
+        demo_core.popNextImageMD()
+    assert demo_core.getRemainingImageCount() == remaining
+
+    del img
+    gc.collect()
+    assert demo_core.getPooledImageCount() == 1
+    img3 = demo_core.popNextImage()
+    assert img3.shape == img2.shape
+    assert demo_core.getPooledImageCount() == 2
+
+    del img2, img3
+    gc.collect()
+    assert demo_core.getPooledImageCount() == 0
+
+    demo_core.setImageCopyPool(False)
+    assert not demo_core.isImageCopyPoolEnabled()
+    demo_core.popNextImage()
+    assert demo_core.getPooledImageCount() == 0
+
+
+def test_pop_into(demo_core: pmn.CMMCore) -> None:
+    shape = (demo_core.getImageHeight(), demo_core.getImageWidth())
+    demo_core.startSequenceAcquisition(10, 0, False)
+    _wait_until(lambda: not demo_core.isSequenceRunning())
+
+    # strided (non-contiguous) destination
+    out = np.zeros((shape[0], shape[1] * 2), dtype=np.uint16)[:, ::2]
+    assert demo_core.getLastImage(out=out) is None
+    np.testing.assert_array_equal(out, demo_core.getLastImage())
+
+    stack = np.zeros((8, *shape), dtype=np.uint16)
+    demo_core.popNextImage(out=stack[0])
+    md = demo_core.popNextImageMD(out=stack[1])
+    assert isinstance(md, pmn.Metadata)
+    assert md.GetSingleTag("PixelType").GetValue() == "GRAY16"
+    assert stack[:2].any()
+    assert demo_core.getRemainingImageCount() == 8
+
+    # batched variant fills consecutive slices
+    n, cols = demo_core.popNextImages(out=stack[2:])
+    assert n == 6
+    assert len(cols["ImageNumber"]) == 6
+    assert stack[2:].any()
+    n, cols = demo_core.popNextImages(out=stack)
+    assert n == 0
+
+    # invalid destinations are rejected before a frame is consumed
+    demo_core.snapImage()
+    with pytest.raises(TypeError, match="dtype"):
+        demo_core.getImage(out=np.zeros(shape, dtype=np.uint8))
+    with pytest.raises(ValueError, match="shape"):
+        demo_core.getImage(out=np.zeros((10, 10), dtype=np.uint16))
+    with pytest.raises(TypeError):
+        demo_core.getImage(out=demo_core.getImage())  # read-only
+
+
+def test_pop_into_format_change(demo_core: pmn.CMMCore) -> None:
+    shape = (demo_core.getImageHeight(), demo_core.getImageWidth())
+    demo_core.startSequenceAcquisition(4, 0, False)
+    _wait_until(lambda: not demo_core.isSequenceRunning())
+
+    # the buffered 16-bit frames no longer match the camera (and out): nothing is popped
+    demo_core.setProperty("Camera", "PixelType", "8bit")
+    with pytest.raises(RuntimeError, match="does not match"):
+        demo_core.popNextImage(out=np.zeros(shape, dtype=np.uint8))
+    with pytest.raises(RuntimeError, match="does not match"):
+        demo_core.popNextImages(out=np.zeros((4, *shape), dtype=np.uint8))
+    assert demo_core.getRemainingImageCount() == 4
+
+    # the frames can still be popped in their own format
+    imgs, cols = demo_core.popNextImages(8)
+    assert imgs.shape == (4, *shape)
+    assert imgs.dtype == np.uint16
+
+
+def test_metadata_to_dict() -> None:
+    md = pmn.Metadata()
+    md.PutImageTag("Count", "3")
+    md.PutImageTag("Exposure", "10.5")
+    md.PutImageTag("Label", "abc")
+    tag = pmn.MetadataArrayTag("Values", "Dev", False)
+    tag.AddValue("1")
+    tag.AddValue("2")
+    md.SetTag(tag)
+
+    d = md.to_dict()
+    assert sorted(d) == sorted(md.GetKeys())
+    assert d["Count"] == "3"
+    assert d["Label"] == "abc"
+    assert d[tag.GetQualifiedName()] == ["1", "2"]
+
+    md2 = pmn.Metadata()
+    md2.PutImageTag("Count", "4")
+    md2.PutImageTag("Exposure", "11")
+    md2.PutImageTag("Other", "1e3")
+    cols = pmn.Metadata.to_columns([md, md2])
+    assert cols["Count"].dtype == np.int64
+    np.testing.assert_array_equal(cols["Count"], [3, 4])
+    np.testing.assert_array_equal(cols["Exposure"], [10.5, 11.0])
+    assert cols["Other"].dtype == np.float64
+    assert np.isnan(cols["Other"][0]) and cols["Other"][1] == 1000
+    assert cols["Label"] == ["abc", None]
+    assert cols[tag.GetQualifiedName()] == [["1", "2"], None]
+    assert pmn.Metadata.to_columns([]) == {}
+
+    # only plain decimal numbers are converted
+    for value in ("0x1A", "nan", "inf", " 5", "1e", "."):
+        md3 = pmn.Metadata()
+        md3.PutImageTag("Value", value)
+        assert pmn.Metadata.to_columns([md3])["Value"] == [value]
+
+
+def test_iter_sequence(demo_core: pmn.CMMCore) -> None:
+    # no sequence running: iteration ends immediately
+    assert list(demo_core.iterSequence(timeout_ms=100)) == []
+
+    demo_core.startSequenceAcquisition(10, 0, False)
+    frames = list(demo_core.iterSequence(timeout_ms=1000))
+    assert len(frames) == 10
+    assert all(f.shape == frames[0].shape for f in frames)
+
+    demo_core.startSequenceAcquisition(10, 0, False)
+    it = demo_core.iterSequence(timeout_ms=1000, batch=4)
+    batches = list(it)
+    assert [len(b) for b, _ in batches] == [4, 4, 2]
+    numbers = np.concatenate([cols["ImageNumber"] for _, cols in batches])
+    assert np.all(np.diff(numbers) == 1)
+    assert not it.overflowed
+
+    with pytest.raises(ValueError):
+        demo_core.iterSequence(batch=0)
+
+    demo_core.setExposure(500)
+    demo_core.startContinuousSequenceAcquisition(0)
+    try:
+        with pytest.raises(TimeoutError):
+            next(demo_core.iterSequence(timeout_ms=20))
+    finally:
+        demo_core.stopSequenceAcquisition()
+
+
+@pytest.mark.skipif(sys.platform == "win32", reason="no frame-ready fd on Windows")
+def test_frame_ready_fd(demo_core: pmn.CMMCore) -> None:
+    fd = demo_core.openFrameReadyFd(minIntervalMs=0)
+    assert demo_core.openFrameReadyFd() == fd
+    try:
+        assert select.select([fd], [], [], 0.1)[0] == []
+
+        demo_core.startSequenceAcquisition(5, 0, False)
+        assert select.select([fd], [], [], 1.0)[0] == [fd]
+        os.read(fd, 8)
+        # drain until the sequence has ended; the end of the sequence is signaled too
+        count = 0
+        while select.select([fd], [], [], 1.0)[0]:
+            os.read(fd, 8)
+            while demo_core.getRemainingImageCount():
+                demo_core.popNextImage()
+                count += 1
+            if count == 5 and not demo_core.isSequenceRunning():
+                break
+        assert count == 5
+    finally:
+        demo_core.closeFrameReadyFd()
+
+
+def test_stream_writer(demo_core: pmn.CMMCore, tmp_path: Path) -> None:
+    path = tmp_path / "run.raw"
+    writer = pmn.StreamWriter(demo_core, path, chunk_bytes=1 << 20)
+    writer.start()
+    with pytest.raises(RuntimeError):
+        writer.start()
+    demo_core.startSequenceAcquisition(20, 0, False)
+    # finishes on its own once the sequence has ended and the buffer is drained
+    _wait_until(lambda: not writer.running, timeout=5)
+    writer.stop()
+    assert writer.error == ""
+    assert writer.frames_written == 20
+    assert demo_core.getRemainingImageCount() == 0
+
+    shape = (demo_core.getImageHeight(), demo_core.getImageWidth())
+    assert writer.bytes_written == 20 * shape[0] * shape[1] * 2
+    assert writer.throughput_mb_s > 0
+
+    header = path.read_bytes()[:4096]
+    assert header[:8] == b"PMNSTRM\0"
+    assert header[16:19] == b"<u2"
+    ndim = int.from_bytes(header[24:28], "little")
+    *dims, frame_bytes, count = np.frombuffer(header, "<u8", count=5, offset=32)
+    assert (ndim, tuple(dims[:ndim]), count) == (2, shape, 20)
+    assert frame_bytes == shape[0] * shape[1] * 2
+
+    frames = np.memmap(path, "<u2", "r", offset=4096, shape=(20, *shape))
+    assert frames[-1].any()
+    index = np.fromfile(f"{path}.idx", [("image_number", "<i8"), ("elapsed_ms", "<f8")])
+    assert len(index) == 20
+    assert np.all(np.diff(index["image_number"]) == 1)
+    lines = Path(f"{path}.jsonl").read_text().splitlines()
+    assert len(lines) == 20
+    assert json.loads(lines[0])["Camera"] == "Camera"
+
+
+@pytest.mark.skipif(sys.platform == "win32", reason="no POSIX shared memory")
+def test_shared_frame_ring(demo_core: pmn.CMMCore) -> None:
+    name = f"/pmn-test-{os.getpid()}"
+    ring = pmn.SharedFrameRing(demo_core, name, slots=4)
+    ring.start()
+    try:
+        reader = pmn.SharedFrameReader(name)
+        shape = [demo_core.getImageHeight(), demo_core.getImageWidth()]
+        assert reader.shape == shape
+        assert reader.dtype == "<u2"
+        assert reader.slot_count == 4
+
+        demo_core.startSequenceAcquisition(10, 0, False)
+        _wait_until(lambda: ring.frames_published == 10, timeout=5)
+        assert reader.write_count == 10
+
+        img, image_number, _ = reader.read(9)
+        assert img.shape == tuple(shape)
+        view = reader.view(9)
+        np.testing.assert_array_equal(view, img)
+        assert reader.is_valid(9)
+        assert not view.flags.writeable
+        # frames older than write_count - slot_count have been overwritten
+        assert not reader.is_valid(5)
+        with pytest.raises(IndexError):
+            reader.read(5)
+        with pytest.raises(IndexError):
+            reader.view(10)
+        assert reader.read(8)[1] == image_number - 1
+    finally:
+        ring.stop()
+    with pytest.raises(RuntimeError):
+        pmn.SharedFrameReader(name)  # unlinked
+    # the count survives the segment
+    assert ring.frames_published == 10
+    assert not ring.running
+
+
+def test_binding_stats(demo_core: pmn.CMMCore) -> None:
+    demo_core.resetBindingStats()
+    assert not demo_core.isBindingStatsEnabled()
+    demo_core.snapImage()
+    demo_core.getImage()
+    assert demo_core.getBindingStats().get("getImage", {"calls": 0})["calls"] == 0
+
+    class Callback(pmn.MMEventCallback):
+        def onExposureChanged(self, name: str, exposure: float) -> None:
+            pass
+
+    cb = Callback()
+    demo_core.registerCallback(cb)
+    demo_core.enableBindingStats(True)
+    try:
+        for _ in range(3):
+            demo_core.snapImage()
+            demo_core.getImage()
+        demo_core.startSequenceAcquisition(5, 0, True)
+        _wait_until(lambda: not demo_core.isSequenceRunning(), timeout=5)
+        while demo_core.getRemainingImageCount():
+            demo_core.popNextImageMD()
+        demo_core.setExposure(12)
+    finally:
+        demo_core.enableBindingStats(False)
+
+    stats = demo_core.getBindingStats()
+    img = stats["getImage"]
+    assert img["calls"] == 3
+    assert img["bytes"] == 3 * demo_core.getImageBufferSize()
+    assert img["histogram"].dtype == np.uint64
+    assert img["histogram"].sum() == 3
+    assert 0 < img["mean_ns"] <= img["max_ns"]
+    assert stats["snapImage"]["calls"] == 3
+    assert stats["popNextImageMD"]["calls"] == 5
+    assert stats["MMEventCallback.onExposureChanged"]["calls"] >= 1
+    assert stats["MMEventCallback.gil_wait"]["calls"] >= 1
+
+    demo_core.resetBindingStats()
+    assert demo_core.getBindingStats()["getImage"]["calls"] == 0
+
+
+def test_buffer_allocation(demo_core: pmn.CMMCore, tmp_path: Path) -> None:
+    size = demo_core.getCircularBufferMemoryFootprint()
+    demo_core.setCircularBufferMemoryFootprint(size)
+    stats = demo_core.getBufferAllocationStats()
+    assert stats["circular_buffer_alloc_ms"] >= 0
+    assert "circular_buffer_fault_ms" not in stats
+    # unchanged size and camera format: the buffer is kept
+    demo_core.setCircularBufferMemoryFootprint(size)
+    after = demo_core.getBufferAllocationStats()
+    assert after["circular_buffer_reused"] == stats["circular_buffer_reused"] + 1
+    demo_core.setCircularBufferMemoryFootprint(size + 1)
+    reused = demo_core.getBufferAllocationStats()["circular_buffer_reused"]
+    assert reused == after["circular_buffer_reused"]
+    # the camera format is read from the core on every call, not from the last allocation
+    demo_core.setProperty("Camera", "Binning", "2")
+    demo_core.setCircularBufferMemoryFootprint(size + 1)
+    assert demo_core.getBufferAllocationStats()["circular_buffer_reused"] == reused
+    demo_core.setCircularBufferMemoryFootprint(size + 1)
+    assert demo_core.getBufferAllocationStats()["circular_buffer_reused"] == reused + 1
+
+    demo_core.setBufferAllocationOptions(prefault=True, hugepages=True)
+    writer = pmn.StreamWriter(demo_core, tmp_path / "run.raw", chunk_bytes=1 << 20)
+    writer.start()
+    writer.stop()
+    stats = demo_core.getBufferAllocationStats()
+    assert stats["buffers"] == 1
+    assert stats["bytes"] >= 1 << 19
+    assert stats["hugepage_buffers"] in (0, 1)
+    assert stats["alloc_ms"] >= 0 and stats["fault_ms"] >= 0
+
+
 def test_image_sequence_errors(demo_core: pmn.CMMCore) -> None:
     md = pmn.Metadata()
     with pytest.raises(pmn.CMMError):
@@ -373,3 +831,410 @@ def test_camera_roi_change(demo_core: pmn.CMMCore) -> None:
     assert demo_core.getROI() == (0, 0, 512, 512)
     assert not demo_core.isMultiROIEnabled()
     assert not demo_core.isMultiROISupported()
+
+
+def test_acquisition_health(demo_core: pmn.CMMCore) -> None:
+    with pytest.raises(RuntimeError):
+        demo_core.getAcquisitionHealth()
+    demo_core.setAcquisitionMonitor(True)
+    try:
+        demo_core.startSequenceAcquisition(10, 0, True)
+        _wait_until(lambda: not demo_core.isSequenceRunning(), timeout=5)
+        _wait_until(lambda: demo_core.getAcquisitionHealth()["inserted"] == 10)
+        for _ in range(4):
+            demo_core.popNextImageMD()
+        demo_core.popNextImages(2)
+        _wait_until(lambda: demo_core.getAcquisitionHealth()["popped"] == 6)
+
+        health = demo_core.getAcquisitionHealth()
+        assert not health["sequence_running"]
+        assert health["remaining"] == health["lag_frames"] == 4
+        assert health["dropped"] == 0
+        assert 0 < health["max_occupancy"] <= 10
+        assert health["capacity"] == demo_core.getBufferTotalCapacity()
+        assert not health["overflowed"]
+        assert health["overflow_s"] is None
+        assert health["interval_count"] <= 9
+        if health["interval_count"]:
+            assert health["window_interval_min_ms"] <= health["interval_mean_ms"]
+            assert health["interval_mean_ms"] <= health["window_interval_max_ms"]
+            assert health["window_interval_std_ms"] >= 0
+        assert "interval_std_ms" not in health
+
+        # a new sequence restarts the counts, even if it ends between two samples
+        demo_core.startSequenceAcquisition(20, 0, True)
+        _wait_until(lambda: not demo_core.isSequenceRunning(), timeout=5)
+        _wait_until(lambda: demo_core.getAcquisitionHealth()["inserted"] == 20)
+        health = demo_core.getAcquisitionHealth()
+        assert health["popped"] == 0
+        assert health["remaining"] == 20
+    finally:
+        demo_core.setAcquisitionMonitor(False)
+
+
+def test_live_preview(demo_core: pmn.CMMCore) -> None:
+    preview = pmn.LivePreview(demo_core, max_rate_hz=200, max_width=128, max_height=128)
+    assert preview.read() is None
+    preview.start()
+    try:
+        demo_core.startSequenceAcquisition(20, 0, True)
+        _wait_until(lambda: not demo_core.isSequenceRunning(), timeout=5)
+        _wait_until(lambda: preview.stats()["image_number"] == 19)
+    finally:
+        preview.stop()
+    assert not preview.running
+
+    stats = preview.stats()
+    width, height = demo_core.getImageWidth(), demo_core.getImageHeight()
+    factor = stats["bin_factor"]
+    assert factor == max(-(-width // 128), -(-height // 128))
+    assert stats["shape"] == [height // factor, width // factor]
+    assert stats["histogram"].sum() == (height // factor) * (width // factor)
+    assert stats["min"] <= stats["display_min"] <= stats["display_max"] <= stats["max"]
+    assert 1 <= stats["frames_rendered"] <= 20
+
+    img = preview.read()
+    assert img.dtype == np.uint8
+    assert list(img.shape) == stats["shape"]
+    out = np.zeros_like(img)
+    assert preview.read(out) is out
+    np.testing.assert_array_equal(out, img)
+    with pytest.raises(ValueError):
+        preview.read(np.zeros((1, 1), np.uint8))
+
+    with pytest.raises(ValueError):
+        preview.set_percentiles(50, 10)
+
+
+def test_image_correction(demo_core: pmn.CMMCore) -> None:
+    shape = (demo_core.getImageHeight(), demo_core.getImageWidth())
+    demo_core.startSequenceAcquisition(6, 0, True)
+    _wait_until(lambda: not demo_core.isSequenceRunning(), timeout=5)
+    # read the raw frames without popping them
+    raw = [
+        np.array(demo_core.getNBeforeLastImageMD(n)[0], np.float32)
+        for n in range(5, -1, -1)
+    ]
+
+    dark = np.full(shape, 2, np.float32)
+    flat = dark + 1 + np.arange(shape[0] * shape[1]).reshape(shape) % 3
+    gain = (flat - dark).mean() / (flat - dark)
+    expected = [(r - dark) * gain for r in raw]
+
+    demo_core.setImageCorrection(dark, flat, average=2, threads=2)
+    try:
+        img = demo_core.popNextImage()
+        assert img.dtype == np.float32
+        np.testing.assert_allclose(img, (expected[0] + expected[1]) / 2, rtol=1e-5)
+        frames, md = demo_core.popNextImages(5)
+        assert frames.shape == (2, *shape)
+        np.testing.assert_allclose(
+            frames[1], (expected[4] + expected[5]) / 2, rtol=1e-5
+        )
+
+        stats = demo_core.getImageCorrectionStats()
+        assert stats["frames_in"] == 6
+        assert stats["frames_out"] == 3
+        assert stats["dark"]["calls"] == 6
+        assert stats["flat"]["calls"] == 6
+        assert stats["average"]["total_ms"] >= 0
+
+        with pytest.raises(TypeError):
+            demo_core.popNextImage(np.empty(shape, np.uint16))
+
+        # the rolling window starts over with each sequence
+        demo_core.setImageCorrection(average=3, rolling=True)
+        demo_core.startSequenceAcquisition(2, 0, True)
+        _wait_until(lambda: not demo_core.isSequenceRunning(), timeout=5)
+        demo_core.popNextImages(2)
+        demo_core.startSequenceAcquisition(1, 0, True)
+        _wait_until(lambda: not demo_core.isSequenceRunning(), timeout=5)
+        first = np.array(demo_core.getLastImage(), np.float32)
+        np.testing.assert_array_equal(demo_core.popNextImage(), first)
+
+        # a sequence that ends within a block: iteration stops, leaving the partial block
+        demo_core.setImageCorrection(average=2)
+        for batch in (None, 4):
+            demo_core.startSequenceAcquisition(5, 0, True)
+            _wait_until(lambda: not demo_core.isSequenceRunning(), timeout=5)
+            it = demo_core.iterSequence(timeout_ms=1000, batch=batch)
+            if batch is None:
+                assert len(list(it)) == 2
+            else:
+                assert [len(b) for b, _ in it] == [2]
+            assert demo_core.getRemainingImageCount() == 1
+            demo_core.clearCircularBuffer()
+
+        # a frame that no longer matches the camera format is not consumed
+        demo_core.startSequenceAcquisition(2, 0, True)
+        _wait_until(lambda: not demo_core.isSequenceRunning(), timeout=5)
+        demo_core.setProperty("Camera", "PixelType", "8bit")
+        with pytest.raises(RuntimeError, match="does not match"):
+            demo_core.popNextImage()
+        with pytest.raises(RuntimeError, match="does not match"):
+            demo_core.popNextImages(2)
+        assert demo_core.getRemainingImageCount() == 2
+    finally:
+        demo_core.clearImageCorrection()
+    with pytest.raises(RuntimeError):
+        demo_core.getImageCorrectionStats()
+
+
+def test_sequence_plan(demo_core: pmn.CMMCore) -> None:
+    plan = pmn.SequencePlan(demo_core)
+    with pytest.raises(ValueError, match="empty"):
+        plan.validate()
+    plan.add_stage("Z", np.linspace(0, 10, 5))
+    plan.add_xy_stage("XY", np.zeros(4), np.zeros(4))
+    with pytest.raises(ValueError):
+        plan.add_stage("Z", np.zeros(5))
+    with pytest.raises(ValueError) as exc:
+        plan.validate()
+    # every problem is reported at once
+    assert "XY has 4 events" in str(exc.value)
+    assert plan.axes == ["Z", "XY"]
+    assert not plan.running
+
+    if not demo_core.hasProperty("Z", "UseSequences"):
+        pytest.skip("DStage does not support sequences")
+    demo_core.setProperty("Z", "UseSequences", "Yes")
+    plan = pmn.SequencePlan(demo_core)
+    plan.add_stage("Z", np.linspace(0, 10, 5))
+    assert plan.n_events == 5
+    plan.start()
+    try:
+        assert plan.loaded
+        assert plan.running
+    finally:
+        plan.stop()
+    assert not plan.running
+    assert {"validate_ms", "load_ms", "start_ms", "stop_ms"} <= plan.timings.keys()
+
+
+def test_batched_properties(demo_core: pmn.CMMCore) -> None:
+    errors = demo_core.setProperties(
+        [
+            ("Camera", "Exposure", 25.5),
+            ("Camera", "Binning", 2),
+            ("Emission", "Label", "Chroma-HQ700"),
+            ("Camera", "NotAProperty", "x"),
+            ("Objective", "State", 2),
+        ],
+        waitForSystem=True,
+    )
+    assert errors[:3] == [None, None, None]
+    assert isinstance(errors[3], str)
+    assert errors[4] is None
+
+    results = demo_core.getProperties(
+        [
+            ("Camera", "Exposure"),
+            ("Camera", "Binning"),
+            ("Emission", "Label"),
+            ("NoSuchDevice", "State"),
+            ("Objective", "State"),
+        ]
+    )
+    assert results[0] == (demo_core.getProperty("Camera", "Exposure"), None)
+    assert float(results[0][0]) == 25.5
+    assert results[1] == ("2", None)
+    assert results[2] == ("Chroma-HQ700", None)
+    value, error = results[3]
+    assert value is None and error
+    assert results[4] == ("2", None)
+
+    # Core writes run after the device writes, in the order given
+    errors = demo_core.setProperties(
+        [
+            ("Core", "Shutter", "LED Shutter"),
+            ("Camera", "Exposure", 12),
+            ("Core", "AutoShutter", 0),
+            ("Emission", "State", 1),
+            ("Core", "Shutter", "White Light Shutter"),
+        ]
+    )
+    assert errors == [None] * 5
+    assert demo_core.getShutterDevice() == "White Light Shutter"
+    assert not demo_core.getAutoShutter()
+    assert demo_core.getExposure() == 12
+    assert demo_core.getProperty("Emission", "State") == "1"
+
+
+def test_config_diff(demo_core: pmn.CMMCore) -> None:
+    demo_core.setConfig("Channel", "DAPI")
+    result = demo_core.setConfigDiff("Channel", "FITC")
+    assert demo_core.getCurrentConfig("Channel") == "FITC"
+    assert result["issued"] == 3  # the shutter is the same for both channels
+    assert result["skipped"] == 1
+    assert set(result["device_ms"]) == {"Dichroic", "Emission", "Excitation"}
+    assert result["total_ms"] >= 0
+
+    result = demo_core.setConfigDiff("Channel", "FITC")
+    assert (result["issued"], result["skipped"]) == (0, 4)
+
+    demo_core.updateSystemStateCache()
+    result = demo_core.setSystemStateDiff(demo_core.getSystemStateCache())
+    assert result["issued"] == 0
+
+    conf = pmn.Configuration()
+    conf.addSetting(pmn.PropertySetting("Camera", "Binning", "3"))
+    conf.addSetting(pmn.PropertySetting("Objective", "State", "1"))
+    with pytest.raises(pmn.CMMError, match="Camera-Binning"):
+        demo_core.setSystemStateDiff(conf)
+    assert demo_core.getProperty("Objective", "State") == "1"
+
+    # Core settings are applied after the device settings, and retried like them
+    demo_core.setConfig("Channel", "DAPI")
+    result = demo_core.setConfigDiff("Channel-Multiband", "FITC")
+    assert demo_core.getShutterDevice() == "LED Shutter"
+    assert "Core" in result["device_ms"]
+    conf = pmn.Configuration()
+    conf.addSetting(pmn.PropertySetting("Core", "Shutter", "NoSuchShutter"))
+    conf.addSetting(pmn.PropertySetting("Objective", "State", "2"))
+    with pytest.raises(pmn.CMMError, match="Core-Shutter"):
+        demo_core.setSystemStateDiff(conf)
+    assert demo_core.getProperty("Objective", "State") == "2"
+    assert demo_core.getShutterDevice() == "LED Shutter"
+
+
+def test_system_state_versions(demo_core: pmn.CMMCore) -> None:
+    version, state = demo_core.getSystemStateDict()
+    assert version >= 1
+    cache = demo_core.getSystemStateCache()
+    assert sum(len(props) for props in state.values()) == cache.size()
+    assert (
+        state["Camera"]["Binning"]
+        == cache.getSetting("Camera", "Binning").getPropertyValue()
+    )
+
+    # nothing changed: same version, no changes
+    assert demo_core.getSystemStateVersion() == version
+    assert demo_core.getSystemStateChanges(version) == (version, [])
+
+    demo_core.setProperty("Camera", "Binning", "2")
+    new_version, changes = demo_core.getSystemStateChanges(version)
+    assert new_version == version + 1
+    assert ("Camera", "Binning", "2") in changes
+    assert demo_core.getSystemStateChanges(new_version) == (new_version, [])
+
+    # the whole cache from version 0
+    _, everything = demo_core.getSystemStateChanges(0)
+    assert len(everything) == cache.size()
+
+
+def test_property_handle(demo_core: pmn.CMMCore) -> None:
+    exposure = pmn.PropertyHandle(demo_core, "Camera", "Exposure")
+    assert (exposure.label, exposure.property_name) == ("Camera", "Exposure")
+    assert exposure.type == pmn.PropertyType.Float
+    assert not exposure.read_only
+    exposure.set(12.5)
+    assert exposure.get() == 12.5
+    assert isinstance(exposure.get(), float)
+    assert exposure.get_cached() == 12.5
+    assert demo_core.getExposure() == 12.5
+
+    state = pmn.PropertyHandle(demo_core, "Objective", "State")
+    assert state.type == pmn.PropertyType.Integer
+    state.set(2)
+    assert state.get() == 2
+    assert isinstance(state.get(), int)
+    with pytest.raises(TypeError):
+        state.set("two")
+
+    read_only = next(
+        p
+        for p in demo_core.getDevicePropertyNames("Camera")
+        if demo_core.isPropertyReadOnly("Camera", p)
+    )
+    handle = pmn.PropertyHandle(demo_core, "Camera", read_only)
+    assert handle.read_only
+    with pytest.raises(ValueError, match="read-only"):
+        handle.set("x")
+
+    with pytest.raises(ValueError, match="No property"):
+        pmn.PropertyHandle(demo_core, "Camera", "NotAProperty")
+
+    demo_core.unloadDevice("Objective")
+    assert not state.valid
+    assert exposure.valid
+    with pytest.raises(RuntimeError, match="no longer valid"):
+        state.get()
+    demo_core.loadDevice("Objective", "DemoCamera", "DObjective")
+    assert not state.valid  # stays invalid for the new device
+    demo_core.reset()
+    assert not exposure.valid
+
+
+def test_frame_grouper(demo_core: pmn.CMMCore) -> None:
+    demo_core.loadDevice("Camera2", "DemoCamera", "DCam")
+    demo_core.loadDevice("Multi Camera", "Utilities", "Multi Camera")
+    demo_core.initializeDevice("Camera2")
+    demo_core.initializeDevice("Multi Camera")
+    demo_core.setProperty("Multi Camera", "Physical Camera 1", "Camera")
+    demo_core.setProperty("Multi Camera", "Physical Camera 2", "Camera2")
+    demo_core.setCameraDevice("Multi Camera")
+    assert demo_core.getNumberOfCameraChannels() == 2
+
+    grouper = pmn.FrameGrouper(demo_core, ["Camera", "Camera2"])
+    assert grouper.n_cameras == 2
+    assert grouper.pop() is None  # no sequence running
+
+    demo_core.startSequenceAcquisition(5, 0, True)
+    sets = []
+    while (item := grouper.pop(wait_ms=-1)) is not None:
+        sets.append(item)
+    assert len(sets) == 5
+    for i, (images, meta) in enumerate(sets):
+        assert images.shape == (
+            2,
+            demo_core.getImageHeight(),
+            demo_core.getImageWidth(),
+        )
+        assert list(meta["ImageNumber"]) == [i, i]
+        assert meta["Camera"] == ["Camera", "Camera2"]
+    stats = grouper.stats()
+    assert (stats["frames"], stats["sets"], stats["pending_sets"]) == (10, 5, 0)
+
+    # frames whose partner never arrives
+    demo_core.setCameraDevice("Camera")
+    partial = pmn.FrameGrouper(demo_core, ["Camera", "Absent"], policy="partial")
+    demo_core.startSequenceAcquisition(3, 0, True)
+    images, meta = partial.pop(wait_ms=-1)
+    assert images.shape[0] == 2
+    assert not images[1].any()
+    assert list(meta["ImageNumber"]) == [0, -1]
+    while partial.pop(wait_ms=-1) is not None:
+        pass
+    stats = partial.stats()
+    assert (stats["partial_sets"], stats["unmatched_frames"]) == (3, 3)
+
+    dropped = pmn.FrameGrouper(demo_core, ["Camera", "Absent"])
+    demo_core.startSequenceAcquisition(3, 0, True)
+    assert dropped.pop(wait_ms=-1) is None
+    assert dropped.stats()["dropped_sets"] == 3
+
+    # stats() may be called while another thread pops
+    concurrent = pmn.FrameGrouper(demo_core, ["Camera", "Absent"])
+    demo_core.startSequenceAcquisition(20, 0, True)
+    worker = threading.Thread(target=concurrent.pop, args=(-1,))
+    worker.start()
+    while worker.is_alive():
+        assert concurrent.stats()["frames"] <= 20
+    worker.join()
+    stats = concurrent.stats()
+    assert (stats["frames"], stats["dropped_sets"]) == (20, 20)
+
+    # without a timeout, incomplete sets are capped at max_pending
+    capped = pmn.FrameGrouper(
+        demo_core, ["Camera", "Absent"], timeout_ms=-1, max_pending=4
+    )
+    demo_core.startSequenceAcquisition(10, 0, True)
+    _wait_until(lambda: not demo_core.isSequenceRunning(), timeout=5)
+    assert capped.pop() is None
+    stats = capped.stats()
+    assert (stats["evicted_sets"], stats["dropped_sets"]) == (6, 10)
+
+    with pytest.raises(ValueError, match="policy"):
+        pmn.FrameGrouper(demo_core, ["Camera"], policy="wait")
+    with pytest.raises(ValueError, match="max_pending"):
+        pmn.FrameGrouper(demo_core, ["Camera"], max_pending=0)
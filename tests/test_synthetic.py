@@ -0,0 +1,147 @@
+import time
+from pathlib import Path
+
+import numpy as np
+import pytest
+
+import pymmcore_nano as pmn
+
+
+def _pattern(shape: tuple[int, int], n: int) -> np.ndarray:
+    y, x = np.indices(shape)
+    return (x + y + n) % 256
+
+
+def _wait_for_sequence(core: pmn.CMMCore, timeout: float = 5) -> None:
+    deadline = time.perf_counter() + timeout
+    while core.isSequenceRunning():
+        assert time.perf_counter() < deadline, "sequence did not finish"
+        time.sleep(0.01)
+
+
+def test_synthetic_snap(synthetic_core: pmn.CMMCore) -> None:
+    core = synthetic_core
+    assert core.getCameraDevice() == "Camera"
+    assert core.getDeviceLibrary("Camera") == pmn.SYNTHETIC_ADAPTER
+    assert core.getDeviceName("Camera") == pmn.SYNTHETIC_CAMERA
+    core.setProperty("Camera", "Width", 64)
+    core.setProperty("Camera", "Height", 48)
+
+    core.snapImage()
+    img = core.getImage()
+    assert img.shape == (48, 64)
+    assert img.dtype == np.uint16
+    np.testing.assert_array_equal(img, _pattern((48, 64), 0))
+    core.snapImage()
+    np.testing.assert_array_equal(core.getImage(), _pattern((48, 64), 1))
+
+    core.setProperty("Camera", "PixelType", "8bit")
+    core.setROI(8, 4, 16, 10)
+    core.snapImage()
+    img = core.getImage()
+    assert (img.dtype, img.shape) == (np.uint8, (10, 16))
+    np.testing.assert_array_equal(img, (_pattern((10, 16), 2) + 12) % 256)
+
+    core.clearROI()
+    core.setProperty("Camera", "PixelType", "32bitRGB")
+    core.snapImage()
+    img = core.getImage()
+    assert img.shape == (48, 64, 4)
+    np.testing.assert_array_equal(img[..., 0], _pattern((48, 64), 3))
+
+
+def test_synthetic_sequence(synthetic_core: pmn.CMMCore) -> None:
+    core = synthetic_core
+    core.setProperty("Camera", "Width", 32)
+    core.setProperty("Camera", "Height", 32)
+    core.setProperty("Camera", "FrameRateHz", 5000)
+
+    core.startSequenceAcquisition(500, 0, True)
+    _wait_for_sequence(core)
+    assert core.getRemainingImageCount() == 500
+    frames, md = core.popNextImages(500)
+    np.testing.assert_array_equal(md["ImageNumber"], np.arange(500))
+    np.testing.assert_allclose(md["ElapsedTime-ms"], np.arange(500) * 0.2, atol=1e-6)
+    for n in (0, 1, 255, 499):
+        np.testing.assert_array_equal(frames[n], _pattern((32, 32), n))
+
+
+def test_synthetic_replay(synthetic_core: pmn.CMMCore, tmp_path: Path) -> None:
+    core = synthetic_core
+    core.setProperty("Camera", "Width", 40)
+    core.setProperty("Camera", "Height", 30)
+    core.setProperty("Camera", "FrameRateHz", 1000)
+
+    path = tmp_path / "run.raw"
+    writer = pmn.StreamWriter(core, path, chunk_bytes=1 << 16, metadata=False)
+    writer.start()
+    core.startSequenceAcquisition(50, 0, True)
+    _wait_for_sequence(core)
+    writer.stop()
+    assert writer.frames_written == 50
+    recorded = np.memmap(path, "<u2", "r", offset=4096, shape=(50, 30, 40))
+    index = np.fromfile(f"{path}.idx", [("image_number", "<i8"), ("elapsed_ms", "<f8")])
+
+    # the replay takes over the recorded format and timing
+    core.setProperty("Camera", "Width", 8)
+    core.setProperty("Camera", "ReplayFile", str(path))
+    assert core.getImageWidth() == 40
+    with pytest.raises(pmn.CMMError):
+        core.setProperty("Camera", "Width", 8)
+
+    core.startSequenceAcquisition(1000, 0, True)  # stops at the end of the recording
+    _wait_for_sequence(core)
+    frames, md = core.popNextImages(core.getRemainingImageCount())
+    np.testing.assert_array_equal(frames, recorded)
+    expected = index["elapsed_ms"] - index["elapsed_ms"][0]
+    np.testing.assert_allclose(md["ElapsedTime-ms"], expected, atol=1e-3)
+
+    core.setProperty("Camera", "ReplayLoop", "Yes")
+    core.startSequenceAcquisition(120, 0, True)
+    _wait_for_sequence(core)
+    frames, _ = core.popNextImages(120)
+    np.testing.assert_array_equal(frames[100:], recorded[:20])
+
+    with pytest.raises(pmn.CMMError):
+        core.setProperty("Camera", "ReplayFile", str(tmp_path / "missing.raw"))
+    core.setProperty("Camera", "ReplayFile", "")
+    core.snapImage()
+    assert core.getImage().shape == (30, 40)
+
+
+def test_synthetic_replay_single_frame(
+    synthetic_core: pmn.CMMCore, tmp_path: Path
+) -> None:
+    core = synthetic_core
+    core.setProperty("Camera", "FrameRateHz", 1000)
+    path = tmp_path / "one.raw"
+    writer = pmn.StreamWriter(core, path, metadata=False)
+    writer.start()
+    core.startSequenceAcquisition(1, 0, True)
+    _wait_for_sequence(core)
+    writer.stop()
+    assert writer.frames_written == 1
+
+    # a one-frame recording loops at the frame interval instead of all at once
+    core.setProperty("Camera", "ReplayFile", str(path))
+    core.setProperty("Camera", "ReplayLoop", "Yes")
+    core.startSequenceAcquisition(20, 0, True)
+    _wait_for_sequence(core)
+    _, md = core.popNextImages(20)
+    np.testing.assert_allclose(md["ElapsedTime-ms"], np.arange(20), atol=1e-6)
+
+
+def test_synthetic_snap_exposure(synthetic_core: pmn.CMMCore) -> None:
+    core = synthetic_core
+    core.setExposure(50)
+    t0 = time.perf_counter()
+    core.snapImage()
+    assert time.perf_counter() - t0 >= 0.05
+
+
+def test_native_benchmarks(synthetic_core: pmn.CMMCore) -> None:
+    bench = pmn._benchmarks
+    assert bench.get_dtype_shape(100) > 0
+    assert bench.create_image_array(synthetic_core, 100) > 0
+    assert bench.create_metadata_array(synthetic_core, 100) > 0
+    assert bench.metadata_copy(synthetic_core, 8, 100) > 0